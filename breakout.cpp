@@ -1,4 +1,7 @@
 #define GL_SILENCE_DEPRECATION // For macOS compatibility if needed
+#ifdef BREAKOUT_VULKAN
+#include <vulkan/vulkan.h> // Avant GLFW, qui déclare alors glfwCreateWindowSurface
+#endif
 #include <GLFW/glfw3.h>
 #include <vector>
 #include <cmath>
@@ -8,17 +11,70 @@
 #include <stdexcept>
 #include <string>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <chrono>
+#include <type_traits>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#ifdef __linux__
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <netinet/tcp.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 // --- Dear ImGui Headers ---
 #include "imgui/imgui.h"                       // Main ImGui header
 #include "imgui/backends/imgui_impl_glfw.h"    // GLFW backend
 #include "imgui/backends/imgui_impl_opengl2.h" // OpenGL 2 backend
+#ifdef BREAKOUT_VULKAN
+#include <cstddef>
+#include "imgui/backends/imgui_impl_vulkan.h" // Vulkan backend
+#endif
+// stb_truetype (fourni avec ImGui) : génération de l'atlas SDF du HUD
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function" // Seules les fonctions SDF sont utilisées
+#endif
+#include "imgui/imstb_truetype.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
 
 // === Compilation manuelle === (Si la compilation CMAKE est impossible)
 // MACOSX:
-// g++ -std=c++11 breakout.cpp imgui/imgui.cpp imgui/imgui_draw.cpp imgui/imgui_tables.cpp imgui/imgui_widgets.cpp imgui/backends/imgui_impl_glfw.cpp imgui/backends/imgui_impl_opengl2.cpp -o breakout -lglfw -framework OpenGL -framework Cocoa -framework IOKit -framework CoreVideo
+// g++ -std=c++17 breakout.cpp imgui/imgui.cpp imgui/imgui_draw.cpp imgui/imgui_tables.cpp imgui/imgui_widgets.cpp imgui/backends/imgui_impl_glfw.cpp imgui/backends/imgui_impl_opengl2.cpp -o breakout -lglfw -framework OpenGL -framework Cocoa -framework IOKit -framework CoreVideo
 //
 // LINUX:
-// g++ -std=c++11 breakout.cpp imgui/imgui.cpp imgui/imgui_draw.cpp imgui/imgui_tables.cpp imgui/imgui_widgets.cpp imgui/backends/imgui_impl_glfw.cpp imgui/backends/imgui_impl_opengl2.cpp -o breakout -lglfw -lGL -lX11 -lpthread -lXrandr -lXi -ldl -lm
+// g++ -std=c++17 breakout.cpp imgui/imgui.cpp imgui/imgui_draw.cpp imgui/imgui_tables.cpp imgui/imgui_widgets.cpp imgui/backends/imgui_impl_glfw.cpp imgui/backends/imgui_impl_opengl2.cpp -o breakout -lglfw -lGL -lX11 -lpthread -lXrandr -lXi -ldl -lm
 // (Make sure necessary -dev packages like libglfw3-dev, libgl1-mesa-dev, xorg-dev are installed)
 
 //-----------------------------------------------------------------------------
@@ -28,6 +84,11 @@ constexpr int WINDOW_WIDTH = 960;
 
 constexpr int WINDOW_HEIGHT = 540;
 const char *WINDOW_TITLE = "Breakout C++";
+const char *QUICKSAVE_PATH = "breakout.sav";
+constexpr float OFFSCREEN_TIME_STEP = 1.0f / 60.0f;
+constexpr float HUD_TEXT_SIZE = 13.0f; // Taille de la police par défaut d'ImGui
+constexpr float HUD_TITLE_SCALE = 3.0f; // "GAME OVER"
+constexpr float REFRESH_SNAP_TOLERANCE = 0.1f; // Écart toléré (fraction de période) pour caler dt sur la V-Sync
 
 constexpr int BRICK_ROWS = 8;
 constexpr int BRICKS_PER_ROW = 14;
@@ -35,6 +96,7 @@ constexpr float BRICK_GRID_WIDTH = 1.85f; // Slightly reduce grid width for marg
 constexpr float BRICK_START_Y = 0.85f; // Start bricks a bit lower
 constexpr float BRICK_HEIGHT = 0.06f;
 constexpr float BRICK_GAP = 0.01f;
+constexpr float LEVEL_AREA_HEIGHT = 1.0f; // Hauteur maximale occupée par les rangées de briques
 
 constexpr float PADDLE_WIDTH = 0.25f;
 constexpr float PADDLE_HEIGHT = 0.04f;
@@ -55,14 +117,14 @@ constexpr float BASE_SPEED = 1.0f;
 struct Vec2 {
     Vec2() = default;
 
-    Vec2(float x_val, float y_val) : x(x_val), y(y_val) {
+    constexpr Vec2(float x_val, float y_val) : x(x_val), y(y_val) {
     };
     float x = 0.0f;
     float y = 0.0f;
 };
 
 struct Color {
-    explicit Color(float r_val = 1.0f, float g_val = 1.0f, float b_val = 1.0f, float a_val = 1.0f)
+    constexpr explicit Color(float r_val = 1.0f, float g_val = 1.0f, float b_val = 1.0f, float a_val = 1.0f)
         : r(r_val), g(g_val), b(b_val), a(a_val) {
     }
 
@@ -84,7 +146,7 @@ enum class BrickColor {
     BALL // Couleur de la balle
 };
 
-Color getColorFromEnum(BrickColor colorType, bool isDarker = false, float alpha = 1.0f) {
+constexpr Color getColorFromEnum(BrickColor colorType, bool isDarker = false, float alpha = 1.0f) {
     Color result;
 
     switch (colorType) {
@@ -132,7 +194,7 @@ struct GameObject {
     Vec2 position;
     Vec2 size;
     Color color;
-    BrickColor colorType;
+    BrickColor colorType = BrickColor::WHITE;
 };
 
 struct Paddle : public GameObject {
@@ -157,6 +219,8 @@ struct Block : public GameObject {
     bool isReflective = false; // Pour les briques à rétroréflexion
     bool isBonus = false; // Pour les briques bonus
     int bonusType = 0; // Type de bonus
+    int row = 0; // Position dans la grille du niveau
+    int column = 0;
 };
 //-----------------------------------------------------------------------------
 // Game State Enum
@@ -164,7 +228,8 @@ struct Block : public GameObject {
 enum class GameState {
     MENU,
     PLAYING,
-    GAME_OVER
+    GAME_OVER,
+    EDITOR
 };
 
 // Constantes pour les types de bonus
@@ -179,6 +244,10 @@ enum BonusType {
     BALL_ANGLE = 7
 };
 
+constexpr bool isBonusType(int type) {
+    return type >= LIFE_ADD && type <= BALL_ANGLE;
+}
+
 // Structure pour un bonus qui tombe
 struct FallingBonus {
     Vec2 position;
@@ -189,15 +258,8677 @@ struct FallingBonus {
     bool active = true;
 };
 
+//-----------------------------------------------------------------------------
+// Serialization
+//-----------------------------------------------------------------------------
+// Description des champs à la compilation : chaque structure sérialisable liste ses champs
+// une seule fois (macro *_FIELDS), avec la version du format dans laquelle le champ est apparu.
+// Le format binaire est little-endian et "packé" (champs dans l'ordre de la liste, sans padding).
+// Pour chaque version on construit un plan de copie : les champs contigus en mémoire ET dans le
+// flux sont fusionnés en "runs" copiés par un seul memcpy. Quand le plan couvre tout l'objet
+// (aucun padding), un tableau complet est copié d'un bloc.
+// Évolution du schéma : un flux d'une version antérieure est relu avec le plan de sa version,
+// les champs plus récents gardent leur valeur par défaut.
+// Les flux viennent de fichiers et du réseau : chaque booléen et chaque enum est vérifié dans
+// le flux avant la copie (EnumRange donne les valeurs admises), un octet hors plage rejette le flux.
+// NB : suppose un hôte little-endian (x86, ARM), comme toutes les plateformes visées.
+// Historique : 1 = format initial ; 2 = position des briques dans la grille, dimensions du niveau.
+constexpr uint16_t STATE_SCHEMA_VERSION = 2;
+constexpr uint32_t STATE_MAGIC = 0x54534B42; // "BKST"
+
+template<typename T>
+struct Schema; // Spécialisé par BREAKOUT_SCHEMA
+
+template<typename E>
+struct EnumRange; // Valeurs admises d'un enum sérialisé, spécialisé à côté de son schéma
+
+#define BREAKOUT_SCHEMA_FIELD(since, name) v.field(since, obj.name);
+#define BREAKOUT_SCHEMA(Type, FIELDS) \
+    template<> \
+    struct Schema<Type> { \
+        template<typename V, typename T> \
+        static void visit(V &v, T &obj) { FIELDS(BREAKOUT_SCHEMA_FIELD) } \
+    };
+
+#define VEC2_FIELDS(F) F(1, x) F(1, y)
+#define COLOR_FIELDS(F) F(1, r) F(1, g) F(1, b) F(1, a)
+#define GAME_OBJECT_FIELDS(F) F(1, position) F(1, size) F(1, color) F(1, colorType)
+#define PADDLE_FIELDS(F) GAME_OBJECT_FIELDS(F) \
+    F(1, firstContactRed) F(1, firstContactOrange) F(1, speed) F(1, isShrunk)
+#define BALL_FIELDS(F) GAME_OBJECT_FIELDS(F) \
+    F(1, velocity) F(1, speedMagnitude) F(1, stuckToPaddle) F(1, hitCount)
+#define BLOCK_FIELDS(F) GAME_OBJECT_FIELDS(F) \
+    F(1, active) F(1, points) F(1, hitCounter) F(1, isWall) F(1, isReflective) F(1, isBonus) F(1, bonusType) \
+    F(2, row) F(2, column)
+#define FALLING_BONUS_FIELDS(F) \
+    F(1, position) F(1, size) F(1, color) F(1, type) F(1, fallSpeed) F(1, active)
+
+template<>
+struct EnumRange<BrickColor> {
+    static constexpr int64_t min = static_cast<int64_t>(BrickColor::RED);
+    static constexpr int64_t max = static_cast<int64_t>(BrickColor::BALL);
+};
+
+BREAKOUT_SCHEMA(Vec2, VEC2_FIELDS)
+BREAKOUT_SCHEMA(Color, COLOR_FIELDS)
+BREAKOUT_SCHEMA(Paddle, PADDLE_FIELDS)
+BREAKOUT_SCHEMA(Ball, BALL_FIELDS)
+BREAKOUT_SCHEMA(Block, BLOCK_FIELDS)
+BREAKOUT_SCHEMA(FallingBonus, FALLING_BONUS_FIELDS)
+
+// Compteurs de la partie (score, vies, niveau) regroupés pour la sérialisation
+struct GameCounters {
+    int score = 0;
+    int lives = 3;
+    int currentLevel = 1;
+    int levelColumns = BRICKS_PER_ROW;
+    int levelRows = BRICK_ROWS;
+};
+
+#define GAME_COUNTERS_FIELDS(F) F(1, score) F(1, lives) F(1, currentLevel) F(2, levelColumns) F(2, levelRows)
+BREAKOUT_SCHEMA(GameCounters, GAME_COUNTERS_FIELDS)
+
+struct FieldRun {
+    uint32_t memOffset;
+    uint32_t wireOffset;
+    uint32_t size;
+};
+
+// Champ booléen ou enum à vérifier dans le flux avant de le copier
+struct FieldCheck {
+    uint32_t wireOffset;
+    uint32_t size;
+    bool isSigned;
+    int64_t min;
+    int64_t max;
+};
+
+struct RecordPlan {
+    std::vector<FieldRun> runs;
+    std::vector<FieldCheck> checks;
+    uint32_t wireSize = 0;
+    bool identity = false; // Représentation mémoire == représentation du flux
+};
+
+// Visiteur qui aplatit un schéma en champs élémentaires (arithmétiques / enum)
+class PlanBuilder {
+public:
+    PlanBuilder(const char *base, uint16_t version, RecordPlan &plan) : base(base), version(version), plan(plan) {
+    }
+
+    template<typename M>
+    void field(uint16_t since, const M &member) {
+        if (since > version) return;
+        leaf(member, std::integral_constant<bool, std::is_arithmetic<M>::value || std::is_enum<M>::value>());
+    }
+
+private:
+    const char *base;
+    uint16_t version;
+    RecordPlan &plan;
+
+    template<typename M>
+    void leaf(const M &member, std::true_type) {
+        const auto memOffset = static_cast<uint32_t>(reinterpret_cast<const char *>(&member) - base);
+        const auto size = static_cast<uint32_t>(sizeof(M));
+        check<M>(std::is_enum<M>());
+        if (!plan.runs.empty()) {
+            FieldRun &last = plan.runs.back();
+            if (last.memOffset + last.size == memOffset) {
+                last.size += size; // Fusion avec le run précédent
+                plan.wireSize += size;
+                return;
+            }
+        }
+        plan.runs.push_back(FieldRun{memOffset, plan.wireSize, size});
+        plan.wireSize += size;
+    }
+
+    template<typename M>
+    void leaf(const M &member, std::false_type) {
+        Schema<M>::visit(*this, member);
+    }
+
+    // Appelé avant l'ajout du champ : plan.wireSize est alors son décalage dans le flux
+    template<typename M>
+    void check(std::false_type) {
+        if (std::is_same<M, bool>::value) {
+            plan.checks.push_back(FieldCheck{plan.wireSize, 1, false, 0, 1});
+        }
+    }
+
+    template<typename M>
+    void check(std::true_type) {
+        using Underlying = typename std::underlying_type<M>::type;
+        plan.checks.push_back(FieldCheck{plan.wireSize, static_cast<uint32_t>(sizeof(M)),
+                                         std::is_signed<Underlying>::value, EnumRange<M>::min, EnumRange<M>::max});
+    }
+};
+
+template<typename T>
+const RecordPlan &recordPlan(uint16_t version) {
+    static_assert(std::is_trivially_copyable<T>::value, "serialized records must be trivially copyable");
+    static const std::vector<RecordPlan> plans = [] {
+        std::vector<RecordPlan> result(STATE_SCHEMA_VERSION + 1);
+        const T probe = T();
+        for (uint16_t v = 1; v <= STATE_SCHEMA_VERSION; ++v) {
+            PlanBuilder builder(reinterpret_cast<const char *>(&probe), v, result[v]);
+            Schema<T>::visit(builder, probe);
+            result[v].identity = result[v].runs.size() == 1 && result[v].runs[0].memOffset == 0 &&
+                                 result[v].wireSize == sizeof(T);
+        }
+        return result;
+    }();
+    return plans[version];
+}
+
+class StateWriter {
+public:
+    explicit StateWriter(std::vector<uint8_t> &out) : out(out) {
+        writeScalar(STATE_MAGIC);
+        writeScalar(STATE_SCHEMA_VERSION);
+    }
+
+    template<typename T>
+    void writeScalar(T value) {
+        static_assert(std::is_arithmetic<T>::value, "scalar expected");
+        append(&value, sizeof(T));
+    }
+
+    template<typename T>
+    void write(const T &record) {
+        const RecordPlan &plan = recordPlan<T>(STATE_SCHEMA_VERSION);
+        const size_t start = grow(plan.wireSize);
+        encode(plan, reinterpret_cast<const char *>(&record), out.data() + start);
+    }
+
+    template<typename T>
+    void writeArray(const std::vector<T> &records) {
+        const RecordPlan &plan = recordPlan<T>(STATE_SCHEMA_VERSION);
+        writeScalar(static_cast<uint32_t>(records.size()));
+        const size_t start = grow(plan.wireSize * records.size());
+        if (plan.identity) {
+            if (!records.empty()) std::memcpy(out.data() + start, records.data(), plan.wireSize * records.size());
+            return;
+        }
+        uint8_t *dst = out.data() + start;
+        for (const T &record: records) {
+            encode(plan, reinterpret_cast<const char *>(&record), dst);
+            dst += plan.wireSize;
+        }
+    }
+
+private:
+    std::vector<uint8_t> &out;
+
+    size_t grow(size_t bytes) {
+        const size_t start = out.size();
+        out.resize(start + bytes);
+        return start;
+    }
+
+    void append(const void *data, size_t bytes) {
+        const size_t start = grow(bytes);
+        std::memcpy(out.data() + start, data, bytes);
+    }
+
+    static void encode(const RecordPlan &plan, const char *src, uint8_t *dst) {
+        for (const FieldRun &run: plan.runs) {
+            std::memcpy(dst + run.wireOffset, src + run.memOffset, run.size);
+        }
+    }
+};
+
+class StateReader {
+public:
+    StateReader(const uint8_t *data, size_t size) : data(data), size(size) {
+        if (readScalar<uint32_t>() != STATE_MAGIC) {
+            throw std::runtime_error("Invalid state stream (bad magic)");
+        }
+        streamVersion = readScalar<uint16_t>();
+        if (streamVersion == 0 || streamVersion > STATE_SCHEMA_VERSION) {
+            throw std::runtime_error("Unsupported state stream version " + std::to_string(streamVersion));
+        }
+    }
+
+    uint16_t version() const { return streamVersion; }
+
+    template<typename T>
+    T readScalar() {
+        static_assert(std::is_arithmetic<T>::value, "scalar expected");
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Octet 0 ou 1, tout autre valeur rejette le flux
+    bool readBool() {
+        const auto value = readScalar<uint8_t>();
+        requireInRange(value <= 1);
+        return value != 0;
+    }
+
+    // Pour les champs dont la plage dépend du jeu (types de bonus...), vérifiés après lecture
+    static void requireInRange(bool valid) {
+        if (!valid) {
+            throw std::runtime_error("Invalid state stream (field out of range)");
+        }
+    }
+
+    template<typename T>
+    void read(T &record) {
+        const RecordPlan &plan = recordPlan<T>(streamVersion);
+        const uint8_t *src = take(plan.wireSize);
+        validate(plan, src, 1);
+        record = T();
+        decode(plan, src, reinterpret_cast<char *>(&record));
+    }
+
+    template<typename T>
+    void readArray(std::vector<T> &records) {
+        const RecordPlan &plan = recordPlan<T>(streamVersion);
+        const auto count = readScalar<uint32_t>();
+        const uint8_t *src = take(static_cast<size_t>(plan.wireSize) * count);
+        validate(plan, src, count);
+        if (plan.identity) {
+            records.resize(count);
+            if (count > 0) std::memcpy(records.data(), src, static_cast<size_t>(plan.wireSize) * count);
+            return;
+        }
+        records.assign(count, T());
+        for (T &record: records) {
+            decode(plan, src, reinterpret_cast<char *>(&record));
+            src += plan.wireSize;
+        }
+    }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t cursor = 0;
+    uint16_t streamVersion = 0;
+
+    const uint8_t *take(size_t bytes) {
+        if (bytes > size - cursor) {
+            throw std::runtime_error("Truncated state stream");
+        }
+        const uint8_t *p = data + cursor;
+        cursor += bytes;
+        return p;
+    }
+
+    static void decode(const RecordPlan &plan, const uint8_t *src, char *dst) {
+        for (const FieldRun &run: plan.runs) {
+            std::memcpy(dst + run.memOffset, src + run.wireOffset, run.size);
+        }
+    }
+
+    static int64_t fieldValue(const FieldCheck &check, const uint8_t *p) {
+        switch (check.size) {
+            case 1: return check.isSigned ? static_cast<int8_t>(p[0]) : p[0];
+            case 2: {
+                uint16_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return check.isSigned ? static_cast<int16_t>(value) : value;
+            }
+            case 4: {
+                uint32_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return check.isSigned ? static_cast<int32_t>(value) : static_cast<int64_t>(value);
+            }
+            default: {
+                int64_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            }
+        }
+    }
+
+    // Vérifie les booléens et enums de count enregistrements consécutifs du flux, avant toute copie
+    static void validate(const RecordPlan &plan, const uint8_t *src, uint32_t count) {
+        if (plan.checks.empty()) return;
+        for (uint32_t i = 0; i < count; ++i, src += plan.wireSize) {
+            for (const FieldCheck &check: plan.checks) {
+                const int64_t value = fieldValue(check, src + check.wireOffset);
+                requireInRange(value >= check.min && value <= check.max);
+            }
+        }
+    }
+};
+
+// Mesure du débit d'encodage / décodage (--bench-serialize)
+template<typename T>
+void benchmarkRecordArray(const char *name, const std::vector<T> &records, int iterations) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<uint8_t> buffer;
+    buffer.reserve(16 + sizeof(T) * records.size());
+    std::vector<T> decoded;
+    decoded.reserve(records.size());
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        buffer.clear();
+        StateWriter writer(buffer);
+        writer.writeArray(records);
+    }
+    const double encodeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        StateReader reader(buffer.data(), buffer.size());
+        reader.readArray(decoded);
+    }
+    const double decodeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const RecordPlan &plan = recordPlan<T>(STATE_SCHEMA_VERSION);
+    const double bytes = static_cast<double>(buffer.size()) * iterations;
+    std::cout << name << ": " << records.size() << " records, " << plan.wireSize << " B/record (sizeof "
+            << sizeof(T) << "), " << plan.runs.size() << " run(s)" << (plan.identity ? " [bulk memcpy]" : "")
+            << "  encode " << bytes / encodeSeconds / 1e9 << " GB/s"
+            << "  decode " << bytes / decodeSeconds / 1e9 << " GB/s" << std::endl;
+}
+
+void runSerializationBenchmark() {
+    constexpr size_t RECORD_COUNT = 1 << 20;
+    constexpr int ITERATIONS = 20;
+
+    std::vector<Block> blocks(RECORD_COUNT);
+    std::vector<FallingBonus> bonuses(RECORD_COUNT);
+    std::vector<Vec2> positions(RECORD_COUNT);
+    for (size_t i = 0; i < RECORD_COUNT; ++i) {
+        blocks[i].position = Vec2{static_cast<float>(i), static_cast<float>(i % 14)};
+        blocks[i].hitCounter = static_cast<int>(i % 3);
+        bonuses[i].type = static_cast<int>(i % 8);
+        positions[i] = Vec2{static_cast<float>(i), -static_cast<float>(i)};
+    }
+
+    benchmarkRecordArray("Block", blocks, ITERATIONS);
+    benchmarkRecordArray("FallingBonus", bonuses, ITERATIONS);
+    benchmarkRecordArray("Vec2", positions, ITERATIONS);
+}
+
+//-----------------------------------------------------------------------------
+// Runtime Options
+//-----------------------------------------------------------------------------
+// Présentation : fenêtre, plein écran sans bordure (mode vidéo du bureau conservé) ou
+// plein écran exclusif (mode natif au taux de rafraîchissement le plus élevé)
+enum class DisplayMode { WINDOWED, BORDERLESS, FULLSCREEN };
+
+const char *displayModeName(DisplayMode mode) {
+    switch (mode) {
+        case DisplayMode::BORDERLESS: return "borderless";
+        case DisplayMode::FULLSCREEN: return "fullscreen";
+        default: return "windowed";
+    }
+}
+
+// Mode de présentation du rendu Vulkan (--present=...)
+enum class PresentMode {
+    FIFO, // V-Sync, toujours disponible
+    FIFO_RELAXED, // V-Sync, mais une frame en retard est affichée sans attendre
+    MAILBOX, // Dernière image prête affichée au rafraîchissement, sans bloquer le jeu
+    IMMEDIATE // Sans synchronisation (déchirures possibles), latence minimale
+};
+
+const char *presentModeName(PresentMode mode) {
+    switch (mode) {
+        case PresentMode::FIFO_RELAXED: return "relaxed";
+        case PresentMode::MAILBOX: return "mailbox";
+        case PresentMode::IMMEDIATE: return "immediate";
+        default: return "fifo";
+    }
+}
+
+// Exécutant des commandes de dessin du rendu OpenGL (--backend=..., voir Render Backends)
+enum class RenderBackendType { GL2, GL, SOFTWARE, NONE };
+
+const char *renderBackendName(RenderBackendType type) {
+    switch (type) {
+        case RenderBackendType::GL2: return "gl2";
+        case RenderBackendType::SOFTWARE: return "soft";
+        case RenderBackendType::NONE: return "null";
+        default: return "gl";
+    }
+}
+
+// Placement des threads de simulation en lot sur les noeuds NUMA (--numa=..., voir Batch Runner)
+enum class NumaMode { OFF, LOCAL, STEAL };
+
+const char *numaModeName(NumaMode mode) {
+    switch (mode) {
+        case NumaMode::OFF: return "off";
+        case NumaMode::STEAL: return "steal";
+        default: return "local";
+    }
+}
+
+// Encodage du flux d'événements de gameplay (--events-format=..., voir Event Stream)
+enum class EventFormat { NDJSON, BINARY };
+
+const char *eventFormatName(EventFormat format) {
+    return format == EventFormat::BINARY ? "binary" : "ndjson";
+}
+
+struct RuntimeOptions {
+    bool lowJitter = false; // --low-jitter : priorité temps réel, affinité CPU, mémoire verrouillée
+    int cpu = -1; // --cpu=N : coeur sur lequel épingler le thread principal (boucle + rendu)
+    bool benchSerialize = false; // --bench-serialize : mesure du débit de sérialisation puis sortie
+    int gridGames = 0; // --grid=N : vue en grille de N parties pilotées automatiquement
+    bool offscreen = false; // --offscreen : contexte sans affichage, rendu dans un FBO
+    DisplayMode displayMode = DisplayMode::WINDOWED; // --fullscreen[=N] / --borderless[=N]
+    int monitorIndex = 0; // N : index du moniteur (0 = principal)
+    int frameLimit = 0; // --frames=N : quitter après N frames (0 = illimité)
+    std::string dumpPath; // --dump=fichier.ppm : capture de la dernière frame (mode offscreen)
+    std::string levelPath; // --level=fichier.lvl : niveau personnalisé
+    int generateCount = 0; // --generate=N : générer et valider N niveaux puis sortir
+    uint64_t seed = 1; // --seed=S : graine du premier niveau généré
+    int threads = 0; // --threads=N : threads de simulation (0 = tous les coeurs)
+    NumaMode numa = NumaMode::LOCAL; // --numa=local|steal|off : threads épinglés par noeud, vol de tâches
+    int generateKeep = 20; // --keep=K : niveaux .lvl écrits
+    bool balance = false; // --balance[=spec] : balayage Monte Carlo des réglages puis sortie
+    std::string balanceSpec; // Grille de paramètres (vide = grille par défaut)
+    int balanceGames = 400; // --games=N : parties par réglage (réparties entre les niveaux d'autopilote, arrondi au multiple supérieur)
+    std::string versus; // --versus=loopback | --versus=PORT_LOCAL,HOTE:PORT : partie à deux en UDP
+    int player = 0; // --player=0|1 : plateau contrôlé localement (versus UDP)
+    int inputDelay = 2; // --input-delay=N : frames de délai de l'entrée locale
+    int latencyMs = 50; // --latency=MS : latence simulée du lien loopback
+    float lossRate = 0.05f; // --loss=P : taux de perte simulé du lien loopback
+    std::string broadcastPath; // --broadcast=chemin : diffuser la partie aux spectateurs (socket Unix)
+    std::string spectatePath; // --spectate=chemin : regarder une partie diffusée
+    bool benchBroadcast = false; // --bench-broadcast : coût de diffusion selon le nombre de spectateurs
+    int serverPort = 0; // --server=PORT : serveur de parties sans affichage
+    int loadClients = 0; // --load=N : générateur de charge (N clients)
+    std::string connectAddress = "127.0.0.1:7100"; // --connect=HOTE:PORT : serveur visé par --load
+    int durationSeconds = 10; // --duration=S : durée du test de charge
+    bool benchSync = false; // --bench-sync : taille et coût du codec de synchronisation
+    std::string recordPath; // --record=fichier.rpl : enregistrer les parties jouées
+    std::string makeReplayPath; // --make-replay=fichier.rpl : partie autopilotée enregistrée, puis sortie
+    std::string verifyReplayPath; // --verify-replay=fichier.rpl : rejouer et comparer les empreintes
+    bool checkDeterminism = false; // --check-determinism : mêmes empreintes quel que soit le nombre de threads
+    bool imguiHud = false; // --imgui-hud : HUD dessiné par ImGui (comparaison avec le HUD rapide)
+    std::string postChain; // --post=bloom[:2|:4],crt : passes de post-traitement, dans l'ordre
+    float postBudgetMs = 2.0f; // --post-budget=MS : coût GPU maximal de la chaîne
+    std::string scoresPath = "highscores.dat"; // --scores=fichier : stockage des meilleurs scores
+    bool benchScores = false; // --bench-scores : coût d'insertion et de rang sur 1 million de scores
+    bool vulkan = false; // --renderer=vulkan : rendu Vulkan (compilé avec -DBREAKOUT_VULKAN=ON)
+    PresentMode presentMode = PresentMode::FIFO; // --present=fifo|relaxed|mailbox|immediate
+    int framesInFlight = 2; // --frames-in-flight=N : frames préparées d'avance par le CPU (1 à 3)
+    RenderBackendType backend = RenderBackendType::GL; // --backend=gl2|gl|soft|null
+    bool benchRender = false; // --bench-render : coût CPU d'une frame (simulation, commandes, tri) puis sortie
+    bool benchBricks = false; // --bench-bricks : rangement ligne / Morton sur un niveau de 1M briques
+    float rewindSeconds = 30.0f; // --rewind=S : historique de rembobinage (fenêtre de debug), 0 = désactivé
+    bool benchRewind = false; // --bench-rewind : coût d'enregistrement et de restauration de l'historique
+    std::string eventsPath; // --events=chemin : flux des événements de gameplay (socket Unix ou fichier)
+    EventFormat eventFormat = EventFormat::NDJSON; // --events-format=ndjson|binary
+    bool benchEvents = false; // --bench-events : coût de publication, consommateur lent
+    std::string outPrefix; // --out=prefixe : fichiers de résultats de --generate / --balance
+};
+
+RuntimeOptions parseRuntimeOptions(int argc, char **argv) {
+    RuntimeOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--low-jitter") {
+            options.lowJitter = true;
+        } else if (arg.compare(0, 6, "--cpu=") == 0) {
+            options.cpu = std::atoi(arg.c_str() + 6);
+        } else if (arg == "--bench-serialize") {
+            options.benchSerialize = true;
+        } else if (arg.compare(0, 7, "--grid=") == 0) {
+            options.gridGames = std::max(0, std::atoi(arg.c_str() + 7));
+        } else if (arg == "--offscreen") {
+            options.offscreen = true;
+        } else if (arg.compare(0, 9, "--frames=") == 0) {
+            options.frameLimit = std::atoi(arg.c_str() + 9);
+        } else if (arg.compare(0, 7, "--dump=") == 0) {
+            options.dumpPath = arg.substr(7);
+        } else if (arg.compare(0, 8, "--level=") == 0) {
+            options.levelPath = arg.substr(8);
+        } else if (arg.compare(0, 11, "--generate=") == 0) {
+            options.generateCount = std::max(0, std::atoi(arg.c_str() + 11));
+        } else if (arg.compare(0, 7, "--seed=") == 0) {
+            options.seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+        } else if (arg.compare(0, 10, "--threads=") == 0) {
+            options.threads = std::max(0, std::atoi(arg.c_str() + 10));
+        } else if (arg.compare(0, 7, "--numa=") == 0) {
+            const std::string name = arg.substr(7);
+            bool known = false;
+            for (NumaMode candidate: {NumaMode::OFF, NumaMode::LOCAL, NumaMode::STEAL}) {
+                if (name == numaModeName(candidate)) {
+                    options.numa = candidate;
+                    known = true;
+                }
+            }
+            if (!known) {
+                throw std::runtime_error("Invalid --numa value (expected local, steal or off): " + name);
+            }
+        } else if (arg.compare(0, 7, "--keep=") == 0) {
+            options.generateKeep = std::max(0, std::atoi(arg.c_str() + 7));
+        } else if (arg == "--balance") {
+            options.balance = true;
+        } else if (arg.compare(0, 10, "--balance=") == 0) {
+            options.balance = true;
+            options.balanceSpec = arg.substr(10);
+        } else if (arg.compare(0, 8, "--games=") == 0) {
+            options.balanceGames = std::max(1, std::atoi(arg.c_str() + 8));
+        } else if (arg.compare(0, 9, "--versus=") == 0) {
+            options.versus = arg.substr(9);
+        } else if (arg.compare(0, 9, "--player=") == 0) {
+            options.player = std::atoi(arg.c_str() + 9) & 1;
+        } else if (arg.compare(0, 14, "--input-delay=") == 0) {
+            options.inputDelay = std::max(0, std::atoi(arg.c_str() + 14));
+        } else if (arg.compare(0, 10, "--latency=") == 0) {
+            options.latencyMs = std::max(0, std::atoi(arg.c_str() + 10));
+        } else if (arg.compare(0, 7, "--loss=") == 0) {
+            options.lossRate = static_cast<float>(std::atof(arg.c_str() + 7));
+        } else if (arg.compare(0, 12, "--broadcast=") == 0) {
+            options.broadcastPath = arg.substr(12);
+        } else if (arg.compare(0, 11, "--spectate=") == 0) {
+            options.spectatePath = arg.substr(11);
+        } else if (arg == "--bench-broadcast") {
+            options.benchBroadcast = true;
+        } else if (arg.compare(0, 9, "--server=") == 0) {
+            options.serverPort = std::atoi(arg.c_str() + 9);
+        } else if (arg.compare(0, 7, "--load=") == 0) {
+            options.loadClients = std::max(0, std::atoi(arg.c_str() + 7));
+        } else if (arg.compare(0, 10, "--connect=") == 0) {
+            options.connectAddress = arg.substr(10);
+        } else if (arg.compare(0, 11, "--duration=") == 0) {
+            options.durationSeconds = std::max(1, std::atoi(arg.c_str() + 11));
+        } else if (arg == "--bench-sync") {
+            options.benchSync = true;
+        } else if (arg.compare(0, 9, "--record=") == 0) {
+            options.recordPath = arg.substr(9);
+        } else if (arg.compare(0, 14, "--make-replay=") == 0) {
+            options.makeReplayPath = arg.substr(14);
+        } else if (arg.compare(0, 16, "--verify-replay=") == 0) {
+            options.verifyReplayPath = arg.substr(16);
+        } else if (arg == "--check-determinism") {
+            options.checkDeterminism = true;
+        } else if (arg.compare(0, 12, "--fullscreen") == 0 || arg.compare(0, 12, "--borderless") == 0) {
+            options.displayMode = arg[2] == 'f' ? DisplayMode::FULLSCREEN : DisplayMode::BORDERLESS;
+            if (arg.size() > 13 && arg[12] == '=') {
+                options.monitorIndex = std::max(0, std::atoi(arg.c_str() + 13));
+            }
+        } else if (arg == "--imgui-hud") {
+            options.imguiHud = true;
+        } else if (arg.compare(0, 7, "--post=") == 0) {
+            options.postChain = arg.substr(7);
+        } else if (arg.compare(0, 14, "--post-budget=") == 0) {
+            options.postBudgetMs = static_cast<float>(std::atof(arg.c_str() + 14));
+        } else if (arg.compare(0, 9, "--scores=") == 0) {
+            options.scoresPath = arg.substr(9);
+        } else if (arg == "--bench-scores") {
+            options.benchScores = true;
+        } else if (arg == "--renderer=vulkan" || arg == "--renderer=gl") {
+            options.vulkan = arg == "--renderer=vulkan";
+        } else if (arg.compare(0, 10, "--present=") == 0) {
+            const std::string mode = arg.substr(10);
+            bool known = false;
+            for (PresentMode candidate: {PresentMode::FIFO, PresentMode::FIFO_RELAXED, PresentMode::MAILBOX,
+                                         PresentMode::IMMEDIATE}) {
+                if (mode == presentModeName(candidate)) {
+                    options.presentMode = candidate;
+                    known = true;
+                }
+            }
+            if (!known) {
+                throw std::runtime_error("Invalid --present value (expected fifo, relaxed, mailbox or immediate): " +
+                                         mode);
+            }
+        } else if (arg.compare(0, 19, "--frames-in-flight=") == 0) {
+            options.framesInFlight = std::min(3, std::max(1, std::atoi(arg.c_str() + 19)));
+        } else if (arg.compare(0, 10, "--backend=") == 0) {
+            const std::string name = arg.substr(10);
+            bool known = false;
+            for (RenderBackendType candidate: {RenderBackendType::GL2, RenderBackendType::GL,
+                                               RenderBackendType::SOFTWARE, RenderBackendType::NONE}) {
+                if (name == renderBackendName(candidate)) {
+                    options.backend = candidate;
+                    known = true;
+                }
+            }
+            if (!known) {
+                throw std::runtime_error("Invalid --backend value (expected gl2, gl, soft or null): " + name);
+            }
+        } else if (arg == "--bench-render") {
+            options.benchRender = true;
+        } else if (arg == "--bench-bricks") {
+            options.benchBricks = true;
+        } else if (arg.compare(0, 9, "--rewind=") == 0) {
+            options.rewindSeconds = std::max(0.0f, static_cast<float>(std::atof(arg.c_str() + 9)));
+        } else if (arg == "--bench-rewind") {
+            options.benchRewind = true;
+        } else if (arg.compare(0, 9, "--events=") == 0) {
+            options.eventsPath = arg.substr(9);
+        } else if (arg.compare(0, 16, "--events-format=") == 0) {
+            const std::string name = arg.substr(16);
+            if (name == eventFormatName(EventFormat::NDJSON)) {
+                options.eventFormat = EventFormat::NDJSON;
+            } else if (name == eventFormatName(EventFormat::BINARY)) {
+                options.eventFormat = EventFormat::BINARY;
+            } else {
+                throw std::runtime_error("Invalid --events-format value (expected ndjson or binary): " + name);
+            }
+        } else if (arg == "--bench-events") {
+            options.benchEvents = true;
+        } else if (arg.compare(0, 6, "--out=") == 0) {
+            options.outPrefix = arg.substr(6);
+        } else {
+            std::cerr << "Unknown option ignored: " << arg << std::endl;
+        }
+    }
+    return options;
+}
+
+//-----------------------------------------------------------------------------
+// Frame Histogram
+//-----------------------------------------------------------------------------
+// Histogramme des durées de frame (cases de 0.25 ms jusqu'à 40 ms, la dernière case
+// accumule tout ce qui dépasse). Sert à mesurer la gigue avec et sans --low-jitter.
+struct FrameHistogram {
+    static constexpr int BUCKET_COUNT = 160;
+    static constexpr double BUCKET_MS = 0.25;
+
+    float buckets[BUCKET_COUNT] = {}; // float pour ImGui::PlotHistogram
+    long long count = 0;
+    double mean = 0.0;
+    double m2 = 0.0; // Somme des carrés des écarts (Welford)
+    double maxMs = 0.0;
+
+    void record(double seconds) {
+        const double ms = seconds * 1000.0;
+        int bucket = static_cast<int>(ms / BUCKET_MS);
+        bucket = std::max(0, std::min(bucket, BUCKET_COUNT - 1));
+        buckets[bucket] += 1.0f;
+
+        ++count;
+        const double delta = ms - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (ms - mean);
+        maxMs = std::max(maxMs, ms);
+    }
+
+    void reset() { *this = FrameHistogram(); }
+
+    double stddev() const { return count > 1 ? std::sqrt(m2 / static_cast<double>(count - 1)) : 0.0; }
+
+    // Percentile approché à la résolution d'une case
+    double percentile(double p) const {
+        if (count == 0) return 0.0;
+        const double target = p * static_cast<double>(count);
+        double seen = 0.0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets[i];
+            if (seen >= target) return (i + 1) * BUCKET_MS;
+        }
+        return BUCKET_COUNT * BUCKET_MS;
+    }
+
+    void printReport(std::ostream &out, const char *label) const {
+        out << "Frame times [" << label << "] frames=" << count
+                << " mean=" << mean << "ms stddev=" << stddev()
+                << "ms p50=" << percentile(0.50) << "ms p99=" << percentile(0.99)
+                << "ms p99.9=" << percentile(0.999) << "ms max=" << maxMs << "ms" << std::endl;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Low-jitter Runtime (Linux)
+//-----------------------------------------------------------------------------
+// Le jeu tourne sur un seul thread (simulation + rendu), c'est donc lui qui est épinglé
+// et promu. Chaque étape est tentée indépendamment : un refus (EPERM sans CAP_SYS_NICE,
+// RLIMIT_MEMLOCK trop bas...) est simplement consigné dans le rapport.
+std::vector<std::string> applyLowJitterSettings(const RuntimeOptions &options) {
+    std::vector<std::string> report;
+#ifdef __linux__
+    // --- Affinité CPU ---
+    if (options.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options.cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+            report.push_back("pinned to CPU " + std::to_string(options.cpu));
+        } else {
+            report.push_back("CPU pinning failed: " + std::string(std::strerror(errno)));
+        }
+    }
+
+    // --- Priorité : SCHED_FIFO si permis, sinon nice négatif ---
+    sched_param param{};
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) == 0) {
+        report.push_back("SCHED_FIFO priority " + std::to_string(param.sched_priority));
+    } else if (setpriority(PRIO_PROCESS, 0, -10) == 0) {
+        report.push_back("SCHED_FIFO denied, nice -10");
+    } else {
+        report.push_back("priority unchanged: " + std::string(std::strerror(errno)));
+    }
+
+    // --- Mémoire : ne jamais rendre le tas au noyau, puis tout verrouiller ---
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        report.push_back("memory locked (mlockall)");
+    } else {
+        report.push_back("mlockall failed: " + std::string(std::strerror(errno)));
+    }
+
+    // Préchargement de la pile : toucher chaque page une fois pour éviter les défauts de page en jeu
+    constexpr size_t STACK_PREFAULT_BYTES = 512 * 1024;
+    volatile unsigned char stackPrefault[STACK_PREFAULT_BYTES];
+    for (size_t i = 0; i < STACK_PREFAULT_BYTES; i += 4096) {
+        stackPrefault[i] = 0;
+    }
+    (void) stackPrefault[0];
+    report.push_back("stack prefaulted (" + std::to_string(STACK_PREFAULT_BYTES / 1024) + " KB)");
+#else
+    (void) options;
+    report.push_back("low-jitter mode is only supported on Linux");
+#endif
+    return report;
+}
+
+//-----------------------------------------------------------------------------
+// Offscreen Render Target
+//-----------------------------------------------------------------------------
+// Le contexte OpenGL 2.1 n'expose les FBO que via GL_EXT_framebuffer_object : les points
+// d'entrée sont chargés à l'exécution avec glfwGetProcAddress.
+#ifndef APIENTRY
+#ifdef _WIN32
+#define APIENTRY __stdcall
+#else
+#define APIENTRY
+#endif
+#endif
+
+constexpr GLenum FBO_FRAMEBUFFER = 0x8D40; // GL_FRAMEBUFFER_EXT
+constexpr GLenum FBO_COLOR_ATTACHMENT0 = 0x8CE0; // GL_COLOR_ATTACHMENT0_EXT
+constexpr GLenum FBO_COMPLETE = 0x8CD5; // GL_FRAMEBUFFER_COMPLETE_EXT
+
+struct FramebufferFunctions {
+    using GenFramebuffers = void (APIENTRY *)(GLsizei, GLuint *);
+    using DeleteFramebuffers = void (APIENTRY *)(GLsizei, const GLuint *);
+    using BindFramebuffer = void (APIENTRY *)(GLenum, GLuint);
+    using FramebufferTexture2D = void (APIENTRY *)(GLenum, GLenum, GLenum, GLuint, GLint);
+    using CheckFramebufferStatus = GLenum (APIENTRY *)(GLenum);
+
+    GenFramebuffers genFramebuffers = nullptr;
+    DeleteFramebuffers deleteFramebuffers = nullptr;
+    BindFramebuffer bindFramebuffer = nullptr;
+    FramebufferTexture2D framebufferTexture2D = nullptr;
+    CheckFramebufferStatus checkFramebufferStatus = nullptr;
+
+    // À appeler avec un contexte courant
+    bool load() {
+        genFramebuffers = reinterpret_cast<GenFramebuffers>(glfwGetProcAddress("glGenFramebuffersEXT"));
+        deleteFramebuffers = reinterpret_cast<DeleteFramebuffers>(glfwGetProcAddress("glDeleteFramebuffersEXT"));
+        bindFramebuffer = reinterpret_cast<BindFramebuffer>(glfwGetProcAddress("glBindFramebufferEXT"));
+        framebufferTexture2D = reinterpret_cast<FramebufferTexture2D>(
+            glfwGetProcAddress("glFramebufferTexture2DEXT"));
+        checkFramebufferStatus = reinterpret_cast<CheckFramebufferStatus>(
+            glfwGetProcAddress("glCheckFramebufferStatusEXT"));
+        return genFramebuffers && deleteFramebuffers && bindFramebuffer && framebufferTexture2D &&
+               checkFramebufferStatus;
+    }
+};
+
+// FBO avec une texture couleur RGBA8 dans laquelle toute la frame (jeu + ImGui) est dessinée
+struct OffscreenTarget {
+    GLuint framebuffer = 0;
+    GLuint colorTexture = 0;
+    int width = 0;
+    int height = 0;
+
+    bool create(const FramebufferFunctions &gl, int w, int h) {
+        width = w;
+        height = h;
+        glGenTextures(1, &colorTexture);
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        gl.genFramebuffers(1, &framebuffer);
+        gl.bindFramebuffer(FBO_FRAMEBUFFER, framebuffer);
+        gl.framebufferTexture2D(FBO_FRAMEBUFFER, FBO_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        const bool complete = gl.checkFramebufferStatus(FBO_FRAMEBUFFER) == FBO_COMPLETE;
+        gl.bindFramebuffer(FBO_FRAMEBUFFER, 0);
+        if (!complete) {
+            destroy(gl);
+        }
+        return complete;
+    }
+
+    void destroy(const FramebufferFunctions &gl) {
+        if (framebuffer) gl.deleteFramebuffers(1, &framebuffer);
+        if (colorTexture) glDeleteTextures(1, &colorTexture);
+        framebuffer = 0;
+        colorTexture = 0;
+    }
+
+    // Écrit le contenu courant en PPM binaire (P6), lignes remises dans l'ordre haut -> bas
+    bool writePPM(const FramebufferFunctions &gl, const std::string &path) const {
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+        gl.bindFramebuffer(FBO_FRAMEBUFFER, framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "P6\n" << width << " " << height << "\n255\n";
+        const size_t rowBytes = static_cast<size_t>(width) * 3;
+        for (int y = height - 1; y >= 0; --y) {
+            file.write(reinterpret_cast<const char *>(pixels.data() + y * rowBytes),
+                       static_cast<std::streamsize>(rowBytes));
+        }
+        return static_cast<bool>(file);
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+// Post-Processing
+//-----------------------------------------------------------------------------
+// La scène est dessinée dans un FBO puis traverse une chaîne de passes (--post=bloom:2,crt).
+// Le bloom extrait les zones claires à 1/2 ou 1/4 de la résolution, les floute en deux
+// passes séparables puis les ajoute à l'image. Le coût GPU de chaque passe est mesuré par
+// requêtes de temps (lues avec quelques frames de retard, sans attente) et la passe la plus
+// chère est désactivée si la chaîne dépasse son budget. ImGui est dessiné ensuite, à la
+// résolution native, sans effet.
+constexpr GLenum SHADER_FRAGMENT = 0x8B30; // GL_FRAGMENT_SHADER
+constexpr GLenum SHADER_VERTEX = 0x8B31; // GL_VERTEX_SHADER
+constexpr GLenum SHADER_COMPILE_STATUS = 0x8B81;
+constexpr GLenum SHADER_LINK_STATUS = 0x8B82;
+constexpr GLenum QUERY_TIME_ELAPSED = 0x88BF; // GL_TIME_ELAPSED_EXT
+constexpr GLenum QUERY_RESULT = 0x8866;
+constexpr GLenum QUERY_RESULT_AVAILABLE = 0x8867;
+constexpr GLenum TEXTURE_UNIT0 = 0x84C0; // GL_TEXTURE0
+
+// Shaders GLSL (OpenGL 2.0) et requêtes de temps (GL_EXT_timer_query), chargés comme les FBO
+struct ShaderFunctions {
+    using CreateShader = GLuint (APIENTRY *)(GLenum);
+    using ShaderSource = void (APIENTRY *)(GLuint, GLsizei, const char *const *, const GLint *);
+    using CompileShader = void (APIENTRY *)(GLuint);
+    using GetShaderiv = void (APIENTRY *)(GLuint, GLenum, GLint *);
+    using GetInfoLog = void (APIENTRY *)(GLuint, GLsizei, GLsizei *, char *);
+    using CreateProgram = GLuint (APIENTRY *)();
+    using AttachShader = void (APIENTRY *)(GLuint, GLuint);
+    using LinkProgram = void (APIENTRY *)(GLuint);
+    using UseProgram = void (APIENTRY *)(GLuint);
+    using DeleteObject = void (APIENTRY *)(GLuint);
+    using GetUniformLocation = GLint (APIENTRY *)(GLuint, const char *);
+    using Uniform1i = void (APIENTRY *)(GLint, GLint);
+    using Uniform1f = void (APIENTRY *)(GLint, GLfloat);
+    using Uniform2f = void (APIENTRY *)(GLint, GLfloat, GLfloat);
+    using ActiveTexture = void (APIENTRY *)(GLenum);
+    using GenQueries = void (APIENTRY *)(GLsizei, GLuint *);
+    using DeleteQueries = void (APIENTRY *)(GLsizei, const GLuint *);
+    using BeginQuery = void (APIENTRY *)(GLenum, GLuint);
+    using EndQuery = void (APIENTRY *)(GLenum);
+    using GetQueryObjectiv = void (APIENTRY *)(GLuint, GLenum, GLint *);
+    using GetQueryObjectui64v = void (APIENTRY *)(GLuint, GLenum, uint64_t *);
+
+    CreateShader createShader = nullptr;
+    ShaderSource shaderSource = nullptr;
+    CompileShader compileShader = nullptr;
+    GetShaderiv getShaderiv = nullptr;
+    GetInfoLog getShaderInfoLog = nullptr;
+    CreateProgram createProgram = nullptr;
+    AttachShader attachShader = nullptr;
+    LinkProgram linkProgram = nullptr;
+    GetShaderiv getProgramiv = nullptr;
+    GetInfoLog getProgramInfoLog = nullptr;
+    UseProgram useProgram = nullptr;
+    DeleteObject deleteShader = nullptr;
+    DeleteObject deleteProgram = nullptr;
+    GetUniformLocation getUniformLocation = nullptr;
+    Uniform1i uniform1i = nullptr;
+    Uniform1f uniform1f = nullptr;
+    Uniform2f uniform2f = nullptr;
+    ActiveTexture activeTexture = nullptr;
+    // Optionnels : sans eux le coût des passes n'est pas mesuré
+    GenQueries genQueries = nullptr;
+    DeleteQueries deleteQueries = nullptr;
+    BeginQuery beginQuery = nullptr;
+    EndQuery endQuery = nullptr;
+    GetQueryObjectiv getQueryObjectiv = nullptr;
+    GetQueryObjectui64v getQueryObjectui64v = nullptr;
+
+    template<typename F>
+    static void loadEntry(F &entry, const char *name) {
+        entry = reinterpret_cast<F>(glfwGetProcAddress(name));
+    }
+
+    // À appeler avec un contexte courant
+    bool load() {
+        loadEntry(createShader, "glCreateShader");
+        loadEntry(shaderSource, "glShaderSource");
+        loadEntry(compileShader, "glCompileShader");
+        loadEntry(getShaderiv, "glGetShaderiv");
+        loadEntry(getShaderInfoLog, "glGetShaderInfoLog");
+        loadEntry(createProgram, "glCreateProgram");
+        loadEntry(attachShader, "glAttachShader");
+        loadEntry(linkProgram, "glLinkProgram");
+        loadEntry(getProgramiv, "glGetProgramiv");
+        loadEntry(getProgramInfoLog, "glGetProgramInfoLog");
+        loadEntry(useProgram, "glUseProgram");
+        loadEntry(deleteShader, "glDeleteShader");
+        loadEntry(deleteProgram, "glDeleteProgram");
+        loadEntry(getUniformLocation, "glGetUniformLocation");
+        loadEntry(uniform1i, "glUniform1i");
+        loadEntry(uniform1f, "glUniform1f");
+        loadEntry(uniform2f, "glUniform2f");
+        loadEntry(activeTexture, "glActiveTexture");
+        if (glfwExtensionSupported("GL_EXT_timer_query") || glfwExtensionSupported("GL_ARB_timer_query")) {
+            loadEntry(genQueries, "glGenQueries");
+            loadEntry(deleteQueries, "glDeleteQueries");
+            loadEntry(beginQuery, "glBeginQuery");
+            loadEntry(endQuery, "glEndQuery");
+            loadEntry(getQueryObjectiv, "glGetQueryObjectiv");
+            loadEntry(getQueryObjectui64v, "glGetQueryObjectui64vEXT");
+            if (!getQueryObjectui64v) loadEntry(getQueryObjectui64v, "glGetQueryObjectui64v");
+        }
+        return createShader && shaderSource && compileShader && getShaderiv && getShaderInfoLog && createProgram &&
+               attachShader && linkProgram && getProgramiv && getProgramInfoLog && useProgram && deleteShader &&
+               deleteProgram && getUniformLocation && uniform1i && uniform1f && uniform2f && activeTexture;
+    }
+
+    bool hasTimers() const {
+        return genQueries && deleteQueries && beginQuery && endQuery && getQueryObjectiv && getQueryObjectui64v;
+    }
+
+    // Par défaut programme "quad plein écran" : le sommet passe tel quel (coordonnées -1..1)
+    GLuint buildProgram(const char *fragmentSource, const char *name, const char *vertexSource = nullptr) const {
+        static const char *FULLSCREEN_VERTEX_SOURCE =
+                "void main() { gl_TexCoord[0] = gl_MultiTexCoord0; gl_Position = gl_Vertex; }";
+        const GLuint vertex = compile(SHADER_VERTEX, vertexSource ? vertexSource : FULLSCREEN_VERTEX_SOURCE, name);
+        const GLuint fragment = compile(SHADER_FRAGMENT, fragmentSource, name);
+        const GLuint program = createProgram();
+        attachShader(program, vertex);
+        attachShader(program, fragment);
+        linkProgram(program);
+        deleteShader(vertex);
+        deleteShader(fragment);
+        GLint linked = 0;
+        getProgramiv(program, SHADER_LINK_STATUS, &linked);
+        if (!linked) {
+            char log[1024] = {};
+            getProgramInfoLog(program, sizeof(log), nullptr, log);
+            deleteProgram(program);
+            throw std::runtime_error(std::string("Failed to link shader ") + name + ": " + log);
+        }
+        return program;
+    }
+
+    GLuint compile(GLenum type, const char *source, const char *name) const {
+        const GLuint shader = createShader(type);
+        shaderSource(shader, 1, &source, nullptr);
+        compileShader(shader);
+        GLint compiled = 0;
+        getShaderiv(shader, SHADER_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            char log[1024] = {};
+            getShaderInfoLog(shader, sizeof(log), nullptr, log);
+            deleteShader(shader);
+            throw std::runtime_error(std::string("Failed to compile shader ") + name + ": " + log);
+        }
+        return shader;
+    }
+};
+
+// Sous-échantillonnage 2x2 (bilinéaire, 4 lectures) et seuil de luminance
+const char *const BLOOM_EXTRACT_SHADER = R"(
+uniform sampler2D source;
+uniform vec2 offset;
+uniform float threshold;
+void main() {
+    vec2 uv = gl_TexCoord[0].xy;
+    vec3 c = texture2D(source, uv + vec2(-offset.x, -offset.y)).rgb + texture2D(source, uv + vec2(offset.x, -offset.y)).rgb
+           + texture2D(source, uv + vec2(-offset.x, offset.y)).rgb + texture2D(source, uv + offset).rgb;
+    c *= 0.25;
+    float luminance = max(c.r, max(c.g, c.b));
+    gl_FragColor = vec4(c * max(luminance - threshold, 0.0) / max(luminance, 0.0001), 1.0);
+}
+)";
+
+// Gaussienne 9 points en 5 lectures bilinéaires, dans une direction
+const char *const BLOOM_BLUR_SHADER = R"(
+uniform sampler2D source;
+uniform vec2 direction;
+void main() {
+    vec2 uv = gl_TexCoord[0].xy;
+    vec3 c = texture2D(source, uv).rgb * 0.2270270270;
+    c += (texture2D(source, uv + direction * 1.3846153846).rgb + texture2D(source, uv - direction * 1.3846153846).rgb) * 0.3162162162;
+    c += (texture2D(source, uv + direction * 3.2307692308).rgb + texture2D(source, uv - direction * 3.2307692308).rgb) * 0.0702702703;
+    gl_FragColor = vec4(c, 1.0);
+}
+)";
+
+const char *const BLOOM_COMPOSITE_SHADER = R"(
+uniform sampler2D source;
+uniform sampler2D bloom;
+uniform float strength;
+void main() {
+    vec2 uv = gl_TexCoord[0].xy;
+    gl_FragColor = vec4(texture2D(source, uv).rgb + texture2D(bloom, uv).rgb * strength, 1.0);
+}
+)";
+
+// Écran bombé, lignes de balayage, masque RGB vertical et vignettage
+const char *const CRT_SHADER = R"(
+uniform sampler2D source;
+uniform vec2 resolution;
+uniform float curvature;
+void main() {
+    vec2 uv = gl_TexCoord[0].xy * 2.0 - 1.0;
+    uv += uv * (uv.yx * uv.yx) * curvature;
+    uv = uv * 0.5 + 0.5;
+    if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0) {
+        gl_FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    vec3 c = texture2D(source, uv).rgb;
+    float scanline = 0.8 + 0.2 * sin(uv.y * resolution.y * 3.14159265);
+    float column = mod(gl_FragCoord.x, 3.0);
+    vec3 mask = column < 1.0 ? vec3(1.1, 0.95, 0.95) : (column < 2.0 ? vec3(0.95, 1.1, 0.95) : vec3(0.95, 0.95, 1.1));
+    vec2 edge = uv * (1.0 - uv.yx);
+    float vignette = pow(clamp(edge.x * edge.y * 16.0, 0.0, 1.0), 0.2);
+    gl_FragColor = vec4(c * scanline * mask * vignette, 1.0);
+}
+)";
+
+constexpr float BLOOM_THRESHOLD = 0.6f;
+constexpr float BLOOM_STRENGTH = 1.2f;
+constexpr float CRT_CURVATURE = 0.06f;
+constexpr int POST_QUERY_FRAMES = 4; // Requêtes en vol par passe : le résultat est lu 4 frames plus tard
+constexpr int POST_WARMUP_FRAMES = 60; // Mesures ignorées par le budget après un changement de la chaîne
+
+class PostProcessor {
+public:
+    enum class PassType { BLOOM, CRT };
+
+    struct Pass {
+        PassType type = PassType::CRT;
+        int scale = 1; // Bloom : diviseur de résolution (2 ou 4)
+        bool enabled = true;
+        bool overBudget = false; // Désactivée automatiquement
+        float costMs = 0.0f; // Coût GPU lissé
+        bool measured = false;
+        GLuint queries[POST_QUERY_FRAMES] = {};
+        OffscreenTarget small[2]; // Bloom : tampons sous-échantillonnés
+
+        const char *name() const { return type == PassType::BLOOM ? "bloom" : "crt"; }
+    };
+
+    std::vector<Pass> passes;
+    float budgetMs = 2.0f;
+
+    // chain : "bloom", "bloom:4", "crt", séparés par des virgules
+    bool init(const FramebufferFunctions &framebuffers, const std::string &chain, float budget) {
+        fbo = &framebuffers;
+        budgetMs = budget;
+        if (!shaders.load()) {
+            std::cerr << "Post-processing requires OpenGL 2.0 shaders" << std::endl;
+            return false;
+        }
+        size_t start = 0;
+        while (start <= chain.size()) {
+            const size_t end = std::min(chain.find(',', start), chain.size());
+            const std::string item = chain.substr(start, end - start);
+            start = end + 1;
+            if (item.empty()) continue;
+            Pass pass;
+            if (item.compare(0, 5, "bloom") == 0) {
+                pass.type = PassType::BLOOM;
+                pass.scale = item.size() > 6 && item[5] == ':' ? std::atoi(item.c_str() + 6) : 2;
+                if (pass.scale != 2 && pass.scale != 4) {
+                    std::cerr << "Bloom scale must be 2 or 4, using 2" << std::endl;
+                    pass.scale = 2;
+                }
+            } else if (item == "crt") {
+                pass.type = PassType::CRT;
+            } else {
+                std::cerr << "Unknown post-processing pass: " << item << std::endl;
+                continue;
+            }
+            if (shaders.hasTimers()) shaders.genQueries(POST_QUERY_FRAMES, pass.queries);
+            passes.push_back(pass);
+        }
+        try {
+            extractProgram = shaders.buildProgram(BLOOM_EXTRACT_SHADER, "bloom extract");
+            blurProgram = shaders.buildProgram(BLOOM_BLUR_SHADER, "bloom blur");
+            compositeProgram = shaders.buildProgram(BLOOM_COMPOSITE_SHADER, "bloom composite");
+            crtProgram = shaders.buildProgram(CRT_SHADER, "crt");
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            release();
+            return false;
+        }
+        return !passes.empty();
+    }
+
+    void release() {
+        for (Pass &pass: passes) {
+            pass.small[0].destroy(*fbo);
+            pass.small[1].destroy(*fbo);
+            if (shaders.hasTimers()) shaders.deleteQueries(POST_QUERY_FRAMES, pass.queries);
+        }
+        passes.clear();
+        for (OffscreenTarget *target: {&scene, &pingPong[0], &pingPong[1]}) target->destroy(*fbo);
+        for (GLuint *program: {&extractProgram, &blurProgram, &compositeProgram, &crtProgram}) {
+            if (*program) shaders.deleteProgram(*program);
+            *program = 0;
+        }
+    }
+
+    bool active() const {
+        for (const Pass &pass: passes) {
+            if (pass.enabled) return true;
+        }
+        return false;
+    }
+
+    bool hasTimers() const { return shaders.hasTimers(); }
+
+    // Activation manuelle (fenêtre de debug) : les mesures repartent de zéro
+    void setEnabled(Pass &pass, bool enabled) {
+        pass.enabled = enabled;
+        pass.overBudget = false;
+        pass.measured = false;
+        warmupUntil = frame + POST_WARMUP_FRAMES;
+    }
+
+    // Prépare (ou recrée après redimensionnement) les cibles et y redirige le dessin
+    void beginScene(int width, int height) {
+        if (scene.width != width || scene.height != height || !scene.framebuffer) {
+            resize(width, height);
+        }
+        fbo->bindFramebuffer(FBO_FRAMEBUFFER, scene.framebuffer);
+    }
+
+    // Exécute la chaîne ; la dernière passe écrit dans output (0 = écran), qui reste lié
+    void apply(GLuint output) {
+        glPushAttrib(GL_ENABLE_BIT | GL_VIEWPORT_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT);
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_TEXTURE_2D);
+
+        int last = -1;
+        for (int i = 0; i < static_cast<int>(passes.size()); ++i) {
+            if (passes[i].enabled) last = i;
+        }
+        GLuint input = scene.colorTexture;
+        int next = 0;
+        for (int i = 0; i <= last; ++i) {
+            Pass &pass = passes[i];
+            if (!pass.enabled) continue;
+            const GLuint target = i == last ? output : pingPong[next].framebuffer;
+            beginTiming(pass);
+            if (pass.type == PassType::BLOOM) {
+                runBloom(pass, input, target);
+            } else {
+                runCrt(input, target);
+            }
+            endTiming(pass);
+            input = pingPong[next].colorTexture;
+            next ^= 1;
+        }
+        shaders.useProgram(0);
+        shaders.activeTexture(TEXTURE_UNIT0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPopAttrib();
+        ++frame;
+        enforceBudget();
+    }
+
+private:
+    const FramebufferFunctions *fbo = nullptr;
+    ShaderFunctions shaders;
+    OffscreenTarget scene;
+    OffscreenTarget pingPong[2];
+    GLuint extractProgram = 0;
+    GLuint blurProgram = 0;
+    GLuint compositeProgram = 0;
+    GLuint crtProgram = 0;
+    long long frame = 0;
+    long long warmupUntil = POST_WARMUP_FRAMES;
+
+    void resize(int width, int height) {
+        for (OffscreenTarget *target: {&scene, &pingPong[0], &pingPong[1]}) {
+            target->destroy(*fbo);
+            target->create(*fbo, width, height);
+        }
+        for (Pass &pass: passes) {
+            for (OffscreenTarget &target: pass.small) {
+                target.destroy(*fbo);
+                if (pass.type == PassType::BLOOM) {
+                    target.create(*fbo, std::max(1, width / pass.scale), std::max(1, height / pass.scale));
+                }
+            }
+        }
+        warmupUntil = frame + POST_WARMUP_FRAMES;
+    }
+
+    static void drawFullscreenQuad() {
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f);
+        glVertex2f(-1.0f, -1.0f);
+        glTexCoord2f(1.0f, 0.0f);
+        glVertex2f(1.0f, -1.0f);
+        glTexCoord2f(1.0f, 1.0f);
+        glVertex2f(1.0f, 1.0f);
+        glTexCoord2f(0.0f, 1.0f);
+        glVertex2f(-1.0f, 1.0f);
+        glEnd();
+    }
+
+    void bindTarget(GLuint framebuffer, int width, int height) const {
+        fbo->bindFramebuffer(FBO_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+    }
+
+    void bindTexture(int unit, GLuint texture) const {
+        shaders.activeTexture(TEXTURE_UNIT0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+
+    void runBloom(const Pass &pass, GLuint input, GLuint output) {
+        const OffscreenTarget &a = pass.small[0];
+        const OffscreenTarget &b = pass.small[1];
+        // Extraction : chaque texel réduit couvre scale x scale texels de la scène
+        bindTarget(a.framebuffer, a.width, a.height);
+        shaders.useProgram(extractProgram);
+        shaders.uniform1i(shaders.getUniformLocation(extractProgram, "source"), 0);
+        shaders.uniform2f(shaders.getUniformLocation(extractProgram, "offset"), pass.scale * 0.25f / scene.width,
+                          pass.scale * 0.25f / scene.height);
+        shaders.uniform1f(shaders.getUniformLocation(extractProgram, "threshold"), BLOOM_THRESHOLD);
+        bindTexture(0, input);
+        drawFullscreenQuad();
+
+        shaders.useProgram(blurProgram);
+        shaders.uniform1i(shaders.getUniformLocation(blurProgram, "source"), 0);
+        const GLint direction = shaders.getUniformLocation(blurProgram, "direction");
+        bindTarget(b.framebuffer, b.width, b.height);
+        shaders.uniform2f(direction, 1.0f / a.width, 0.0f);
+        bindTexture(0, a.colorTexture);
+        drawFullscreenQuad();
+        bindTarget(a.framebuffer, a.width, a.height);
+        shaders.uniform2f(direction, 0.0f, 1.0f / a.height);
+        bindTexture(0, b.colorTexture);
+        drawFullscreenQuad();
+
+        bindTarget(output, scene.width, scene.height);
+        shaders.useProgram(compositeProgram);
+        shaders.uniform1i(shaders.getUniformLocation(compositeProgram, "source"), 0);
+        shaders.uniform1i(shaders.getUniformLocation(compositeProgram, "bloom"), 1);
+        shaders.uniform1f(shaders.getUniformLocation(compositeProgram, "strength"), BLOOM_STRENGTH);
+        bindTexture(1, a.colorTexture);
+        bindTexture(0, input);
+        drawFullscreenQuad();
+        bindTexture(1, 0);
+    }
+
+    void runCrt(GLuint input, GLuint output) {
+        bindTarget(output, scene.width, scene.height);
+        shaders.useProgram(crtProgram);
+        shaders.uniform1i(shaders.getUniformLocation(crtProgram, "source"), 0);
+        shaders.uniform2f(shaders.getUniformLocation(crtProgram, "resolution"), static_cast<float>(scene.width),
+                          static_cast<float>(scene.height));
+        shaders.uniform1f(shaders.getUniformLocation(crtProgram, "curvature"), CRT_CURVATURE);
+        bindTexture(0, input);
+        drawFullscreenQuad();
+    }
+
+    // La requête réutilisée a été émise POST_QUERY_FRAMES frames plus tôt : son résultat
+    // est normalement prêt ; sinon la mesure est simplement perdue (jamais d'attente)
+    void beginTiming(Pass &pass) {
+        if (!shaders.hasTimers()) return;
+        const GLuint query = pass.queries[frame % POST_QUERY_FRAMES];
+        if (frame >= POST_QUERY_FRAMES) {
+            GLint available = 0;
+            shaders.getQueryObjectiv(query, QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                uint64_t nanoseconds = 0;
+                shaders.getQueryObjectui64v(query, QUERY_RESULT, &nanoseconds);
+                const float sample = static_cast<float>(nanoseconds) * 1e-6f;
+                pass.costMs = pass.measured ? pass.costMs * 0.9f + sample * 0.1f : sample;
+                pass.measured = true;
+            }
+        }
+        shaders.beginQuery(QUERY_TIME_ELAPSED, query);
+    }
+
+    void endTiming(const Pass &) {
+        if (shaders.hasTimers()) shaders.endQuery(QUERY_TIME_ELAPSED);
+    }
+
+    // Au-delà du budget, la passe active la plus chère est coupée (réactivable dans F1)
+    void enforceBudget() {
+        if (!shaders.hasTimers() || frame < warmupUntil) return;
+        float total = 0.0f;
+        Pass *worst = nullptr;
+        for (Pass &pass: passes) {
+            if (!pass.enabled || !pass.measured) continue;
+            total += pass.costMs;
+            if (!worst || pass.costMs > worst->costMs) worst = &pass;
+        }
+        if (worst && total > budgetMs) {
+            worst->enabled = false;
+            worst->overBudget = true;
+            warmupUntil = frame + POST_WARMUP_FRAMES;
+            std::cout << "Post-processing: " << worst->name() << " disabled (" << worst->costMs << " ms, chain "
+                    << total << " ms > budget " << budgetMs << " ms)" << std::endl;
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Draw Commands
+//-----------------------------------------------------------------------------
+// Le jeu n'appelle plus OpenGL pour dessiner : il enregistre chaque frame des commandes
+// compactes (effacement, lots de quads unis ou de texte) dans un DrawCommandBuffer, trié
+// par couche puis par matériau, qu'un RenderBackend interchangeable exécute (--backend=...).
+// À l'intérieur d'une couche, les matériaux ne se recouvrent pas (objets unis du monde,
+// texte du HUD), donc le tri ne change pas l'image, seulement le nombre de changements d'état.
+
+// Repère des coordonnées : monde ([-boundX, boundX] x [-boundY, boundY], y vers le haut)
+// ou écran (pixels de la fenêtre, origine en haut à gauche, comme ImGui)
+enum class DrawLayer : uint8_t { WORLD, SCREEN };
+
+enum class DrawMaterial : uint8_t {
+    CLEAR, // Efface la cible avec DrawCommand::clearColor (aucun quad)
+    SOLID, // Quads de couleur unie
+    TEXT // Quads texturés par l'atlas SDF du HUD
+};
+
+// Rectangle aligné sur les axes, coins (x0, y0) et (x1, y1), couleur RGBA8
+struct DrawQuad {
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1; // Coordonnées dans l'atlas (TEXT seulement)
+    uint8_t color[4];
+};
+
+struct DrawCommand {
+    DrawLayer layer;
+    DrawMaterial material;
+    uint32_t first; // Index du premier quad dans DrawCommandBuffer::quads()
+    uint32_t count;
+    Color clearColor;
+
+    // Couche d'abord (peintre), puis matériau (une texture liée une seule fois par couche)
+    uint32_t sortKey() const { return static_cast<uint32_t>(layer) << 8 | static_cast<uint32_t>(material); }
+};
+
+class DrawCommandBuffer {
+public:
+    void reset() {
+        commandList.clear();
+        quadList.clear();
+    }
+
+    void clear(const Color &color) {
+        DrawCommand command = {DrawLayer::WORLD, DrawMaterial::CLEAR, 0, 0, color};
+        commandList.push_back(command);
+    }
+
+    // Les quads consécutifs de même couche et matériau prolongent la commande précédente
+    DrawQuad &addQuad(DrawLayer layer, DrawMaterial material) {
+        extend(layer, material, 1);
+        quadList.emplace_back();
+        return quadList.back();
+    }
+
+    void addQuads(DrawLayer layer, DrawMaterial material, const DrawQuad *quads, size_t count) {
+        if (count == 0) return;
+        extend(layer, material, count);
+        quadList.insert(quadList.end(), quads, quads + count);
+    }
+
+    // Tri stable par clé (l'ordre d'enregistrement est conservé à clé égale) puis fusion des commandes de même clé : les quads sont regroupés
+    // (recopiés dans l'ordre du tri) pour qu'il ne reste qu'un lot par couche et matériau
+    void finish() {
+        std::stable_sort(commandList.begin(), commandList.end(), [](const DrawCommand &a, const DrawCommand &b) {
+            return a.sortKey() < b.sortKey();
+        });
+        bool split = false;
+        for (size_t i = 1; i < commandList.size(); ++i) {
+            const DrawCommand &previous = commandList[i - 1];
+            if (commandList[i].sortKey() == previous.sortKey() &&
+                commandList[i].first != previous.first + previous.count) {
+                split = true;
+                break;
+            }
+        }
+        if (split) {
+            sortedQuads.clear();
+            for (DrawCommand &command: commandList) {
+                const uint32_t first = static_cast<uint32_t>(sortedQuads.size());
+                sortedQuads.insert(sortedQuads.end(), quadList.begin() + command.first,
+                                   quadList.begin() + command.first + command.count);
+                command.first = first;
+            }
+            quadList.swap(sortedQuads);
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < commandList.size(); ++i) {
+            const DrawCommand &command = commandList[i];
+            if (kept > 0 && command.material != DrawMaterial::CLEAR &&
+                command.sortKey() == commandList[kept - 1].sortKey()) {
+                commandList[kept - 1].count += command.count;
+            } else {
+                commandList[kept++] = command;
+            }
+        }
+        commandList.resize(kept);
+    }
+
+    void reserve(size_t quads) {
+        quadList.reserve(quads);
+        sortedQuads.reserve(quads);
+    }
+
+    const std::vector<DrawCommand> &commands() const { return commandList; }
+    const std::vector<DrawQuad> &quads() const { return quadList; }
+
+    // Première commande de la couche (ou fin du tampon) ; le tampon doit être trié
+    size_t layerBegin(DrawLayer layer) const {
+        size_t i = 0;
+        while (i < commandList.size() && commandList[i].layer < layer) ++i;
+        return i;
+    }
+
+private:
+    std::vector<DrawCommand> commandList;
+    std::vector<DrawQuad> quadList;
+    std::vector<DrawQuad> sortedQuads; // Réutilisé par finish()
+
+    void extend(DrawLayer layer, DrawMaterial material, size_t count) {
+        if (!commandList.empty()) {
+            DrawCommand &last = commandList.back();
+            if (last.layer == layer && last.material == material &&
+                last.first + last.count == quadList.size()) {
+                last.count += static_cast<uint32_t>(count);
+                return;
+            }
+        }
+        DrawCommand command = {layer, material, static_cast<uint32_t>(quadList.size()),
+                               static_cast<uint32_t>(count), Color()};
+        commandList.push_back(command);
+    }
+};
+
+inline void setQuadColor(DrawQuad &quad, const Color &color) {
+    quad.color[0] = static_cast<uint8_t>(color.r * 255.0f);
+    quad.color[1] = static_cast<uint8_t>(color.g * 255.0f);
+    quad.color[2] = static_cast<uint8_t>(color.b * 255.0f);
+    quad.color[3] = static_cast<uint8_t>(color.a * 255.0f);
+}
+
+//-----------------------------------------------------------------------------
+// SDF Text
+//-----------------------------------------------------------------------------
+// Atlas de distances signées (une seule texture, générée au chargement à partir de la
+// police TTF d'ImGui) : chaque texel stocke la distance au contour, 0.5 sur le bord. Le
+// filtrage bilinéaire interpole la distance, donc un seuil à 0.5 donne un contour net
+// à n'importe quelle taille. Avec les shaders, le bord est adouci sur un pixel écran
+// (fwidth) ; sinon le test alpha du pipeline fixe suffit.
+constexpr int SDF_FIRST_CHAR = 32;
+constexpr int SDF_LAST_CHAR = 126;
+constexpr float SDF_BASE_PIXELS = 26.0f; // Hauteur de ligne des glyphes dans l'atlas (2x la police ImGui de 13 px)
+constexpr int SDF_PADDING = 4; // Texels de distance autour de chaque glyphe
+constexpr int SDF_ATLAS_WIDTH = 512;
+
+const char *const SDF_VERTEX_SHADER =
+        "void main() { gl_TexCoord[0] = gl_MultiTexCoord0; gl_FrontColor = gl_Color; gl_Position = ftransform(); }";
+
+const char *const SDF_TEXT_SHADER = R"(
+uniform sampler2D atlas;
+void main() {
+    float distance = texture2D(atlas, gl_TexCoord[0].xy).a;
+    float width = max(fwidth(distance) * 0.7, 0.01);
+    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * smoothstep(0.5 - width, 0.5 + width, distance));
+}
+)";
+
+class SdfFont {
+public:
+    // ttf : police TrueType (par exemple les données chargées par ImGui)
+    bool build(const void *ttf) {
+        if (!generate(ttf)) {
+            return false;
+        }
+        upload();
+        return true;
+    }
+
+    // Partie CPU seule : métriques et atlas (suffit au rendu logiciel et aux mesures sans GL)
+    bool generate(const void *ttf) {
+        stbtt_fontinfo info;
+        const auto *data = static_cast<const unsigned char *>(ttf);
+        if (!stbtt_InitFont(&info, data, stbtt_GetFontOffsetForIndex(data, 0))) {
+            return false;
+        }
+        const float scale = stbtt_ScaleForPixelHeight(&info, SDF_BASE_PIXELS);
+        int ascent, descent, lineGap;
+        stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+        ascentBase = ascent * scale;
+
+        // Rangement en étagères dans un atlas de SDF_ATLAS_WIDTH de large
+        struct Bitmap {
+            unsigned char *pixels;
+            int width, height, x, y;
+        };
+        std::vector<Bitmap> bitmaps(SDF_LAST_CHAR - SDF_FIRST_CHAR + 1);
+        int penX = 0, penY = 0, rowHeight = 0;
+        for (int c = SDF_FIRST_CHAR; c <= SDF_LAST_CHAR; ++c) {
+            Bitmap &bitmap = bitmaps[c - SDF_FIRST_CHAR];
+            int xOffset = 0, yOffset = 0;
+            bitmap.pixels = stbtt_GetCodepointSDF(&info, scale, c, SDF_PADDING, 128, 128.0f / SDF_PADDING,
+                                                  &bitmap.width, &bitmap.height, &xOffset, &yOffset);
+            int advance, bearing;
+            stbtt_GetCodepointHMetrics(&info, c, &advance, &bearing);
+            SdfGlyph &glyph = glyphs[c - SDF_FIRST_CHAR];
+            glyph.advance = advance * scale;
+            if (!bitmap.pixels) {
+                bitmap.width = bitmap.height = 0; // Espace
+                continue;
+            }
+            if (penX + bitmap.width > SDF_ATLAS_WIDTH) {
+                penX = 0;
+                penY += rowHeight + 1;
+                rowHeight = 0;
+            }
+            bitmap.x = penX;
+            bitmap.y = penY;
+            penX += bitmap.width + 1;
+            rowHeight = std::max(rowHeight, bitmap.height);
+            glyph.x0 = static_cast<float>(xOffset);
+            glyph.y0 = static_cast<float>(yOffset);
+            glyph.x1 = static_cast<float>(xOffset + bitmap.width);
+            glyph.y1 = static_cast<float>(yOffset + bitmap.height);
+        }
+        int atlasHeight = 1;
+        while (atlasHeight < penY + rowHeight) atlasHeight *= 2;
+
+        atlas.assign(static_cast<size_t>(SDF_ATLAS_WIDTH) * atlasHeight, 0);
+        for (size_t i = 0; i < bitmaps.size(); ++i) {
+            const Bitmap &bitmap = bitmaps[i];
+            if (!bitmap.pixels) continue;
+            for (int row = 0; row < bitmap.height; ++row) {
+                std::memcpy(&atlas[static_cast<size_t>(bitmap.y + row) * SDF_ATLAS_WIDTH + bitmap.x],
+                            bitmap.pixels + row * bitmap.width, bitmap.width);
+            }
+            stbtt_FreeSDF(bitmap.pixels, nullptr);
+            SdfGlyph &glyph = glyphs[i];
+            glyph.u0 = static_cast<float>(bitmap.x) / SDF_ATLAS_WIDTH;
+            glyph.v0 = static_cast<float>(bitmap.y) / atlasHeight;
+            glyph.u1 = static_cast<float>(bitmap.x + bitmap.width) / SDF_ATLAS_WIDTH;
+            glyph.v1 = static_cast<float>(bitmap.y + bitmap.height) / atlasHeight;
+        }
+        return true;
+    }
+
+    void upload() {
+        const int atlasHeight = static_cast<int>(atlas.size() / SDF_ATLAS_WIDTH);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA8, SDF_ATLAS_WIDTH, atlasHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE,
+                     atlas.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (shaders.load()) {
+            try {
+                program = shaders.buildProgram(SDF_TEXT_SHADER, "sdf text", SDF_VERTEX_SHADER);
+            } catch (const std::exception &e) {
+                std::cerr << e.what() << ", using alpha test" << std::endl;
+            }
+        }
+    }
+
+    void release() {
+        if (texture) glDeleteTextures(1, &texture);
+        if (program) shaders.deleteProgram(program);
+        texture = 0;
+        program = 0;
+    }
+
+    bool ready() const { return texture != 0; }
+    bool generated() const { return !atlas.empty(); }
+
+    float measure(const std::string &text, float pixelSize) const {
+        float width = 0.0f;
+        for (char c: text) width += glyph(c).advance;
+        return width * pixelSize / SDF_BASE_PIXELS;
+    }
+
+    // (x, y) : coin haut gauche de la ligne, comme ImDrawList::AddText
+    void addText(std::vector<DrawQuad> &quads, float x, float y, float pixelSize, ImU32 color,
+                 const std::string &text) const {
+        const float scale = pixelSize / SDF_BASE_PIXELS;
+        const float baseline = std::round(y + ascentBase * scale); // Police pixel : contours alignés sur l'écran
+        x = std::round(x);
+        for (char c: text) {
+            const SdfGlyph &g = glyph(c);
+            if (g.x1 > g.x0) {
+                const DrawQuad quad = {
+                    x + g.x0 * scale, baseline + g.y0 * scale, x + g.x1 * scale, baseline + g.y1 * scale,
+                    g.u0, g.v0, g.u1, g.v1,
+                    {
+                        static_cast<uint8_t>(color >> IM_COL32_R_SHIFT), static_cast<uint8_t>(color >> IM_COL32_G_SHIFT),
+                        static_cast<uint8_t>(color >> IM_COL32_B_SHIFT), static_cast<uint8_t>(color >> IM_COL32_A_SHIFT)
+                    }
+                };
+                quads.push_back(quad);
+            }
+            x += g.advance * scale;
+        }
+    }
+
+    // État OpenGL du matériau TEXT (atlas, mélange, shader ou test alpha), à encadrer autour des quads
+    void bindGl() const {
+        glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (program) {
+            shaders.useProgram(program);
+            shaders.uniform1i(shaders.getUniformLocation(program, "atlas"), 0);
+        } else {
+            glEnable(GL_ALPHA_TEST);
+            glAlphaFunc(GL_GEQUAL, 0.5f);
+        }
+    }
+
+    void unbindGl() const {
+        if (program) shaders.useProgram(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPopAttrib();
+    }
+
+    // Distance (0..1, 0.5 sur le contour) lue dans la copie CPU de l'atlas, filtrage bilinéaire
+    float distance(float u, float v) const {
+        const int height = static_cast<int>(atlas.size() / SDF_ATLAS_WIDTH);
+        const float x = std::min(std::max(u * SDF_ATLAS_WIDTH - 0.5f, 0.0f), SDF_ATLAS_WIDTH - 1.0f);
+        const float y = std::min(std::max(v * height - 0.5f, 0.0f), height - 1.0f);
+        const int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+        const int x1 = std::min(x0 + 1, SDF_ATLAS_WIDTH - 1), y1 = std::min(y0 + 1, height - 1);
+        const float fx = x - x0, fy = y - y0;
+        const unsigned char *row0 = &atlas[static_cast<size_t>(y0) * SDF_ATLAS_WIDTH];
+        const unsigned char *row1 = &atlas[static_cast<size_t>(y1) * SDF_ATLAS_WIDTH];
+        const float top = row0[x0] + (row0[x1] - row0[x0]) * fx;
+        const float bottom = row1[x0] + (row1[x1] - row1[x0]) * fx;
+        return (top + (bottom - top) * fy) * (1.0f / 255.0f);
+    }
+
+private:
+    struct SdfGlyph {
+        float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f; // Rectangle dans l'atlas
+        float x0 = 0.0f, y0 = 0.0f, x1 = 0.0f, y1 = 0.0f; // Quad relatif au point de base (pixels de base)
+        float advance = 0.0f;
+    };
+
+    SdfGlyph glyphs[SDF_LAST_CHAR - SDF_FIRST_CHAR + 1];
+    float ascentBase = 0.0f;
+    std::vector<unsigned char> atlas; // Copie CPU de la texture (SDF_ATLAS_WIDTH de large)
+    GLuint texture = 0;
+    GLuint program = 0;
+    ShaderFunctions shaders;
+
+    const SdfGlyph &glyph(char c) const {
+        const int index = c >= SDF_FIRST_CHAR && c <= SDF_LAST_CHAR ? c - SDF_FIRST_CHAR : '?' - SDF_FIRST_CHAR;
+        return glyphs[index];
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Levels
+//-----------------------------------------------------------------------------
+// Un niveau est une grille de cellules (rangée 0 en haut). Le niveau d'origine est produit
+// par makeStockLevel() ; l'éditeur et les fichiers .lvl utilisent la même représentation.
+enum class CellKind : uint8_t {
+    EMPTY,
+    RED,
+    ORANGE,
+    GREEN,
+    YELLOW,
+    WALL, // Mur indestructible (gris)
+    REFLECTIVE, // Mur à rétroréflexion (blanc)
+    COUNT
+};
+
+constexpr int8_t NO_BONUS = -1;
+
+struct LevelCell {
+    CellKind kind = CellKind::EMPTY;
+    uint8_t hits = 1; // Coups nécessaires (2 = brique à compteur)
+    int8_t bonus = NO_BONUS; // Type de bonus libéré, NO_BONUS sinon
+};
+
+template<>
+struct EnumRange<CellKind> {
+    static constexpr int64_t min = static_cast<int64_t>(CellKind::EMPTY);
+    static constexpr int64_t max = static_cast<int64_t>(CellKind::COUNT) - 1;
+};
+
+#define LEVEL_CELL_FIELDS(F) F(2, kind) F(2, hits) F(2, bonus)
+BREAKOUT_SCHEMA(LevelCell, LEVEL_CELL_FIELDS)
+
+// Coups au plus d'une brique : le serveur garde chaque compteur sur un int8_t (CompactWorld)
+constexpr int MAX_CELL_HITS = INT8_MAX;
+
+// Cellule chargée d'un fichier : une brique cassable a 1..MAX_CELL_HITS coups, le bonus est connu
+constexpr bool isValidCell(const LevelCell &cell) {
+    const bool breakable = cell.kind != CellKind::EMPTY && cell.kind != CellKind::WALL &&
+                           cell.kind != CellKind::REFLECTIVE;
+    return (!breakable || (cell.hits >= 1 && cell.hits <= MAX_CELL_HITS)) &&
+           (cell.bonus == NO_BONUS || isBonusType(cell.bonus));
+}
+
+// Côté maximal d'un niveau : l'ordre de Morton (plus bas) code chaque axe sur 16 bits
+constexpr int MAX_LEVEL_SIDE = 0xFFFF;
+
+constexpr bool isLevelSize(int width, int height) {
+    return width >= 1 && width <= MAX_LEVEL_SIDE && height >= 1 && height <= MAX_LEVEL_SIDE;
+}
+
+struct LevelData {
+    int width = 0;
+    int height = 0;
+    std::vector<LevelCell> cells; // width * height, ligne par ligne
+
+    LevelCell &at(int row, int column) { return cells[static_cast<size_t>(row) * width + column]; }
+    const LevelCell &at(int row, int column) const { return cells[static_cast<size_t>(row) * width + column]; }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        cells.assign(static_cast<size_t>(w) * h, LevelCell());
+    }
+};
+
+constexpr uint32_t LEVEL_MAGIC = 0x4C56454C; // "LEVL"
+
+constexpr BrickColor cellBrickColor(CellKind kind) {
+    switch (kind) {
+        case CellKind::RED: return BrickColor::RED;
+        case CellKind::ORANGE: return BrickColor::ORANGE;
+        case CellKind::GREEN: return BrickColor::GREEN;
+        case CellKind::YELLOW: return BrickColor::YELLOW;
+        case CellKind::WALL: return BrickColor::GRAY;
+        default: return BrickColor::WHITE;
+    }
+}
+
+constexpr int cellPoints(CellKind kind) {
+    switch (kind) {
+        case CellKind::RED: return 7;
+        case CellKind::ORANGE: return 5;
+        case CellKind::GREEN: return 3;
+        case CellKind::YELLOW: return 1;
+        default: return 0;
+    }
+}
+
+// Brique (hors position et taille) correspondant à une cellule ; sert au chargement des
+// niveaux et à la table précalculée du niveau d'origine
+constexpr Block makeBlock(const LevelCell &cell, int row, int column) {
+    Block block;
+    block.row = row;
+    block.column = column;
+    block.active = true;
+    block.hitCounter = cell.hits;
+    block.points = cellPoints(cell.kind);
+    block.colorType = cellBrickColor(cell.kind);
+    block.color = getColorFromEnum(block.colorType);
+    // Cas spéciaux par type de brique
+    if (cell.kind == CellKind::WALL || cell.kind == CellKind::REFLECTIVE) {
+        // Murs indestructibles / réfléchissants
+        block.isWall = true;
+        block.isReflective = cell.kind == CellKind::REFLECTIVE;
+        block.hitCounter = -1;
+    } else if (cell.hits > 1) {
+        // Briques à compteur - version plus sombre de la couleur de base
+        block.color = getColorFromEnum(block.colorType, true);
+    } else if (cell.bonus != NO_BONUS) {
+        // Briques bonus
+        block.isBonus = true;
+        block.bonusType = cell.bonus;
+    }
+    return block;
+}
+
+// rand() de la glibc (générateur additif TYPE_3) évaluable à la compilation. Le niveau
+// d'origine était tiré avec srand(42) : il garde la même disposition, désormais identique
+// sur toutes les plateformes.
+class StockRandom {
+public:
+    constexpr explicit StockRandom(uint32_t seed) {
+        int32_t word = seed == 0 ? 1 : static_cast<int32_t>(seed);
+        state[0] = static_cast<uint32_t>(word);
+        for (int i = 1; i < DEGREE; ++i) {
+            // 16807 * word % 2147483647 sans débordement (Schrage)
+            const int32_t hi = word / 127773;
+            const int32_t lo = word % 127773;
+            word = 16807 * lo - 2836 * hi;
+            if (word < 0) word += 2147483647;
+            state[i] = static_cast<uint32_t>(word);
+        }
+        for (int i = 0; i < DEGREE * 10; ++i) {
+            next();
+        }
+    }
+
+    constexpr int next() {
+        state[front] += state[rear];
+        const int result = static_cast<int>(state[front] >> 1);
+        front = (front + 1) % DEGREE;
+        rear = (rear + 1) % DEGREE;
+        return result;
+    }
+
+private:
+    static constexpr int DEGREE = 31;
+    uint32_t state[DEGREE] = {};
+    int front = 3;
+    int rear = 0;
+};
+
+static_assert(StockRandom(42).next() == 71876166, "StockRandom must match glibc rand() after srand(42)");
+
+// Niveau d'origine : 8 rangées de 14, murs en haut, une brique à compteur et une brique
+// bonus par rangée à des positions tirées avec une graine fixe.
+struct StockLevelTable {
+    LevelCell cells[BRICK_ROWS][BRICKS_PER_ROW];
+};
+
+constexpr StockLevelTable makeStockLevel() {
+    StockLevelTable level;
+    StockRandom random(42);
+
+    // Positions fixes pour les briques bonus et compteur dans chaque rangée
+    int bonusPositions[BRICK_ROWS] = {};
+    int counterPositions[BRICK_ROWS] = {};
+    for (int i = 0; i < BRICK_ROWS; i++) {
+        bonusPositions[i] = 1 + random.next() % (BRICKS_PER_ROW - 2);
+        do {
+            counterPositions[i] = 1 + random.next() % (BRICKS_PER_ROW - 2);
+        } while (counterPositions[i] == bonusPositions[i]);
+    }
+
+    for (int i = 0; i < BRICK_ROWS; ++i) {
+        // Couleur de base selon la ligne
+        CellKind baseKind = CellKind::YELLOW;
+        if (i < 2) {
+            baseKind = CellKind::RED;
+        } else if (i < 4) {
+            baseKind = CellKind::ORANGE;
+        } else if (i < 6) {
+            baseKind = CellKind::GREEN;
+        }
+
+        for (int j = 0; j < BRICKS_PER_ROW; ++j) {
+            LevelCell &cell = level.cells[i][j];
+            cell.kind = baseKind;
+            if (i == 0 && (j == 0 || j == BRICKS_PER_ROW - 1)) {
+                cell.kind = CellKind::WALL; // Murs indestructibles
+            } else if (i == 0 && (j == 1 || j == BRICKS_PER_ROW - 2)) {
+                cell.kind = CellKind::REFLECTIVE; // Murs réfléchissants
+            } else if (j == counterPositions[i]) {
+                cell.hits = 2; // Briques à compteur
+            } else if (j == bonusPositions[i]) {
+                cell.bonus = static_cast<int8_t>(random.next() % 7); // Briques bonus
+            }
+        }
+    }
+    return level;
+}
+
+constexpr StockLevelTable STOCK_LEVEL = makeStockLevel();
+
+constexpr int countStockCells(bool (*match)(const LevelCell &)) {
+    int count = 0;
+    for (const auto &row: STOCK_LEVEL.cells) {
+        for (const LevelCell &cell: row) {
+            count += match(cell) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+constexpr int STOCK_BRICK_COUNT = countStockCells([](const LevelCell &cell) { return cell.kind != CellKind::EMPTY; });
+
+// Briques du niveau d'origine, prêtes à être copiées par initBlocks()
+struct StockBrickTable {
+    Block blocks[STOCK_BRICK_COUNT];
+};
+
+constexpr StockBrickTable makeStockBricks() {
+    StockBrickTable table;
+    int count = 0;
+    for (int i = 0; i < BRICK_ROWS; ++i) {
+        for (int j = 0; j < BRICKS_PER_ROW; ++j) {
+            if (STOCK_LEVEL.cells[i][j].kind != CellKind::EMPTY) {
+                table.blocks[count++] = makeBlock(STOCK_LEVEL.cells[i][j], i, j);
+            }
+        }
+    }
+    return table;
+}
+
+constexpr StockBrickTable STOCK_BRICKS = makeStockBricks();
+
+// Vérifications à la compilation de la disposition du niveau d'origine
+static_assert(STOCK_BRICK_COUNT == BRICK_ROWS * BRICKS_PER_ROW, "Stock level has no empty cell");
+static_assert(STOCK_LEVEL.cells[0][0].kind == CellKind::WALL &&
+              STOCK_LEVEL.cells[0][BRICKS_PER_ROW - 1].kind == CellKind::WALL &&
+              STOCK_LEVEL.cells[0][1].kind == CellKind::REFLECTIVE &&
+              STOCK_LEVEL.cells[0][BRICKS_PER_ROW - 2].kind == CellKind::REFLECTIVE,
+              "Stock level top corners are walls");
+static_assert(countStockCells([](const LevelCell &cell) { return cell.hits == 2; }) >= BRICK_ROWS - 1,
+              "Stock level has a counter brick per row (the top one may fall on a wall)");
+static_assert(countStockCells([](const LevelCell &cell) {
+                  return cell.bonus != NO_BONUS && (cell.bonus < 0 || cell.bonus >= 7);
+              }) == 0, "Stock level bonus types are in range");
+static_assert(countStockCells([](const LevelCell &cell) { return cell.bonus != NO_BONUS; }) >= BRICK_ROWS - 1,
+              "Stock level has a bonus brick per row (the top one may fall on a wall)");
+static_assert(STOCK_BRICKS.blocks[STOCK_BRICK_COUNT - 1].points == 1 && STOCK_BRICKS.blocks[0].hitCounter == -1,
+              "Stock bricks are baked from the stock cells");
+
+const LevelData &stockLevel() {
+    static const LevelData level = [] {
+        LevelData data;
+        data.width = BRICKS_PER_ROW;
+        data.height = BRICK_ROWS;
+        data.cells.assign(&STOCK_LEVEL.cells[0][0], &STOCK_LEVEL.cells[0][0] + BRICK_ROWS * BRICKS_PER_ROW);
+        return data;
+    }();
+    return level;
+}
+
+// Niveau plein des benchmarks : couleurs, compteurs 1 à 3 et un bonus toutes les 5 cellules en alternance
+LevelData makeBenchmarkLevel(int width, int height) {
+    LevelData level;
+    level.resize(width, height);
+    for (size_t i = 0; i < level.cells.size(); ++i) {
+        level.cells[i].kind = static_cast<CellKind>(1 + i % 4);
+        level.cells[i].hits = static_cast<uint8_t>(1 + i % 3);
+        level.cells[i].bonus = static_cast<int8_t>(i % 5 == 0 ? i % 8 : NO_BONUS);
+    }
+    return level;
+}
+
+void saveLevelFile(const std::string &path, const LevelData &level) {
+    std::vector<uint8_t> buffer;
+    StateWriter writer(buffer);
+    writer.writeScalar(LEVEL_MAGIC);
+    writer.writeScalar(static_cast<int32_t>(level.width));
+    writer.writeScalar(static_cast<int32_t>(level.height));
+    writer.writeArray(level.cells);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write level file " + path);
+    }
+}
+
+LevelData loadLevelFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open level file " + path);
+    }
+    const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    StateReader reader(buffer.data(), buffer.size());
+    if (reader.version() < 2 || reader.readScalar<uint32_t>() != LEVEL_MAGIC) {
+        throw std::runtime_error(path + " is not a level file");
+    }
+    LevelData level;
+    level.width = reader.readScalar<int32_t>();
+    level.height = reader.readScalar<int32_t>();
+    reader.readArray(level.cells);
+    for (const LevelCell &cell: level.cells) {
+        StateReader::requireInRange(isValidCell(cell));
+    }
+    if (!isLevelSize(level.width, level.height) ||
+        level.cells.size() != static_cast<size_t>(level.width) * level.height) {
+        throw std::runtime_error(path + ": inconsistent level size");
+    }
+    return level;
+}
+
+// Géométrie des briques d'un niveau dans les limites du monde. Les niveaux plus hauts que
+// le niveau d'origine sont compressés verticalement pour tenir dans la moitié haute.
+struct LevelGeometry {
+    float brickWidth;
+    float brickHeight;
+    float gapX;
+    float gapY;
+    float startX;
+
+    LevelGeometry(int columns, int rows, float boundX) {
+        const float rowScale = std::min(1.0f, LEVEL_AREA_HEIGHT / (rows * (BRICK_HEIGHT + BRICK_GAP)));
+        gapX = BRICK_GAP * std::min(1.0f, static_cast<float>(BRICKS_PER_ROW) / columns);
+        gapY = BRICK_GAP * rowScale;
+        brickHeight = BRICK_HEIGHT * rowScale;
+        float totalGridWidth = 2 * boundX;
+        float totalGapWidth = (columns - 1) * gapX;
+        brickWidth = (totalGridWidth - totalGapWidth) / columns;
+        startX = -boundX;
+    }
+
+    void place(Block &block) const {
+        block.size = Vec2{brickWidth, brickHeight};
+        block.position = Vec2{
+            startX + block.column * (brickWidth + gapX),
+            BRICK_START_Y - block.row * (brickHeight + gapY)
+        };
+    }
+};
+
+// Ordre en Z (Morton) : les bits de la colonne et de la rangée sont entrelacés, donc des
+// cellules voisines dans les deux directions restent proches en mémoire (un bloc de 4x4
+// cellules de 4 octets tient dans une ligne de cache). Utilisé pour les grands niveaux par
+// le rangement des briques et par l'index de collision.
+constexpr int MORTON_MIN_CELLS = 1 << 16; // En dessous, le rangement ligne par ligne tient en cache
+
+constexpr uint32_t mortonSpread(uint32_t v) {
+    v &= 0xFFFFu;
+    v = (v | v << 8) & 0x00FF00FFu;
+    v = (v | v << 4) & 0x0F0F0F0Fu;
+    v = (v | v << 2) & 0x33333333u;
+    v = (v | v << 1) & 0x55555555u;
+    return v;
+}
+
+constexpr uint32_t mortonCompact(uint32_t v) {
+    v &= 0x55555555u;
+    v = (v | v >> 1) & 0x33333333u;
+    v = (v | v >> 2) & 0x0F0F0F0Fu;
+    v = (v | v >> 4) & 0x00FF00FFu;
+    v = (v | v >> 8) & 0x0000FFFFu;
+    return v;
+}
+
+constexpr uint32_t mortonEncode(uint32_t column, uint32_t row) { return mortonSpread(column) | mortonSpread(row) << 1; }
+constexpr uint32_t mortonColumn(uint32_t code) { return mortonCompact(code); }
+constexpr uint32_t mortonRow(uint32_t code) { return mortonCompact(code >> 1); }
+
+static_assert(mortonEncode(0, 0) == 0 && mortonEncode(1, 0) == 1 && mortonEncode(0, 1) == 2 && mortonEncode(3, 3) == 15,
+              "Morton: entrelacement colonne (bits pairs) / rangée (bits impairs)");
+static_assert(mortonColumn(mortonEncode(1023, 517)) == 1023 && mortonRow(mortonEncode(1023, 517)) == 517,
+              "Morton: décodage inverse de l'encodage");
+
+// Un niveau très allongé (4096x16) étale ses codes de Morton sur bien plus de cellules que
+// la grille n'en a : au-delà de ce facteur, AUTO garde le rangement ligne par ligne.
+constexpr int64_t MORTON_MAX_SPREAD = 2;
+
+enum class BrickLayout : uint8_t {
+    AUTO, // Morton à partir de MORTON_MIN_CELLS cellules pour un niveau à peu près carré, ligne par ligne sinon
+    ROW_MAJOR,
+    MORTON
+};
+
+// Ligne par ligne dans tous les cas au-delà de MAX_LEVEL_SIDE : les codes de Morton n'ont que 16 bits par axe
+inline bool useMortonLayout(BrickLayout layout, int columns, int rows) {
+    if (!isLevelSize(columns, rows) || layout == BrickLayout::ROW_MAJOR) return false;
+    if (layout == BrickLayout::MORTON) return true;
+    const int64_t cells = static_cast<int64_t>(columns) * rows;
+    const int64_t codes = static_cast<int64_t>(mortonEncode(columns - 1, rows - 1)) + 1;
+    return cells >= MORTON_MIN_CELLS && codes <= cells * MORTON_MAX_SPREAD;
+}
+
+//-----------------------------------------------------------------------------
+// Game World (simulation)
+//-----------------------------------------------------------------------------
+// Entrée du joueur pour un pas de simulation, en coordonnées du monde
+struct PlayerInput {
+    float pointerX = 0.0f; // Position visée par le centre de la raquette
+    bool launch = false; // Lancer la balle si elle est collée à la raquette
+};
+
+// Réglages de gameplay : valeurs d'origine par défaut, modifiables par partie pour
+// l'équilibrage (--balance balaie des grilles de ces paramètres).
+struct GameTuning {
+    float paddleWidth = PADDLE_WIDTH;
+    float speedIncrement = BALL_SPEED_INCREMENT; // Facteur de chaque accélération de la balle
+    int firstSpeedUpHits = 4; // Briques touchées avant la 1re accélération
+    int secondSpeedUpHits = 12; // ... et avant la 2e
+    float paddleWiden = 1.25f; // Bonus PADDLE_WIDEN
+    float paddleShrink = 0.75f; // Bonus PADDLE_SHRINK
+    float ballSlow = 0.8f; // Bonus BALL_SLOW
+    float ballFast = 1.2f; // Bonus BALL_FAST
+};
+
+// Événement de gameplay, empilé par le monde si recordEvents (voir Event Stream)
+enum class GameEventType : uint8_t { BRICK_DESTROYED = 1, BONUS_SPAWNED, BONUS_CAUGHT, LIFE_LOST, LEVEL_UP };
+
+struct GameEvent {
+    GameEventType type = GameEventType::BRICK_DESTROYED;
+    int8_t bonus = NO_BONUS; // Bonus libéré ou attrapé, NO_BONUS sinon
+    int16_t row = -1; // Cellule de la brique détruite ou qui a libéré le bonus, -1 sinon
+    int16_t column = -1;
+    int32_t value = 0; // Points de la brique, vies restantes ou nouveau niveau selon le type
+    int32_t score = 0; // Score après l'événement
+};
+
+template<>
+struct EnumRange<GameEventType> {
+    static constexpr int64_t min = static_cast<int64_t>(GameEventType::BRICK_DESTROYED);
+    static constexpr int64_t max = static_cast<int64_t>(GameEventType::LEVEL_UP);
+};
+
+#define GAME_EVENT_FIELDS(F) F(2, type) F(2, bonus) F(2, row) F(2, column) F(2, value) F(2, score)
+BREAKOUT_SCHEMA(GameEvent, GAME_EVENT_FIELDS)
+
+// Empreintes d'état (déterminisme) : finaliseur splitmix64 et combinaison ordonnée
+inline uint64_t mixHash(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t hashCombine(uint64_t hash, uint64_t value) { return mixHash(hash ^ (value + 0x9E3779B97F4A7C15ull)); }
+
+inline uint64_t hashFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits)); // Bit à bit : -0.0 et 0.0 diffèrent, c'est voulu
+    return bits;
+}
+
+// Briques vivantes en tableau dense, parcouru à chaque frame par le rendu et le test de fin
+// de niveau. La poignée d'une brique est son index dans GameWorld::blocks, qui ne bouge
+// jamais : empreintes, synchronisation réseau et sauvegardes continuent d'indexer ce
+// tableau. Une brique détruite est retirée en O(1) en échangeant sa place avec la dernière.
+class LiveBrickSet {
+public:
+    static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    void rebuild(const std::vector<Block> &blocks) {
+        handles.clear();
+        slots.assign(blocks.size(), NO_SLOT);
+        destructible = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!blocks[i].active) continue;
+            slots[i] = static_cast<uint32_t>(handles.size());
+            handles.push_back(static_cast<uint32_t>(i));
+            destructible += !blocks[i].isWall;
+        }
+    }
+
+    void remove(const Block &block, uint32_t handle) {
+        const uint32_t slot = slots[handle];
+        if (slot == NO_SLOT) return;
+        const uint32_t last = handles.back();
+        slots[last] = slot;
+        handles[slot] = last;
+        handles.pop_back();
+        slots[handle] = NO_SLOT;
+        destructible -= !block.isWall;
+    }
+
+    const std::vector<uint32_t> &live() const { return handles; } // Dans l'ordre de blocks au départ
+    int destructibleLeft() const { return destructible; } // Briques vivantes hors murs
+
+private:
+    std::vector<uint32_t> handles;
+    std::vector<uint32_t> slots; // Par poignée : place dans handles, NO_SLOT si la brique est morte
+    int destructible = 0;
+};
+
+// Index de collision : poignée de la brique vivante de chaque cellule du niveau (NO_SLOT si
+// vide ou détruite), rangé ligne par ligne ou en ordre de Morton. Toutes les briques d'une
+// rangée ont le même y et celles d'une colonne le même x : les bornes exactes de chaque
+// rangée et colonne suffisent à savoir quelles cellules la balle recouvre, et une requête ne
+// lit que ces cellules, sans toucher aux briques elles-mêmes.
+class BrickGridIndex {
+public:
+    void rebuild(const std::vector<Block> &blocks, int levelColumns, int levelRows, bool useMorton,
+                 const LevelGeometry &geometry) {
+        columns = levelColumns;
+        rows = levelRows;
+        morton = useMorton;
+        const size_t size = columns <= 0 || rows <= 0 ? 0
+                            : morton ? static_cast<size_t>(mortonEncode(columns - 1, rows - 1)) + 1
+                            : static_cast<size_t>(columns) * rows;
+        cells.assign(size, LiveBrickSet::NO_SLOT);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            const Block &block = blocks[i];
+            if (block.active && contains(block)) {
+                cells[cellIndex(block.row, block.column)] = static_cast<uint32_t>(i);
+            }
+        }
+        updateBounds(blocks, geometry);
+    }
+
+    // Bornes recopiées des briques (mêmes flottants que checkCollision), après tout placement
+    void updateBounds(const std::vector<Block> &blocks, const LevelGeometry &geometry) {
+        startX = geometry.startX;
+        pitchX = geometry.brickWidth + geometry.gapX;
+        pitchY = geometry.brickHeight + geometry.gapY;
+        const float none = std::numeric_limits<float>::quiet_NaN(); // Rangée ou colonne sans brique : jamais touchée
+        columnBounds.assign(static_cast<size_t>(std::max(columns, 0)) * 2, none);
+        rowBounds.assign(static_cast<size_t>(std::max(rows, 0)) * 2, none);
+        for (const Block &block: blocks) {
+            if (!contains(block)) continue;
+            columnBounds[block.column * 2] = block.position.x;
+            columnBounds[block.column * 2 + 1] = block.position.x + block.size.x;
+            rowBounds[block.row * 2] = block.position.y;
+            rowBounds[block.row * 2 + 1] = block.position.y + block.size.y;
+        }
+    }
+
+    void remove(const Block &block) {
+        if (contains(block)) cells[cellIndex(block.row, block.column)] = LiveBrickSet::NO_SLOT;
+    }
+
+    size_t cellIndex(int row, int column) const {
+        return morton ? mortonEncode(column, row) : static_cast<size_t>(row) * columns + column;
+    }
+
+    bool isMorton() const { return morton; }
+
+    // Première brique vivante (rangée puis colonne croissantes) recoupant ]x0, x1[ x ]y0, y1[,
+    // avec les mêmes comparaisons que checkCollision ; NO_SLOT sinon
+    uint32_t firstHit(float x0, float y0, float x1, float y1) const {
+        if (cells.empty()) return LiveBrickSet::NO_SLOT;
+        // Plage approchée par le pas de la grille (une cellule de marge), affinée par les bornes exactes
+        const int rowBegin = clampCell(std::floor((BRICK_START_Y - y1) / pitchY) - 1.0f, rows);
+        const int rowEnd = clampCell(std::ceil((BRICK_START_Y - y0) / pitchY) + 2.0f, rows);
+        const int columnBegin = clampCell(std::floor((x0 - startX) / pitchX) - 1.0f, columns);
+        const int columnEnd = clampCell(std::ceil((x1 - startX) / pitchX) + 1.0f, columns);
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            if (!(y0 < rowBounds[row * 2 + 1] && y1 > rowBounds[row * 2])) continue;
+            for (int column = columnBegin; column < columnEnd; ++column) {
+                if (!(x0 < columnBounds[column * 2 + 1] && x1 > columnBounds[column * 2])) continue;
+                const uint32_t handle = cells[cellIndex(row, column)];
+                if (handle != LiveBrickSet::NO_SLOT) return handle;
+            }
+        }
+        return LiveBrickSet::NO_SLOT;
+    }
+
+private:
+    std::vector<uint32_t> cells;
+    std::vector<float> columnBounds; // x gauche, x droit par colonne
+    std::vector<float> rowBounds; // y bas, y haut par rangée
+    int columns = 0, rows = 0;
+    bool morton = false;
+    float startX = 0.0f, pitchX = 1.0f, pitchY = 1.0f;
+
+    bool contains(const Block &block) const {
+        return block.row >= 0 && block.row < rows && block.column >= 0 && block.column < columns;
+    }
+
+    static int clampCell(float value, int count) {
+        return static_cast<int>(std::min(std::max(value, 0.0f), static_cast<float>(count)));
+    }
+};
+
+// État complet d'une partie et sa logique, sans fenêtre ni rendu : plusieurs mondes
+// peuvent tourner côte à côte (vue en grille, simulations en lot).
+struct GameWorld {
+    float gameBoundX = 1.0f; // World coordinate boundaries (-1.0f to 1.0f)
+    float gameBoundY = 1.0f;
+
+    // --- Game Objects ---
+    Paddle playerPaddle;
+    Ball gameBall;
+    std::vector<Block> blocks;
+    // À reconstruire (rebuildBrickIndex) après toute modification directe de blocks
+    LiveBrickSet liveBricks;
+    BrickGridIndex brickGrid;
+    BrickLayout brickLayout = BrickLayout::AUTO; // Rangement de blocks pour les niveaux personnalisés
+    int score = 0;
+    int lives = 3;
+    int currentLevel = 1;
+    bool gameOver = false;
+
+    // --- Level ---
+    std::shared_ptr<const LevelData> level; // nullptr = niveau d'origine
+    int levelColumns = BRICKS_PER_ROW;
+    int levelRows = BRICK_ROWS;
+
+    GameTuning tuning;
+
+    //--- Bonus Objects ---
+    std::vector<FallingBonus> fallingBonuses;
+    float bonusFallSpeed = 1.0f; // Vitesse pour tomber en 2 secondes
+
+    uint32_t rngState = 0x9E3779B9u; // Générateur propre au monde (xorshift32)
+
+    // XOR des empreintes de chaque brique (compteur, active), mis à jour à chaque
+    // brique touchée : l'empreinte par tick ne reparcourt pas toutes les briques.
+    uint64_t brickHash = 0;
+
+    // Pour le rembobinage : briques touchées depuis la dernière lecture (si trackBrickChanges),
+    // et compteur incrémenté à chaque remplacement de blocks (nouveau niveau, chargement)
+    bool trackBrickChanges = false;
+    std::vector<uint32_t> changedBricks;
+    uint32_t layoutGeneration = 0;
+
+    // Événements de gameplay depuis la dernière lecture (si recordEvents)
+    bool recordEvents = false;
+    std::vector<GameEvent> events;
+
+    void pushEvent(GameEventType type, int bonus, int row, int column, int value) {
+        if (!recordEvents) return;
+        GameEvent event;
+        event.type = type;
+        event.bonus = static_cast<int8_t>(bonus);
+        event.row = static_cast<int16_t>(row);
+        event.column = static_cast<int16_t>(column);
+        event.value = value;
+        event.score = score;
+        events.push_back(event);
+    }
+
+    static uint64_t brickHashTerm(size_t index, const Block &block) {
+        return mixHash((static_cast<uint64_t>(index) << 32) ^ (static_cast<uint32_t>(block.hitCounter) << 1) ^
+                       static_cast<uint64_t>(block.active));
+    }
+
+    uint64_t computeBrickHash() const {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            hash ^= brickHashTerm(i, blocks[i]);
+        }
+        return hash;
+    }
+
+    void rehashBricks() { brickHash = computeBrickHash(); }
+
+    void rebuildBrickIndex() {
+        ++layoutGeneration;
+        liveBricks.rebuild(blocks);
+        brickGrid.rebuild(blocks, levelColumns, levelRows, useMortonLayout(brickLayout, levelColumns, levelRows),
+                          LevelGeometry(levelColumns, levelRows, gameBoundX));
+    }
+
+    // Empreinte de tout l'état simulé : briques (incrémental) + champs dynamiques
+    uint64_t stateHash() const {
+        uint64_t h = hashCombine(brickHash, blocks.size());
+        h = hashCombine(h, hashFloat(gameBoundX));
+        h = hashCombine(h, hashFloat(gameBoundY));
+        h = hashCombine(h, hashFloat(playerPaddle.position.x));
+        h = hashCombine(h, hashFloat(playerPaddle.position.y));
+        h = hashCombine(h, hashFloat(playerPaddle.size.x));
+        h = hashCombine(h, static_cast<uint64_t>(playerPaddle.firstContactRed) |
+                           static_cast<uint64_t>(playerPaddle.firstContactOrange) << 1 |
+                           static_cast<uint64_t>(playerPaddle.isShrunk) << 2);
+        h = hashCombine(h, hashFloat(gameBall.position.x));
+        h = hashCombine(h, hashFloat(gameBall.position.y));
+        h = hashCombine(h, hashFloat(gameBall.velocity.x));
+        h = hashCombine(h, hashFloat(gameBall.velocity.y));
+        h = hashCombine(h, hashFloat(gameBall.speedMagnitude));
+        h = hashCombine(h, static_cast<uint64_t>(gameBall.stuckToPaddle) | static_cast<uint64_t>(gameBall.hitCount) << 1);
+        h = hashCombine(h, static_cast<uint32_t>(score) | static_cast<uint64_t>(static_cast<uint32_t>(lives)) << 32);
+        h = hashCombine(h, static_cast<uint32_t>(currentLevel) | static_cast<uint64_t>(gameOver) << 32);
+        h = hashCombine(h, rngState);
+        for (const FallingBonus &bonus: fallingBonuses) {
+            h = hashCombine(h, hashFloat(bonus.position.x) | hashFloat(bonus.position.y) << 32);
+            h = hashCombine(h, static_cast<uint64_t>(bonus.type) | static_cast<uint64_t>(bonus.active) << 8);
+        }
+        return h;
+    }
+
+    uint32_t nextRandom() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 17;
+        rngState ^= rngState << 5;
+        return rngState;
+    }
+
+    // Nouvelles limites du monde (redimensionnement de la fenêtre)
+    void setBounds(float boundX, float boundY) {
+        const float oldBoundX = gameBoundX;
+        const float oldBoundY = gameBoundY;
+        gameBoundX = boundX;
+        gameBoundY = boundY;
+
+        // Ajuster la vitesse en fonction du changement des dimensions du monde
+        if (!gameOver && !gameBall.stuckToPaddle) {
+            // Calculer le facteur d'échelle pour la vitesse
+            float speedScaleFactor = (gameBoundX / oldBoundX + gameBoundY / oldBoundY) / 2.0f;
+
+            // Appliquer ce facteur à la vitesse actuelle de la balle
+            float currentSpeed = std::sqrt(gameBall.velocity.x * gameBall.velocity.x +
+                                           gameBall.velocity.y * gameBall.velocity.y);
+
+            if (currentSpeed > 0.0001f) {
+                // Maintenir la direction, mais ajuster la magnitude
+                gameBall.velocity.x *= speedScaleFactor;
+                gameBall.velocity.y *= speedScaleFactor;
+
+                // Mettre à jour speedMagnitude pour les futurs calculs
+                gameBall.speedMagnitude *= speedScaleFactor;
+            }
+        }
+
+        // Réinitialiser les blocs et autres éléments si nécessaire
+        if (!blocks.empty())
+            updateBlockPositions();
+    }
+
+    // Déplacement de la raquette vers le pointeur et lancement de la balle
+    void applyInput(const PlayerInput &input, const float dt) {
+        if (gameOver) {
+            return;
+        }
+        float moveSpeed = PADDLE_SPEED*gameBall.speedMagnitude; // Vitesse de déplacement de la raquette
+        float targetX = input.pointerX - playerPaddle.size.x / 2.0f;
+        float currentX = playerPaddle.position.x;
+        float direction = (targetX > currentX) ? 1.0f : -1.0f;
+        float distance = std::abs(targetX - currentX);
+
+        // Déplacement progressif
+        if (distance > 0.001f) {
+            float movement = moveSpeed * dt;
+            movement = std::min(movement, distance);
+            playerPaddle.position.x = std::max(-gameBoundX,std::min(gameBoundX-playerPaddle.size.x,playerPaddle.position.x+direction * movement));
+        }
+        // Launch Ball
+        if (gameBall.stuckToPaddle && input.launch) {
+            gameBall.stuckToPaddle = false;
+            const float ballDirection = nextRandom() % 2 ? 1.0f : -1.0f;
+            const float velocityX = ballDirection * gameBall.speedMagnitude;
+            const float velocityY = gameBall.speedMagnitude;
+
+            gameBall.velocity = Vec2{velocityX, velocityY};
+            normalizeVelocity();
+        }
+    }
+
+    void initGame() {
+        score = 0;
+        lives = 3;
+        currentLevel = 1;
+        gameOver = false;
+        fallingBonuses.clear();
+        initBlocks();
+        resetPlayerAndBall();
+    }
+
+    void saveState(std::vector<uint8_t> &out) const {
+        StateWriter writer(out);
+        writer.write(GameCounters{score, lives, currentLevel, levelColumns, levelRows});
+        writer.write(playerPaddle);
+        writer.write(gameBall);
+        writer.writeArray(blocks);
+        writer.writeArray(fallingBonuses);
+    }
+
+    void loadState(const uint8_t *data, size_t size) { loadState(data, size, gameBoundX, gameBoundY); }
+
+    // Décode et indexe dans des temporaires : en cas d'erreur l'état courant reste intact.
+    // boundX/boundY : limites du monde à adopter avec l'état (keyframe de spectateur).
+    void loadState(const uint8_t *data, size_t size, float boundX, float boundY) {
+        StateReader reader(data, size);
+        GameCounters counters;
+        Paddle paddle;
+        Ball ball;
+        std::vector<Block> loadedBlocks;
+        std::vector<FallingBonus> loadedBonuses;
+        reader.read(counters);
+        reader.read(paddle);
+        reader.read(ball);
+        reader.readArray(loadedBlocks);
+        reader.readArray(loadedBonuses);
+        for (const Block &block: loadedBlocks) {
+            StateReader::requireInRange(isBonusType(block.bonusType));
+        }
+        for (const FallingBonus &bonus: loadedBonuses) {
+            StateReader::requireInRange(isBonusType(bonus.type));
+        }
+        if (reader.version() < 2) {
+            // Les sauvegardes v1 ne contiennent que le niveau d'origine, rangée par rangée
+            for (size_t i = 0; i < loadedBlocks.size(); ++i) {
+                loadedBlocks[i].row = static_cast<int>(i) / BRICKS_PER_ROW;
+                loadedBlocks[i].column = static_cast<int>(i) % BRICKS_PER_ROW;
+            }
+        }
+        StateReader::requireInRange(isLevelSize(counters.levelColumns, counters.levelRows));
+        for (const Block &block: loadedBlocks) {
+            StateReader::requireInRange(block.row >= 0 && block.row < counters.levelRows && block.column >= 0 &&
+                                        block.column < counters.levelColumns);
+        }
+
+        // Placement adapté aux limites du monde, puis index : les allocations peuvent encore échouer
+        const LevelGeometry geometry(counters.levelColumns, counters.levelRows, boundX);
+        for (auto &block: loadedBlocks) {
+            geometry.place(block);
+        }
+        LiveBrickSet loadedLive;
+        BrickGridIndex loadedGrid;
+        loadedLive.rebuild(loadedBlocks);
+        loadedGrid.rebuild(loadedBlocks, counters.levelColumns, counters.levelRows,
+                           useMortonLayout(brickLayout, counters.levelColumns, counters.levelRows), geometry);
+
+        gameBoundX = boundX;
+        gameBoundY = boundY;
+        score = counters.score;
+        lives = counters.lives;
+        currentLevel = counters.currentLevel;
+        levelColumns = counters.levelColumns;
+        levelRows = counters.levelRows;
+        playerPaddle = paddle;
+        gameBall = ball;
+        blocks.swap(loadedBlocks);
+        fallingBonuses.swap(loadedBonuses);
+        liveBricks = std::move(loadedLive);
+        brickGrid = std::move(loadedGrid);
+        ++layoutGeneration;
+        gameOver = false;
+        rehashBricks();
+    }
+
+    void spawnBonus(const Block &block) {
+        FallingBonus bonus;
+        bonus.position = block.position;
+        bonus.size = Vec2{gameBall.size.x, gameBall.size.y}; // Plus petit que la brique
+        bonus.type = block.bonusType;
+        bonus.fallSpeed = bonusFallSpeed;
+        bonus.active = true;
+
+        switch (bonus.type) {
+            case LIFE_ADD: bonus.color = Color{1.0f, 0.5f, 0.0f, 1.0f};
+                break; // Orange
+            case LIFE_REMOVE: bonus.color = Color{1.0f, 0.0f, 0.0f, 1.0f};
+                break; // Rouge
+            case PADDLE_WIDEN: bonus.color = Color{1.0f, 1.0f, 0.0f, 1.0f};
+                break; // Jaune
+            case PADDLE_SHRINK: bonus.color = Color{0.0f, 1.0f, 0.0f, 1.0f};
+                break; // Vert
+            case BALL_SLOW: bonus.color = Color{0.0f, 1.0f, 1.0f, 1.0f};
+                break; // Cyan
+            case BALL_FAST: bonus.color = Color{0.0f, 0.0f, 1.0f, 1.0f};
+                break; // Bleu
+            case BALL_STRAIGHTEN: bonus.color = Color{1.0f, 1.0f, 1.0f, 1.0f};
+                break; // Blanc
+            case BALL_ANGLE: bonus.color = Color{0.5f, 0.5f, 0.5f, 1.0f};
+                break; // Gris
+            default: bonus.color = Color{1.0f, 1.0f, 1.0f, 1.0f}; // Blanc par défaut
+        }
+
+        fallingBonuses.push_back(bonus);
+        pushEvent(GameEventType::BONUS_SPAWNED, bonus.type, block.row, block.column, 0);
+    }
+
+    void applyBonus(const FallingBonus &bonus) {
+        pushEvent(GameEventType::BONUS_CAUGHT, bonus.type, -1, -1, 0);
+        switch (bonus.type) {
+            case LIFE_ADD:
+                lives = std::min(lives + 1, 5); // Maximum 5 vies
+                break;
+            case LIFE_REMOVE:
+                lives = std::max(lives - 1, 1); // Minimum 1 vie
+                break;
+            case PADDLE_WIDEN:
+                playerPaddle.size.x *= tuning.paddleWiden; // 25% plus large
+                playerPaddle.size.x = std::min(playerPaddle.size.x, gameBoundX * 0.75f); // Limiter la taille
+                break;
+            case PADDLE_SHRINK:
+                playerPaddle.size.x *= tuning.paddleShrink; // 25% plus petit
+                playerPaddle.size.x = std::max(playerPaddle.size.x, tuning.paddleWidth * 0.5f); // Taille minimale
+                break;
+            case BALL_SLOW:
+                gameBall.speedMagnitude *= tuning.ballSlow; // 20% plus lente
+                normalizeVelocity();
+                break;
+            case BALL_FAST:
+                gameBall.speedMagnitude *= tuning.ballFast; // 20% plus rapide
+                normalizeVelocity();
+                break;
+            case BALL_STRAIGHTEN:
+                // Redresser la trajectoire
+                if (std::abs(gameBall.velocity.x) > 0.1f) {
+                    float sign = gameBall.velocity.x > 0 ? 1.0f : -1.0f;
+                    gameBall.velocity.x = sign * gameBall.speedMagnitude * 0.2f; // Réduit la composante horizontale
+                    gameBall.velocity.y = gameBall.velocity.y > 0
+                                              ? std::sqrt(
+                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
+                                                  x *
+                                                  gameBall.velocity.x)
+                                              : -std::sqrt(
+                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
+                                                  x *
+                                                  gameBall.velocity.x);
+                }
+                break;
+            case BALL_ANGLE:
+                // Incliner davantage la trajectoire
+                if (std::abs(gameBall.velocity.y) > 0.1f) {
+                    float sign = gameBall.velocity.x > 0 ? 1.0f : -1.0f;
+                    gameBall.velocity.x = sign * gameBall.speedMagnitude * 0.8f;
+                    // Augmente la composante horizontale (80% de la vitesse normalisée est horizontale
+                    gameBall.velocity.y = gameBall.velocity.y > 0
+                                              ? std::sqrt(
+                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
+                                                  x *
+                                                  gameBall.velocity.x)
+                                              : -std::sqrt(
+                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
+                                                  x *
+                                                  gameBall.velocity.x);
+                }
+                break;
+            default: break;
+        }
+    }
+
+    // Construit les briques à partir du niveau courant (niveau d'origine par défaut)
+    void initBlocks() {
+        const LevelData &source = level ? *level : stockLevel();
+        levelColumns = source.width;
+        levelRows = source.height;
+        const LevelGeometry geometry(levelColumns, levelRows, gameBoundX);
+
+        if (!level) {
+            // Niveau d'origine : briques précalculées à la compilation, seule la géométrie dépend de la fenêtre
+            blocks.assign(std::begin(STOCK_BRICKS.blocks), std::end(STOCK_BRICKS.blocks));
+            for (auto &block: blocks) {
+                geometry.place(block);
+            }
+            rehashBricks();
+            rebuildBrickIndex();
+            return;
+        }
+
+        blocks.clear();
+        const auto addCell = [&](int i, int j) {
+            const LevelCell &cell = source.at(i, j);
+            if (cell.kind != CellKind::EMPTY) {
+                Block block = makeBlock(cell, i, j);
+                geometry.place(block);
+                blocks.push_back(block);
+            }
+        };
+        if (useMortonLayout(brickLayout, source.width, source.height)) {
+            // Grand niveau : briques rangées en ordre de Morton (les codes hors de la grille sont sautés)
+            const uint32_t end = mortonEncode(source.width - 1, source.height - 1) + 1;
+            for (uint32_t code = 0; code < end; ++code) {
+                const auto j = static_cast<int>(mortonColumn(code)), i = static_cast<int>(mortonRow(code));
+                if (j < source.width && i < source.height) addCell(i, j);
+            }
+        } else {
+            for (int i = 0; i < source.height; ++i) {
+                for (int j = 0; j < source.width; ++j) {
+                    addCell(i, j);
+                }
+            }
+        }
+        rehashBricks();
+        rebuildBrickIndex();
+    }
+
+    void updateBlockPositions() {
+        // Calculer la nouvelle taille des briques basée sur les limites du jeu actuelles
+        const LevelGeometry geometry(levelColumns, levelRows, gameBoundX);
+
+        // Conserver l'état actif/inactif et autres propriétés, mettre à jour uniquement la position et la taille
+        for (auto &block: blocks) {
+            geometry.place(block);
+        }
+        brickGrid.updateBounds(blocks, geometry);
+    }
+
+    bool checkBonusPaddleCollision(const FallingBonus &bonus) const {
+        return bonus.position.x < playerPaddle.position.x + playerPaddle.size.x &&
+               bonus.position.x + bonus.size.x > playerPaddle.position.x &&
+               bonus.position.y < playerPaddle.position.y + playerPaddle.size.y &&
+               bonus.position.y + bonus.size.y > playerPaddle.position.y;
+    }
+
+    // Reset paddle and ball to starting positions
+    void resetPlayerAndBall() {
+        playerPaddle.isShrunk
+            ? playerPaddle.size = Vec2{tuning.paddleWidth * 0.5f, PADDLE_HEIGHT}
+            : playerPaddle.size = Vec2{tuning.paddleWidth, PADDLE_HEIGHT};
+        playerPaddle.position = Vec2{0.0f - tuning.paddleWidth / 2.0f, PADDLE_Y_POSITION};
+        playerPaddle.color = Color{0.8f, 0.8f, 0.8f, 1.0f};
+
+        gameBall.size = Vec2{BALL_RADIUS * 2.0f, BALL_RADIUS * 2.0f};
+        gameBall.position = Vec2{
+            playerPaddle.position.x + playerPaddle.size.x / 2.0f - BALL_RADIUS,
+            playerPaddle.position.y + playerPaddle.size.y
+        };
+        gameBall.color = Color{1.0f, 1.0f, 1.0f, 1.0f};
+        gameBall.velocity = Vec2{0.0f, 0.0f};
+        gameBall.speedMagnitude = INITIAL_BALL_SPEED;
+        gameBall.stuckToPaddle = true;
+        gameBall.hitCount = 0; // Reset hits
+    }
+
+    void update(const float dt) {
+        if (gameOver) {
+            return;
+        }
+
+        // --- Update Ball Position ---
+        if (gameBall.stuckToPaddle) {
+            gameBall.position = Vec2{
+                playerPaddle.position.x + playerPaddle.size.x / 2.0f - BALL_RADIUS,
+                playerPaddle.position.y + playerPaddle.size.y
+            };
+        } else {
+            gameBall.position.x += gameBall.velocity.x * dt;
+            gameBall.position.y += gameBall.velocity.y * dt;
+
+            // --- Handle Collisions ---
+            handleCollisions();
+
+            // --- Check Lose Condition ---
+            if (gameBall.position.y + gameBall.size.y < -gameBoundY) {
+                // Ball below bottom edge
+                lives--;
+                pushEvent(GameEventType::LIFE_LOST, NO_BONUS, -1, -1, lives);
+                if (lives <= 0) {
+                    gameOver = true;
+                } else {
+                    resetPlayerAndBall(); // Reset ball/paddle for next life
+                }
+            }
+        }
+
+        // Mettre à jour les bonus qui tombent
+        for (auto &bonus: fallingBonuses) {
+            if (bonus.active) {
+                // Faire descendre le bonus
+                bonus.position.y -= bonus.fallSpeed * dt;
+
+                // Vérifier si le bonus a atteint le bas de l'écran
+                if (bonus.position.y < -gameBoundY) {
+                    bonus.active = false;
+                    continue;
+                }
+
+                // Vérifier la collision avec la raquette
+                if (checkBonusPaddleCollision(bonus)) {
+                    applyBonus(bonus);
+                    bonus.active = false;
+                }
+            }
+        }
+
+        // Nettoyage des bonus inactifs
+        fallingBonuses.erase(
+            std::remove_if(fallingBonuses.begin(), fallingBonuses.end(),
+                           [](const FallingBonus &b) { return !b.active; }),
+            fallingBonuses.end()
+        );
+
+        // --- Check Win Condition ---
+        if (liveBricks.destructibleLeft() == 0) {
+            if (lives > 0) // S'il reste des vies, passer au niveau suivant
+            {
+                currentLevel++;
+                pushEvent(GameEventType::LEVEL_UP, NO_BONUS, -1, -1, currentLevel);
+                playerPaddle.firstContactOrange = true;
+                playerPaddle.firstContactRed = true;
+                gameBall.hitCount = 0;
+                initBlocks(); // Générer un nouveau niveau de briques
+                resetPlayerAndBall(); // Réinitialiser la position de la balle et de la raquette
+                // La score est préservé car nous ne le réinitialisons pas
+            } else {
+                gameOver = true;
+            }
+        }
+    }
+
+    static bool checkCollision(const GameObject &one, const GameObject &two) {
+        return one.position.x < two.position.x + two.size.x && one.position.x + one.size.x > two.position.x && one.
+               position.y < two.position.y + two.size.y && one.position.y + one.size.y > two.position.y;
+    }
+
+    void handleCollisions() {
+        handleBallWallCollision();
+        if (checkCollision(gameBall, playerPaddle)) {
+            resolveBallPaddleCollision();
+        }
+        const uint32_t hit = findBrickHit(gameBall);
+        if (hit != LiveBrickSet::NO_SLOT) {
+            resolveBallBlockCollision(blocks[hit]);
+        }
+    }
+
+    // Seules les cellules sous l'objet sont lues. Parmi les briques touchées, la première dans
+    // l'ordre (rangée, colonne) l'emporte : c'est la brique qu'un parcours de blocks rangé
+    // ligne par ligne trouverait en premier, quel que soit le rangement réel.
+    uint32_t findBrickHit(const GameObject &object) const {
+        return brickGrid.firstHit(object.position.x, object.position.y, object.position.x + object.size.x,
+                                  object.position.y + object.size.y);
+    }
+
+    void handleBallWallCollision() {
+        if (gameBall.position.x <= -gameBoundX) {
+            gameBall.velocity.x = std::abs(gameBall.velocity.x);
+            gameBall.position.x = -gameBoundX;
+        } else if (gameBall.position.x + gameBall.size.x >= gameBoundX) {
+            gameBall.velocity.x = -std::abs(gameBall.velocity.x);
+            gameBall.position.x = gameBoundX - gameBall.size.x;
+        }
+        if (gameBall.position.y + gameBall.size.y >= gameBoundY) {
+            //Collision avec le plafond
+            if (!playerPaddle.isShrunk) {
+                playerPaddle.isShrunk = true;
+                playerPaddle.size.x *= 0.5f;
+            }
+            gameBall.velocity.y = -std::abs(gameBall.velocity.y);
+            gameBall.position.y = gameBoundY - gameBall.size.y;
+        }
+    }
+
+    void resolveBallPaddleCollision() {
+        if (gameBall.velocity.y >= 0.0f)
+            return;
+
+        // Repositionnement au-dessus de la raquette
+        gameBall.position.y = playerPaddle.position.y + playerPaddle.size.y;
+
+        // Calcul de l'impact normalisé (-1 = bord gauche, +1 = bord droit)
+        float ballCenterX = gameBall.position.x + gameBall.size.x * 0.5f;
+        float paddleCenterX = playerPaddle.position.x + playerPaddle.size.x * 0.5f;
+        float offset = (ballCenterX - paddleCenterX) / (playerPaddle.size.x * 0.5f);
+        float normalizedOffset = std::max(-1.0f, std::min(offset, 1.0f));
+
+        // Inversion de la composante verticale
+        gameBall.velocity.y = std::abs(gameBall.velocity.y);
+
+        // Définir les seuils pour les quarts de la raquette
+        const float quarterThreshold = 0.5f;
+
+        if (normalizedOffset <= -quarterThreshold) {
+            // Quart gauche : peu de déviation horizontale
+            gameBall.velocity.x = normalizedOffset * gameBall.speedMagnitude * 0.2f;
+
+            // Recalculer la composante verticale pour maintenir la magnitude
+            float vy = std::sqrt(
+                gameBall.speedMagnitude * gameBall.speedMagnitude
+                - gameBall.velocity.x * gameBall.velocity.x
+            );
+            gameBall.velocity.y = vy;
+        } else if (normalizedOffset >= quarterThreshold) {
+            // Quart droit : forte déviation horizontale
+            gameBall.velocity.x = normalizedOffset * gameBall.speedMagnitude * 0.8f;
+
+            // Recalculer la composante verticale pour maintenir la magnitude
+            float vy = std::sqrt(
+                gameBall.speedMagnitude * gameBall.speedMagnitude
+                - gameBall.velocity.x * gameBall.velocity.x
+            );
+            gameBall.velocity.y = vy;
+        }
+    }
+
+    void resolveBallBlockCollision(Block &block) {
+        if (block.isWall) {
+            if (block.isReflective) {
+                // Mur à rétroréflexion
+                gameBall.velocity.x = -gameBall.velocity.x;
+                gameBall.velocity.y = -gameBall.velocity.y;
+            } else {
+                // Mur normal - rebond standard
+                // Déterminer où la balle a frappé la brique
+                float ballCenterX = gameBall.position.x + gameBall.size.x / 2.0f;
+                float ballCenterY = gameBall.position.y + gameBall.size.y / 2.0f;
+                float blockCenterX = block.position.x + block.size.x / 2.0f;
+                float blockCenterY = block.position.y + block.size.y / 2.0f;
+
+                // Calculer les distances relatives
+                float diffX = ballCenterX - blockCenterX;
+                float diffY = ballCenterY - blockCenterY;
+
+                // Déterminer si la collision est horizontale ou verticale
+                if (std::abs(diffX / block.size.x) > std::abs(diffY / block.size.y)) {
+                    // Collision horizontale
+                    gameBall.velocity.x = -gameBall.velocity.x;
+                } else {
+                    // Collision verticale
+                    gameBall.velocity.y = -gameBall.velocity.y;
+                }
+            }
+            return;
+        }
+
+        // Appliquer le rebond d'abord
+        // Déterminer où la balle a frappé la brique
+        float ballCenterX = gameBall.position.x + gameBall.size.x / 2.0f;
+        float ballCenterY = gameBall.position.y + gameBall.size.y / 2.0f;
+        float blockCenterX = block.position.x + block.size.x / 2.0f;
+        float blockCenterY = block.position.y + block.size.y / 2.0f;
+
+        // Calculer les distances relatives
+        float diffX = ballCenterX - blockCenterX;
+        float diffY = ballCenterY - blockCenterY;
+
+        // Déterminer si la collision est horizontale ou verticale
+        if (std::abs(diffX / block.size.x) > std::abs(diffY / block.size.y)) {
+            // Collision horizontale
+            gameBall.velocity.x = -gameBall.velocity.x;
+        } else {
+            // Collision verticale
+            gameBall.velocity.y = -gameBall.velocity.y;
+        }
+
+        // Ajuster légèrement la position pour éviter une nouvelle collision immédiate
+        float signY = (gameBall.velocity.y > 0) ? 1.0f : -1.0f;
+        gameBall.position.y += signY * 0.001f;
+
+        // Ensuite, diminuer le compteur de coups
+        const auto blockIndex = static_cast<size_t>(&block - blocks.data());
+        brickHash ^= brickHashTerm(blockIndex, block);
+        block.hitCounter--;
+        if (trackBrickChanges) {
+            changedBricks.push_back(static_cast<uint32_t>(blockIndex));
+        }
+
+        // Si le compteur atteint 0, désactiver la brique
+        if (block.hitCounter <= 0) {
+            block.active = false;
+            liveBricks.remove(block, static_cast<uint32_t>(blockIndex));
+            brickGrid.remove(block);
+            score += block.points;
+            pushEvent(GameEventType::BRICK_DESTROYED, block.isBonus ? block.bonusType : NO_BONUS, block.row,
+                      block.column, block.points);
+
+            // Logique pour les briques bonus
+            if (block.isBonus) {
+                spawnBonus(block);
+            }
+        } else {
+            block.color = getColorFromEnum(block.colorType);
+        }
+        brickHash ^= brickHashTerm(blockIndex, block);
+
+        // Incrémenter le compteur de coups et appliquer l'augmentation de vitesse
+        gameBall.hitCount++;
+        applySpeedIncrease(block);
+    }
+
+    void applySpeedIncrease(const Block &b) {
+        bool speedIncreased = false;
+        if (gameBall.hitCount == tuning.firstSpeedUpHits || gameBall.hitCount == tuning.secondSpeedUpHits) {
+            gameBall.speedMagnitude *= tuning.speedIncrement;
+            speedIncreased = true;
+        }
+
+        if (playerPaddle.firstContactRed && b.colorType == BrickColor::RED) {
+            gameBall.speedMagnitude *= tuning.speedIncrement;
+            playerPaddle.firstContactRed = false;
+            speedIncreased = true;
+        }
+
+        if (playerPaddle.firstContactOrange && BrickColor::ORANGE == b.colorType) {
+            gameBall.speedMagnitude *= tuning.speedIncrement;
+            playerPaddle.firstContactOrange = false;
+            speedIncreased = true;
+        }
+        if (speedIncreased) {
+            normalizeVelocity();
+        }
+    }
+
+    void normalizeVelocity() {
+        float currentSpeed = std::sqrt(
+            gameBall.velocity.x * gameBall.velocity.x + gameBall.velocity.y * gameBall.velocity.y);
+        if (currentSpeed > 0.0001f) {
+            gameBall.velocity.x = (gameBall.velocity.x / currentSpeed) * gameBall.speedMagnitude;
+            gameBall.velocity.y = (gameBall.velocity.y / currentSpeed) * gameBall.speedMagnitude;
+        } else if (!gameBall.stuckToPaddle) {
+            gameBall.velocity = Vec2{0.0f, gameBall.speedMagnitude};
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Autopilot
+//-----------------------------------------------------------------------------
+// Contrôleur automatique : suit la balle avec un décalage d'impact tiré au hasard à chaque
+// renvoi, pour varier les angles. Son générateur est séparé de celui du monde.
+// skill < 1 simule un joueur moins précis : il vise avec une erreur (jusqu'à une
+// largeur et demie de raquette pour skill = 0) et ne regarde la balle qu'une décision
+// sur REACTION_STEPS_MAX à skill = 0 (temps de réaction).
+struct Autopilot {
+    static constexpr int REACTION_STEPS_MAX = 12;
+
+    uint32_t rngState = 0x2545F491u;
+    float aimOffset = 0.0f; // Fraction de la demi-largeur de la raquette (-1..1)
+    bool wasDescending = false;
+    float skill = 1.0f;
+    float aimError = 0.0f; // Erreur de visée courante (unités du monde)
+    int reactionSteps = 1;
+    int stepsUntilLook = 0;
+    float lastPointerX = 0.0f;
+
+    explicit Autopilot(uint32_t seed = 0x2545F491u, float skillLevel = 1.0f)
+        : rngState(seed ? seed : 1u), skill(std::max(0.0f, std::min(skillLevel, 1.0f))) {
+        reactionSteps = 1 + static_cast<int>((1.0f - skill) * (REACTION_STEPS_MAX - 1));
+    }
+
+    uint32_t nextRandom() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 17;
+        rngState ^= rngState << 5;
+        return rngState;
+    }
+
+    PlayerInput decide(const GameWorld &world) {
+        const Ball &ball = world.gameBall;
+        const Paddle &paddle = world.playerPaddle;
+        const bool descending = ball.velocity.y < 0.0f;
+        if (descending && !wasDescending) {
+            aimOffset = static_cast<float>(nextRandom() % 1000) / 500.0f - 1.0f;
+            if (skill < 1.0f) {
+                const float spread = static_cast<float>(nextRandom() % 1000) / 500.0f - 1.0f;
+                aimError = spread * (1.0f - skill) * paddle.size.x * 1.5f;
+            }
+        }
+        wasDescending = descending;
+
+        PlayerInput input;
+        if (--stepsUntilLook <= 0) {
+            const float ballCenterX = ball.position.x + ball.size.x * 0.5f;
+            lastPointerX = ballCenterX - aimOffset * paddle.size.x * 0.5f + aimError;
+            stepsUntilLook = reactionSteps;
+        }
+        input.pointerX = lastPointerX;
+        input.launch = ball.stuckToPaddle;
+        return input;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Batch Runner
+//-----------------------------------------------------------------------------
+// Les simulations en lot (--generate, --balance, --check-determinism) répartissent des
+// tâches indépendantes sur des threads. Sur une machine à plusieurs noeuds NUMA, chaque
+// thread est épinglé sur les coeurs d'un noeud avant toute allocation : les parties qu'il
+// joue (GameWorld, générateurs, autopilote) et ses résultats (parallelMap) sont créés par
+// lui, dans son arène malloc, et le noyau place leurs pages sur son noeud au premier accès. Chaque
+// noeud reçoit une plage contiguë de tâches et ses propres compteurs ; ses threads ne
+// prennent les tâches d'un autre noeud qu'avec --numa=steal.
+
+// CPU utilisables de chaque noeud, d'après /sys/devices/system/node
+struct NumaTopology {
+    std::vector<int> nodeIds;
+    std::vector<std::vector<int>> nodeCpus;
+
+    int nodeCount() const { return static_cast<int>(nodeIds.size()); }
+};
+
+// Liste au format du noyau : "0-3,8,10-11"
+std::vector<int> parseCpuList(const std::string &text) {
+    std::vector<int> cpus;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find(',', begin);
+        if (end == std::string::npos) end = text.size();
+        int first = 0, last = 0;
+        const int fields = std::sscanf(text.c_str() + begin, "%d-%d", &first, &last);
+        if (fields >= 1) {
+            for (int cpu = first; cpu <= (fields == 2 ? last : first); ++cpu) cpus.push_back(cpu);
+        }
+        begin = end + 1;
+    }
+    return cpus;
+}
+
+NumaTopology detectNumaTopology() {
+    NumaTopology topology;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool masked = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    const auto readLine = [](const std::string &path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    };
+    for (int node: parseCpuList(readLine("/sys/devices/system/node/online"))) {
+        std::vector<int> cpus;
+        for (int cpu: parseCpuList(readLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+            if (!masked || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) cpus.push_back(cpu);
+        }
+        if (!cpus.empty()) {
+            topology.nodeIds.push_back(node);
+            topology.nodeCpus.push_back(std::move(cpus));
+        }
+    }
+#endif
+    if (topology.nodeIds.empty()) {
+        // Pas de /sys (ou pas Linux) : un seul noeud, jamais épinglé
+        topology.nodeIds.push_back(0);
+        topology.nodeCpus.emplace_back();
+    }
+    return topology;
+}
+
+const NumaTopology &systemNumaTopology() {
+    static const NumaTopology topology = detectNumaTopology();
+    return topology;
+}
+
+bool pinCurrentThread(const std::vector<int> &cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu: cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void) cpus;
+    return false;
+#endif
+}
+
+// Bilan d'un lot, par noeud
+struct BatchNodeStats {
+    int node = 0;
+    int workers = 0;
+    int tasks = 0; // Tâches exécutées par les threads du noeud
+    int stolen = 0; // Dont tâches prises dans la plage d'un autre noeud
+    double seconds = 0.0; // Jusqu'à la fin de son dernier thread
+};
+
+struct BatchReport {
+    std::vector<BatchNodeStats> nodes;
+    int tasks = 0;
+    double seconds = 0.0;
+
+    void print(std::ostream &out, const char *unit) const {
+        for (const BatchNodeStats &n: nodes) {
+            out << "  node " << n.node << ": " << n.workers << " threads, " << n.tasks << ' ' << unit << " ("
+                    << n.stolen << " stolen) in " << n.seconds << " s, "
+                    << (n.seconds > 0.0 ? n.tasks / n.seconds : 0.0) << ' ' << unit << "/s" << std::endl;
+        }
+        out << "  all nodes: " << tasks << ' ' << unit << " in " << seconds << " s, "
+                << (seconds > 0.0 ? tasks / seconds : 0.0) << ' ' << unit << "/s" << std::endl;
+    }
+};
+
+// File de tâches d'un noeud : plage [next, end) et compteur de progression, sur une
+// ligne de cache à elle pour que les noeuds ne se disputent pas les mêmes lignes
+struct alignas(64) BatchQueue {
+    std::atomic<int> next{0};
+    int end = 0;
+    std::atomic<int> done{0};
+};
+
+// Répartit les index [0, count) sur les threads, répartis entre les noeuds au prorata de
+// leurs CPU ; dans un noeud, l'index atomique partagé équilibre les tâches de durée très
+// variable. task(i, worker) reçoit l'index du thread qui l'exécute. Affiche la progression.
+template<typename Task>
+BatchReport runBatch(const NumaTopology &topology, bool steal, int count, int threadCount, const char *unit,
+                     Task task) {
+    using Clock = std::chrono::steady_clock;
+    const int nodeCount = topology.nodeCount();
+    const bool pin = nodeCount > 1; // Sur un seul noeud, épingler ne ferait que gêner l'ordonnanceur
+
+    std::vector<int> workerNode(threadCount);
+    std::vector<int> nodeWorkers(nodeCount, 0);
+    for (int t = 0; t < threadCount; ++t) {
+        int best = 0;
+        for (int n = 1; n < nodeCount; ++n) {
+            // Occupation du noeud a après ajout d'un thread, comparée à celle de b (produit en croix)
+            const auto load = [&](int a, int b) {
+                return static_cast<long long>(nodeWorkers[a] + 1) * std::max<size_t>(1, topology.nodeCpus[b].size());
+            };
+            if (load(n, best) < load(best, n)) best = n;
+        }
+        workerNode[t] = best;
+        ++nodeWorkers[best];
+    }
+
+    std::vector<BatchQueue> queues(nodeCount);
+    int assigned = 0;
+    for (int n = 0; n < nodeCount; ++n) {
+        queues[n].next = static_cast<int>(static_cast<long long>(count) * assigned / threadCount);
+        assigned += nodeWorkers[n];
+        queues[n].end = static_cast<int>(static_cast<long long>(count) * assigned / threadCount);
+    }
+
+    struct WorkerStats {
+        int tasks = 0;
+        int stolen = 0;
+        Clock::time_point finished;
+    };
+    std::vector<WorkerStats> workerStats(threadCount);
+    const auto start = Clock::now();
+    const auto worker = [&](int index) {
+        const int node = workerNode[index];
+        if (pin) pinCurrentThread(topology.nodeCpus[node]);
+        WorkerStats stats;
+        for (int k = 0; k < (steal ? nodeCount : 1); ++k) {
+            BatchQueue &queue = queues[(node + k) % nodeCount];
+            for (int i = queue.next.fetch_add(1); i < queue.end; i = queue.next.fetch_add(1)) {
+                task(i, index);
+                queues[node].done.fetch_add(1, std::memory_order_relaxed);
+                ++stats.tasks;
+                if (k > 0) ++stats.stolen;
+            }
+        }
+        stats.finished = Clock::now();
+        workerStats[index] = stats;
+    };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back(worker, t);
+    }
+    int reported = 0;
+    while (reported < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        int current = 0;
+        for (const BatchQueue &queue: queues) current += queue.done.load(std::memory_order_relaxed);
+        if (current * 10 / count != reported * 10 / count) {
+            std::cout << "  " << current << " / " << count << " " << unit << std::endl;
+        }
+        reported = current;
+    }
+    for (std::thread &thread: workers) {
+        thread.join();
+    }
+
+    BatchReport report;
+    report.tasks = count;
+    for (int n = 0; n < nodeCount; ++n) {
+        BatchNodeStats node;
+        node.node = topology.nodeIds[n];
+        node.workers = nodeWorkers[n];
+        for (int t = 0; t < threadCount; ++t) {
+            if (workerNode[t] != n) continue;
+            node.tasks += workerStats[t].tasks;
+            node.stolen += workerStats[t].stolen;
+            node.seconds = std::max(node.seconds,
+                                    std::chrono::duration<double>(workerStats[t].finished - start).count());
+        }
+        if (node.workers > 0) report.nodes.push_back(node);
+        report.seconds = std::max(report.seconds, node.seconds); // Sans l'attente de l'affichage de progression
+    }
+    return report;
+}
+
+// Topologie d'un lot : un seul noeud sans épinglage avec --numa=off
+const NumaTopology &batchTopology(NumaMode numa) {
+    static const NumaTopology unpinned = [] {
+        NumaTopology single;
+        single.nodeIds.push_back(0);
+        single.nodeCpus.emplace_back();
+        return single;
+    }();
+    return numa == NumaMode::OFF ? unpinned : systemNumaTopology();
+}
+
+template<typename Task>
+BatchReport parallelFor(int count, int threadCount, const char *unit, Task task, NumaMode numa = NumaMode::LOCAL) {
+    return runBatch(batchTopology(numa), numa == NumaMode::STEAL, count, threadCount, unit,
+                    [&](int i, int) { task(i); });
+}
+
+// Un résultat par index : chaque thread range les siens dans un tampon qu'il alloue lui-même
+// (donc sur son noeud), sur sa propre ligne de cache ; fusion dans l'ordre des index à la fin.
+template<typename Result, typename Compute>
+BatchReport parallelMap(int count, int threadCount, const char *unit, std::vector<Result> &results,
+                        Compute compute, NumaMode numa = NumaMode::LOCAL) {
+    struct alignas(64) WorkerResults {
+        std::vector<std::pair<int, Result>> items;
+    };
+    std::vector<WorkerResults> perWorker(threadCount); // Vecteurs vides : rien n'est alloué ici
+    const BatchReport report = runBatch(batchTopology(numa), numa == NumaMode::STEAL, count, threadCount, unit,
+                                        [&](int i, int worker) {
+                                            perWorker[worker].items.emplace_back(i, compute(i));
+                                        });
+    results.clear();
+    results.resize(count);
+    for (WorkerResults &worker: perWorker) {
+        for (auto &item: worker.items) results[item.first] = std::move(item.second);
+    }
+    return report;
+}
+
+int simulationThreadCount(const RuntimeOptions &options, int taskCount) {
+    const int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, std::min(threads, taskCount));
+}
+
+//-----------------------------------------------------------------------------
+// Procedural Level Generator
+//-----------------------------------------------------------------------------
+// Niveaux générés à partir d'une graine (motif, bruit, symétrie, murs) puis validés
+// en jouant plusieurs parties sans affichage avec l'autopilote : on garde la
+// proportion de parties qui vident le niveau, la durée et les vies perdues.
+
+// splitmix64 : une graine 64 bits suffit à reproduire un niveau à l'identique
+struct LevelRng {
+    uint64_t state;
+
+    explicit LevelRng(uint64_t seed) : state(seed) {
+    }
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    int range(int low, int high) { return low + static_cast<int>(next() % static_cast<uint64_t>(high - low + 1)); }
+    float unit() { return static_cast<float>(next() >> 40) / static_cast<float>(1 << 24); }
+    bool chance(float p) { return unit() < p; }
+};
+
+enum class LevelPattern : uint8_t { BANDS, CHECKER, DIAMOND, NOISE, FRAMES, COUNT };
+
+const char *levelPatternName(LevelPattern pattern) {
+    switch (pattern) {
+        case LevelPattern::BANDS: return "bands";
+        case LevelPattern::CHECKER: return "checker";
+        case LevelPattern::DIAMOND: return "diamond";
+        case LevelPattern::NOISE: return "noise";
+        case LevelPattern::FRAMES: return "frames";
+        default: return "?";
+    }
+}
+
+// Paramètres tirés pour un niveau (conservés pour le rapport CSV)
+struct LevelRecipe {
+    uint64_t seed = 0;
+    LevelPattern pattern = LevelPattern::BANDS;
+    bool mirror = false;
+    int width = BRICKS_PER_ROW;
+    int height = BRICK_ROWS;
+    float density = 0.6f;
+    int wallSegments = 0;
+    float counterChance = 0.0f;
+    float bonusChance = 0.0f;
+};
+
+// Bruit de valeur sur une grille grossière, interpolé : des amas plutôt que du sel
+float latticeNoise(uint64_t seed, float x, float y) {
+    const auto corner = [seed](int ix, int iy) {
+        LevelRng rng(seed ^ (static_cast<uint64_t>(static_cast<uint32_t>(ix)) << 32 | static_cast<uint32_t>(iy)));
+        return rng.unit();
+    };
+    const int x0 = static_cast<int>(std::floor(x));
+    const int y0 = static_cast<int>(std::floor(y));
+    const float fx = x - x0;
+    const float fy = y - y0;
+    const float sx = fx * fx * (3.0f - 2.0f * fx);
+    const float sy = fy * fy * (3.0f - 2.0f * fy);
+    const float top = corner(x0, y0) + (corner(x0 + 1, y0) - corner(x0, y0)) * sx;
+    const float bottom = corner(x0, y0 + 1) + (corner(x0 + 1, y0 + 1) - corner(x0, y0 + 1)) * sx;
+    return top + (bottom - top) * sy;
+}
+
+// Couleur selon une "profondeur" 0..1 : rouge en haut de l'échelle, jaune en bas
+CellKind kindForDepth(float depth) {
+    if (depth < 0.25f) return CellKind::RED;
+    if (depth < 0.5f) return CellKind::ORANGE;
+    if (depth < 0.75f) return CellKind::GREEN;
+    return CellKind::YELLOW;
+}
+
+LevelData generateLevel(uint64_t seed, LevelRecipe *recipeOut = nullptr) {
+    LevelRng rng(seed);
+    LevelRecipe recipe;
+    recipe.seed = seed;
+    recipe.pattern = static_cast<LevelPattern>(rng.range(0, static_cast<int>(LevelPattern::COUNT) - 1));
+    recipe.mirror = rng.chance(0.6f);
+    recipe.width = rng.range(8, 20);
+    recipe.height = rng.range(4, 12);
+    recipe.density = 0.35f + 0.5f * rng.unit();
+    recipe.wallSegments = rng.chance(0.5f) ? rng.range(1, 3) : 0;
+    recipe.counterChance = 0.25f * rng.unit();
+    recipe.bonusChance = 0.15f * rng.unit();
+
+    LevelData level;
+    level.resize(recipe.width, recipe.height);
+    const int w = recipe.width;
+    const int h = recipe.height;
+    const int paintedColumns = recipe.mirror ? (w + 1) / 2 : w;
+    const int checkerSize = rng.range(1, 3);
+    const float noiseScale = 0.2f + 0.25f * rng.unit();
+    const uint64_t noiseSeed = rng.next();
+
+    for (int r = 0; r < h; ++r) {
+        for (int c = 0; c < paintedColumns; ++c) {
+            const float v = (r + 0.5f) / h; // 0 en haut, 1 en bas
+            const float u = (c + 0.5f) / w;
+            bool filled = false;
+            float depth = v;
+            switch (recipe.pattern) {
+                case LevelPattern::BANDS:
+                    filled = (r % 3 != 2) || recipe.density > 0.6f;
+                    break;
+                case LevelPattern::CHECKER:
+                    filled = ((r / checkerSize + c / checkerSize) % 2 == 0) || rng.chance(recipe.density * 0.3f);
+                    depth = 0.5f * (u + v);
+                    break;
+                case LevelPattern::DIAMOND: {
+                    const float d = std::abs(u - 0.5f) + std::abs(v - 0.5f);
+                    filled = d < recipe.density * 0.8f;
+                    depth = std::min(1.0f, d * 2.0f);
+                    break;
+                }
+                case LevelPattern::NOISE: {
+                    const float n = latticeNoise(noiseSeed, c * noiseScale, r * noiseScale);
+                    filled = n < recipe.density;
+                    depth = n;
+                    break;
+                }
+                case LevelPattern::FRAMES: {
+                    const int ring = std::min(std::min(r, h - 1 - r), std::min(c, w - 1 - c));
+                    filled = ring % 2 == 0;
+                    depth = static_cast<float>(ring) / std::max(1, std::min(w, h) / 2);
+                    break;
+                }
+                default:
+                    break;
+            }
+            if (!filled) {
+                continue;
+            }
+            LevelCell &cell = level.at(r, c);
+            cell.kind = kindForDepth(depth);
+            if (rng.chance(recipe.counterChance)) {
+                cell.hits = 2;
+            } else if (rng.chance(recipe.bonusChance)) {
+                cell.bonus = static_cast<int8_t>(rng.range(LIFE_ADD, BALL_ANGLE));
+            }
+        }
+    }
+
+    // Segments de murs : jamais sur toute la largeur, pour laisser passer la balle
+    for (int s = 0; s < recipe.wallSegments; ++s) {
+        const int row = rng.range(0, h - 1);
+        const int length = rng.range(2, std::max(2, paintedColumns / 2));
+        const int start = rng.range(0, std::max(0, paintedColumns - length));
+        const CellKind wallKind = rng.chance(0.3f) ? CellKind::REFLECTIVE : CellKind::WALL;
+        for (int c = start; c < std::min(paintedColumns, start + length); ++c) {
+            level.at(row, c) = LevelCell();
+            level.at(row, c).kind = wallKind;
+        }
+    }
+
+    if (recipe.mirror) {
+        for (int r = 0; r < h; ++r) {
+            for (int c = paintedColumns; c < w; ++c) {
+                level.at(r, c) = level.at(r, w - 1 - c);
+            }
+        }
+    }
+
+    // Un niveau sans brique cassable serait vidé immédiatement : ajouter une rangée
+    const bool hasBreakable = std::any_of(level.cells.begin(), level.cells.end(), [](const LevelCell &cell) {
+        return cell.kind != CellKind::EMPTY && cell.kind != CellKind::WALL && cell.kind != CellKind::REFLECTIVE;
+    });
+    if (!hasBreakable) {
+        for (int c = 0; c < w; ++c) {
+            level.at(h - 1, c) = LevelCell();
+            level.at(h - 1, c).kind = CellKind::YELLOW;
+        }
+    }
+
+    if (recipeOut) {
+        *recipeOut = recipe;
+    }
+    return level;
+}
+
+// Résultat d'une partie simulée sans affichage
+struct SimulationOutcome {
+    bool cleared = false; // Au moins un niveau vidé
+    bool gameOver = false;
+    float seconds = 0.0f;
+    int livesLost = 0;
+    int score = 0;
+    int levelsCleared = 0;
+};
+
+constexpr float HEADLESS_TIME_STEP = 1.0f / 120.0f; // Pas fixe des simulations en lot
+constexpr int BENCH_GAME_TICKS = 120 * 180; // Benchmarks : 3 minutes de partie autopilotée à ce pas
+
+// Joue le monde avec l'autopilote à pas fixe jusqu'à la fin de la partie (ou du premier
+// niveau si stopOnClear), ou jusqu'à maxSeconds (balle bloquée dans une boucle).
+SimulationOutcome simulateGame(GameWorld &world, Autopilot &pilot, float dt, float maxSeconds, bool stopOnClear) {
+    SimulationOutcome outcome;
+    const int startLevel = world.currentLevel;
+    int previousLives = world.lives;
+    const int maxSteps = static_cast<int>(maxSeconds / dt);
+    for (int step = 0; step < maxSteps; ++step) {
+        world.applyInput(pilot.decide(world), dt);
+        world.update(dt);
+        outcome.seconds += dt;
+        if (world.lives < previousLives) {
+            outcome.livesLost += previousLives - world.lives;
+        }
+        previousLives = world.lives;
+        if (world.gameOver || (stopOnClear && world.currentLevel != startLevel)) {
+            break;
+        }
+    }
+    outcome.levelsCleared = world.currentLevel - startLevel;
+    outcome.cleared = outcome.levelsCleared > 0;
+    outcome.gameOver = world.gameOver;
+    outcome.score = world.score;
+    return outcome;
+}
+
+constexpr int GENERATOR_TRIALS = 3; // Parties par niveau (graines d'autopilote différentes)
+constexpr float GENERATOR_MAX_SECONDS = 240.0f; // Au-delà, le niveau est jugé impossible
+
+struct LevelEvaluation {
+    LevelRecipe recipe;
+    int bricks = 0;
+    int clears = 0;
+    float meanSeconds = 0.0f; // Sur les parties réussies
+    float meanLivesLost = 0.0f;
+    float difficulty = 1.0f; // 0 = trivial, 1 = jamais vidé
+
+    bool playable() const { return clears > 0; }
+};
+
+LevelEvaluation evaluateLevel(uint64_t seed) {
+    LevelEvaluation evaluation;
+    const auto level = std::make_shared<const LevelData>(generateLevel(seed, &evaluation.recipe));
+    for (const LevelCell &cell: level->cells) {
+        if (cell.kind != CellKind::EMPTY && cell.kind != CellKind::WALL && cell.kind != CellKind::REFLECTIVE) {
+            ++evaluation.bricks;
+        }
+    }
+
+    float clearedSeconds = 0.0f;
+    int livesLost = 0;
+    for (int trial = 0; trial < GENERATOR_TRIALS; ++trial) {
+        GameWorld world;
+        world.level = level;
+        world.rngState = static_cast<uint32_t>(seed) ^ (0x9E3779B9u * static_cast<uint32_t>(trial + 1));
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        world.initGame();
+        Autopilot pilot(static_cast<uint32_t>(seed >> 32) ^ (0x85EBCA6Bu * static_cast<uint32_t>(trial + 1)));
+        const SimulationOutcome outcome = simulateGame(world, pilot, HEADLESS_TIME_STEP, GENERATOR_MAX_SECONDS, true);
+        if (outcome.cleared) {
+            ++evaluation.clears;
+            clearedSeconds += outcome.seconds;
+        }
+        livesLost += outcome.livesLost;
+    }
+    evaluation.meanSeconds = evaluation.clears ? clearedSeconds / evaluation.clears : 0.0f;
+    evaluation.meanLivesLost = static_cast<float>(livesLost) / GENERATOR_TRIALS;
+
+    // Échec, vies perdues et longueur de la partie comptent dans la difficulté
+    const float failRate = 1.0f - static_cast<float>(evaluation.clears) / GENERATOR_TRIALS;
+    const float lifeCost = std::min(1.0f, evaluation.meanLivesLost / 3.0f);
+    const float duration = std::min(1.0f, evaluation.meanSeconds / GENERATOR_MAX_SECONDS);
+    evaluation.difficulty = 0.5f * failRate + 0.3f * lifeCost + 0.2f * duration;
+    return evaluation;
+}
+
+// --generate=N : génère et valide N niveaux en parallèle, écrit <out>.csv et les
+// niveaux retenus (<out>_01.lvl ... du plus facile au plus difficile).
+void runLevelGenerator(const RuntimeOptions &options) {
+    const int count = options.generateCount;
+    const int threadCount = simulationThreadCount(options, count);
+    const std::string prefix = options.outPrefix.empty() ? "generated" : options.outPrefix;
+
+    // Chaque niveau ne dépend que de sa graine
+    std::vector<LevelEvaluation> evaluations;
+    const BatchReport batch = parallelMap(count, threadCount, "levels", evaluations, [&](int i) {
+        return evaluateLevel(options.seed + static_cast<uint64_t>(i));
+    }, options.numa);
+
+    const std::string csvPath = prefix + ".csv";
+    std::ofstream csv(csvPath);
+    if (!csv) {
+        throw std::runtime_error("Cannot write " + csvPath + ": " + std::strerror(errno));
+    }
+    csv << "seed,pattern,mirror,width,height,bricks,walls,clears,trials,mean_seconds,mean_lives_lost,difficulty\n";
+    std::vector<const LevelEvaluation *> playable;
+    for (const LevelEvaluation &e: evaluations) {
+        csv << e.recipe.seed << ',' << levelPatternName(e.recipe.pattern) << ',' << e.recipe.mirror << ','
+                << e.recipe.width << ',' << e.recipe.height << ',' << e.bricks << ',' << e.recipe.wallSegments << ','
+                << e.clears << ',' << GENERATOR_TRIALS << ',' << e.meanSeconds << ',' << e.meanLivesLost << ','
+                << e.difficulty << '\n';
+        if (e.playable()) {
+            playable.push_back(&e);
+        }
+    }
+
+    // Niveaux retenus répartis sur toute l'échelle de difficulté
+    std::sort(playable.begin(), playable.end(), [](const LevelEvaluation *a, const LevelEvaluation *b) {
+        return a->difficulty < b->difficulty;
+    });
+    const int keep = std::min(options.generateKeep, static_cast<int>(playable.size()));
+    for (int k = 0; k < keep; ++k) {
+        const size_t index = keep > 1 ? static_cast<size_t>(k) * (playable.size() - 1) / (keep - 1) : 0;
+        const LevelEvaluation &e = *playable[index];
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%02d.lvl", k + 1);
+        saveLevelFile(prefix + suffix, generateLevel(e.recipe.seed));
+    }
+
+    std::cout << "Generated " << count << " levels in " << batch.seconds << " s (" << count / batch.seconds
+            << " levels/s, " << threadCount << " threads, numa=" << numaModeName(options.numa) << ")\n";
+    batch.print(std::cout, "levels");
+    std::cout << "  playable: " << playable.size() << " / " << count << ", kept " << keep << "\n"
+            << "  summary: " << csvPath << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+// Monte Carlo Balancing
+//-----------------------------------------------------------------------------
+// --balance[=spec] : balaie une grille de GameTuning et joue pour chaque réglage un
+// grand nombre de parties sans affichage, avec des autopilotes de niveaux variés.
+// spec = "nom=min:max:pas,nom=valeur,..." (produit cartésien des axes).
+
+struct TuningParameter {
+    const char *name;
+    float GameTuning::*floatField;
+    int GameTuning::*intField;
+
+    float get(const GameTuning &t) const { return floatField ? t.*floatField : static_cast<float>(t.*intField); }
+
+    void set(GameTuning &t, float value) const {
+        if (floatField) {
+            t.*floatField = value;
+        } else {
+            t.*intField = static_cast<int>(std::lround(value));
+        }
+    }
+};
+
+const TuningParameter TUNING_PARAMETERS[] = {
+    {"paddleWidth", &GameTuning::paddleWidth, nullptr},
+    {"speedIncrement", &GameTuning::speedIncrement, nullptr},
+    {"firstSpeedUpHits", nullptr, &GameTuning::firstSpeedUpHits},
+    {"secondSpeedUpHits", nullptr, &GameTuning::secondSpeedUpHits},
+    {"paddleWiden", &GameTuning::paddleWiden, nullptr},
+    {"paddleShrink", &GameTuning::paddleShrink, nullptr},
+    {"ballSlow", &GameTuning::ballSlow, nullptr},
+    {"ballFast", &GameTuning::ballFast, nullptr},
+};
+
+const char *const DEFAULT_BALANCE_SPEC = "speedIncrement=1.1:1.28:3,paddleWidth=0.2:0.3:3,firstSpeedUpHits=4:8:2";
+constexpr float BALANCE_SKILLS[] = {0.25f, 0.5f, 0.75f, 1.0f};
+constexpr int BALANCE_SKILL_COUNT = sizeof(BALANCE_SKILLS) / sizeof(BALANCE_SKILLS[0]);
+constexpr float BALANCE_MAX_SECONDS = 600.0f; // Partie arrêtée (survivante) au-delà
+constexpr float SURVIVAL_CHECKPOINTS[] = {30.0f, 60.0f, 120.0f, 300.0f, 600.0f};
+constexpr int SURVIVAL_CHECKPOINT_COUNT = sizeof(SURVIVAL_CHECKPOINTS) / sizeof(SURVIVAL_CHECKPOINTS[0]);
+
+struct BalanceAxis {
+    const TuningParameter *parameter;
+    std::vector<float> values;
+};
+
+std::vector<BalanceAxis> parseBalanceSpec(const std::string &spec) {
+    std::vector<BalanceAxis> axes;
+    size_t begin = 0;
+    while (begin < spec.size()) {
+        size_t end = spec.find(',', begin);
+        if (end == std::string::npos) end = spec.size();
+        const std::string item = spec.substr(begin, end - begin);
+        begin = end + 1;
+
+        const size_t equals = item.find('=');
+        const std::string name = item.substr(0, equals);
+        const TuningParameter *parameter = nullptr;
+        for (const TuningParameter &candidate: TUNING_PARAMETERS) {
+            if (name == candidate.name) parameter = &candidate;
+        }
+        if (!parameter || equals == std::string::npos) {
+            throw std::runtime_error("Invalid balance parameter: " + item);
+        }
+        float low = 0.0f, high = 0.0f;
+        int steps = 1;
+        const int fields = std::sscanf(item.c_str() + equals + 1, "%f:%f:%d", &low, &high, &steps);
+        if (fields < 1 || fields == 2 || steps < 1) {
+            throw std::runtime_error("Invalid balance range (expected value or min:max:steps): " + item);
+        }
+        BalanceAxis axis{parameter, {}};
+        for (int i = 0; i < (fields == 1 ? 1 : steps); ++i) {
+            axis.values.push_back(steps > 1 ? low + (high - low) * i / (steps - 1) : low);
+        }
+        axes.push_back(axis);
+    }
+    return axes;
+}
+
+// Statistiques d'un couple (réglage, niveau de l'autopilote)
+struct BalanceCell {
+    int games = 0;
+    double meanScore = 0.0;
+    int scoreP10 = 0, scoreP50 = 0, scoreP90 = 0;
+    double meanLevelsCleared = 0.0;
+    float survival[SURVIVAL_CHECKPOINT_COUNT] = {}; // Fraction des parties encore en vie à t
+};
+
+BalanceCell summarizeBalance(std::vector<SimulationOutcome> outcomes) {
+    BalanceCell cell;
+    cell.games = static_cast<int>(outcomes.size());
+    if (outcomes.empty()) return cell;
+    std::sort(outcomes.begin(), outcomes.end(), [](const SimulationOutcome &a, const SimulationOutcome &b) {
+        return a.score < b.score;
+    });
+    const auto percentile = [&](double p) {
+        return outcomes[std::min(outcomes.size() - 1, static_cast<size_t>(p * outcomes.size()))].score;
+    };
+    cell.scoreP10 = percentile(0.1);
+    cell.scoreP50 = percentile(0.5);
+    cell.scoreP90 = percentile(0.9);
+    for (const SimulationOutcome &o: outcomes) {
+        cell.meanScore += o.score;
+        cell.meanLevelsCleared += o.levelsCleared;
+        for (int k = 0; k < SURVIVAL_CHECKPOINT_COUNT; ++k) {
+            // Une partie non terminée à la limite compte comme survivante (censurée)
+            if (!o.gameOver || o.seconds >= SURVIVAL_CHECKPOINTS[k]) cell.survival[k] += 1.0f;
+        }
+    }
+    cell.meanScore /= cell.games;
+    cell.meanLevelsCleared /= cell.games;
+    for (float &s: cell.survival) s /= static_cast<float>(cell.games);
+    return cell;
+}
+
+void runBalanceSweep(const RuntimeOptions &options) {
+    const std::vector<BalanceAxis> axes = parseBalanceSpec(options.balanceSpec.empty()
+                                                               ? DEFAULT_BALANCE_SPEC
+                                                               : options.balanceSpec);
+    std::vector<GameTuning> configs(1);
+    for (const BalanceAxis &axis: axes) {
+        std::vector<GameTuning> expanded;
+        for (const GameTuning &base: configs) {
+            for (float value: axis.values) {
+                expanded.push_back(base);
+                axis.parameter->set(expanded.back(), value);
+            }
+        }
+        configs.swap(expanded);
+    }
+
+    std::shared_ptr<const LevelData> level;
+    if (!options.levelPath.empty()) {
+        level = std::make_shared<const LevelData>(loadLevelFile(options.levelPath));
+    }
+
+    // Arrondi au supérieur : chaque niveau joue autant de parties, au moins --games au total
+    const int gamesPerSkill = (options.balanceGames + BALANCE_SKILL_COUNT - 1) / BALANCE_SKILL_COUNT;
+    const int configCount = static_cast<int>(configs.size());
+    const int total = configCount * BALANCE_SKILL_COUNT * gamesPerSkill;
+    const int threadCount = simulationThreadCount(options, total);
+    std::cout << "Balancing " << configCount << " configurations x " << BALANCE_SKILL_COUNT << " skills x "
+            << gamesPerSkill << " games on " << threadCount << " threads, " << systemNumaTopology().nodeCount()
+            << " NUMA node(s)" << std::endl;
+
+    // Une partie par index ; les résultats d'un même couple sont contigus
+    std::vector<SimulationOutcome> outcomes;
+    const BatchReport batch = parallelMap(total, threadCount, "games", outcomes, [&](int i) {
+        const int config = i / (BALANCE_SKILL_COUNT * gamesPerSkill);
+        const int skill = i / gamesPerSkill % BALANCE_SKILL_COUNT;
+        const auto game = static_cast<uint32_t>(i % gamesPerSkill);
+        GameWorld world;
+        world.tuning = configs[config];
+        world.level = level;
+        world.rngState = static_cast<uint32_t>(options.seed) ^ (0x9E3779B9u * (game + 1));
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        world.initGame();
+        Autopilot pilot(static_cast<uint32_t>(options.seed >> 32) ^ (0x85EBCA6Bu * (game + 1)), BALANCE_SKILLS[skill]);
+        return simulateGame(world, pilot, HEADLESS_TIME_STEP, BALANCE_MAX_SECONDS, false);
+    }, options.numa);
+
+    const std::string csvPath = (options.outPrefix.empty() ? "balance" : options.outPrefix) + ".csv";
+    std::ofstream csv(csvPath);
+    if (!csv) {
+        throw std::runtime_error("Cannot write " + csvPath + ": " + std::strerror(errno));
+    }
+    for (const TuningParameter &parameter: TUNING_PARAMETERS) csv << parameter.name << ',';
+    csv << "skill,games,mean_score,score_p10,score_p50,score_p90,mean_levels_cleared";
+    for (float t: SURVIVAL_CHECKPOINTS) csv << ",survival_" << t << "s";
+    csv << '\n';
+
+    for (int config = 0; config < configCount; ++config) {
+        std::cout << "config " << config + 1 << ":";
+        for (const BalanceAxis &axis: axes) {
+            std::cout << ' ' << axis.parameter->name << '=' << axis.parameter->get(configs[config]);
+        }
+        std::cout << '\n';
+        for (int skill = 0; skill < BALANCE_SKILL_COUNT; ++skill) {
+            const auto first = outcomes.begin() + (config * BALANCE_SKILL_COUNT + skill) * gamesPerSkill;
+            const BalanceCell cell = summarizeBalance(std::vector<SimulationOutcome>(first, first + gamesPerSkill));
+
+            std::cout << "  skill " << BALANCE_SKILLS[skill] << ": score mean " << cell.meanScore << " p10/p50/p90 "
+                    << cell.scoreP10 << '/' << cell.scoreP50 << '/' << cell.scoreP90 << ", levels "
+                    << cell.meanLevelsCleared << ", survival";
+            for (int k = 0; k < SURVIVAL_CHECKPOINT_COUNT; ++k) {
+                std::cout << ' ' << SURVIVAL_CHECKPOINTS[k] << "s:" << cell.survival[k];
+            }
+            std::cout << '\n';
+
+            for (const TuningParameter &parameter: TUNING_PARAMETERS) csv << parameter.get(configs[config]) << ',';
+            csv << BALANCE_SKILLS[skill] << ',' << cell.games << ',' << cell.meanScore << ',' << cell.scoreP10 << ','
+                    << cell.scoreP50 << ',' << cell.scoreP90 << ',' << cell.meanLevelsCleared;
+            for (float s: cell.survival) csv << ',' << s;
+            csv << '\n';
+        }
+    }
+    std::cout << total << " games in " << batch.seconds << " s (" << total / batch.seconds << " games/s, numa="
+            << numaModeName(options.numa) << ")\n";
+    batch.print(std::cout, "games");
+    std::cout << "  summary: " << csvPath << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+// Versus Mode (lockstep + rollback)
+//-----------------------------------------------------------------------------
+// Deux plateaux simulés à l'identique chez les deux joueurs à partir des entrées
+// échangées. L'entrée locale est appliquée avec INPUT_DELAY frames de retard ; celle
+// de l'adversaire est prédite (répétition de la dernière reçue) puis, si la prédiction
+// était fausse, on restaure l'instantané de la frame concernée et on resimule.
+
+// Datagrammes non fiables : UDP entre deux machines, ou boucle locale simulée
+class DatagramTransport {
+public:
+    virtual ~DatagramTransport() = default;
+
+    virtual void send(const uint8_t *data, size_t size) = 0;
+
+    // Taille du datagramme reçu, ou -1 s'il n'y en a aucun en attente (non bloquant)
+    virtual int receive(uint8_t *buffer, size_t capacity) = 0;
+};
+
+#ifndef _WIN32
+class UdpTransport : public DatagramTransport {
+public:
+    UdpTransport(int localPort, const std::string &peerHost, int peerPort) {
+        socketFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (socketFd < 0) {
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        local.sin_port = htons(static_cast<uint16_t>(localPort));
+        if (::bind(socketFd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0 ||
+            ::fcntl(socketFd, F_SETFL, ::fcntl(socketFd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+            const std::string error = std::strerror(errno);
+            ::close(socketFd);
+            throw std::runtime_error("Cannot bind UDP port " + std::to_string(localPort) + ": " + error);
+        }
+
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo *result = nullptr;
+        if (::getaddrinfo(peerHost.c_str(), std::to_string(peerPort).c_str(), &hints, &result) != 0 || !result) {
+            ::close(socketFd);
+            throw std::runtime_error("Cannot resolve peer " + peerHost);
+        }
+        std::memcpy(&peer, result->ai_addr, sizeof(peer));
+        ::freeaddrinfo(result);
+    }
+
+    ~UdpTransport() override { ::close(socketFd); }
+
+    UdpTransport(const UdpTransport &) = delete;
+    UdpTransport &operator=(const UdpTransport &) = delete;
+
+    void send(const uint8_t *data, size_t size) override {
+        // Perte éventuelle sans importance : les entrées non acquittées sont renvoyées
+        (void) ::sendto(socketFd, data, size, 0, reinterpret_cast<const sockaddr *>(&peer), sizeof(peer));
+    }
+
+    int receive(uint8_t *buffer, size_t capacity) override {
+        sockaddr_in from{};
+        socklen_t fromSize = sizeof(from);
+        const ssize_t received = ::recvfrom(socketFd, buffer, capacity, 0, reinterpret_cast<sockaddr *>(&from),
+                                            &fromSize);
+        if (received < 0 || from.sin_addr.s_addr != peer.sin_addr.s_addr || from.sin_port != peer.sin_port) {
+            return -1;
+        }
+        return static_cast<int>(received);
+    }
+
+private:
+    int socketFd = -1;
+    sockaddr_in peer{};
+};
+#endif
+
+// Lien local entre deux sessions d'un même processus, avec latence et pertes
+// artificielles (et une gigue de ±25% de la latence) pour tester le rollback.
+struct LoopbackLink {
+    struct Datagram {
+        std::chrono::steady_clock::time_point deliverAt;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::deque<Datagram> queues[2]; // queues[i] : datagrammes à destination du côté i
+    int latencyMs = 50;
+    float lossRate = 0.05f;
+    LevelRng rng{0x1234567u};
+};
+
+class LoopbackTransport : public DatagramTransport {
+public:
+    LoopbackTransport(std::shared_ptr<LoopbackLink> sharedLink, int linkSide)
+        : link(std::move(sharedLink)), side(linkSide) {
+    }
+
+    void send(const uint8_t *data, size_t size) override {
+        if (link->rng.unit() < link->lossRate) {
+            return;
+        }
+        const float jitter = 0.75f + 0.5f * link->rng.unit();
+        LoopbackLink::Datagram datagram;
+        datagram.deliverAt = std::chrono::steady_clock::now() +
+                             std::chrono::microseconds(static_cast<long long>(link->latencyMs * 1000.0f * jitter));
+        datagram.bytes.assign(data, data + size);
+        // Les datagrammes peuvent arriver dans le désordre, comme en UDP
+        auto &queue = link->queues[1 - side];
+        auto position = queue.end();
+        while (position != queue.begin() && std::prev(position)->deliverAt > datagram.deliverAt) {
+            --position;
+        }
+        queue.insert(position, std::move(datagram));
+    }
+
+    int receive(uint8_t *buffer, size_t capacity) override {
+        auto &queue = link->queues[side];
+        if (queue.empty() || queue.front().deliverAt > std::chrono::steady_clock::now()) {
+            return -1;
+        }
+        const size_t size = std::min(capacity, queue.front().bytes.size());
+        std::memcpy(buffer, queue.front().bytes.data(), size);
+        queue.pop_front();
+        return static_cast<int>(size);
+    }
+
+private:
+    std::shared_ptr<LoopbackLink> link;
+    int side;
+};
+
+// Entrée quantifiée : les deux machines doivent simuler exactement les mêmes valeurs
+struct NetInput {
+    int16_t pointer = 0; // pointerX / boundX sur 16 bits
+    uint8_t launch = 0;
+
+    bool operator==(const NetInput &other) const { return pointer == other.pointer && launch == other.launch; }
+    bool operator!=(const NetInput &other) const { return !(*this == other); }
+
+    static NetInput fromPlayerInput(const PlayerInput &input, float boundX) {
+        NetInput net;
+        const float normalized = std::max(-1.0f, std::min(input.pointerX / boundX, 1.0f));
+        net.pointer = static_cast<int16_t>(std::lround(normalized * 32767.0f));
+        net.launch = input.launch ? 1 : 0;
+        return net;
+    }
+
+    PlayerInput toPlayerInput(float boundX) const {
+        PlayerInput input;
+        input.pointerX = static_cast<float>(pointer) / 32767.0f * boundX;
+        input.launch = launch != 0;
+        return input;
+    }
+};
+
+constexpr uint32_t VERSUS_MAGIC = 0x5356424B; // "BKVS"
+constexpr float VERSUS_TIME_STEP = 1.0f / 60.0f;
+
+class VersusSession {
+public:
+    static constexpr int MAX_ROLLBACK = 8; // Avance maximale sur la dernière entrée reçue
+    static constexpr int MAX_INPUT_DELAY = 8;
+    static constexpr int HISTORY = 64; // Instantanés et entrées conservés (> 2 * MAX_ROLLBACK + délai)
+    static constexpr int MAX_PACKET_INPUTS = HISTORY;
+
+    VersusSession(std::unique_ptr<DatagramTransport> datagramTransport, int localPlayerIndex, int delayFrames,
+                  const std::shared_ptr<const LevelData> &level, uint32_t seed)
+        : transport(std::move(datagramTransport)), localPlayer(localPlayerIndex & 1),
+          inputDelay(std::max(0, std::min(delayFrames, static_cast<int>(MAX_INPUT_DELAY)))) {
+        for (int p = 0; p < 2; ++p) {
+            boards[p].level = level;
+            boards[p].rngState = seed ^ (0x9E3779B9u * static_cast<uint32_t>(p + 1)); // Même graine des deux côtés
+            boards[p].setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+            boards[p].initGame();
+        }
+        // Les INPUT_DELAY premières frames n'ont pas d'entrée locale : entrée neutre
+        for (int f = 0; f < inputDelay; ++f) {
+            localInputs[f] = NetInput();
+        }
+        lastLocalFrame = inputDelay - 1;
+        for (auto &snapshot: snapshots) {
+            snapshot[0] = boards[0];
+            snapshot[1] = boards[1];
+        }
+    }
+
+    // Une frame à 60 Hz : réception, rollback éventuel, envoi, puis avance d'une frame
+    // si l'adversaire n'est pas trop en retard.
+    void tick(const PlayerInput &input) {
+        receivePackets();
+        if (rollbackFrame < frame) {
+            rollback();
+        }
+
+        const bool canAdvance = frame - (remoteFrame + 1) < MAX_ROLLBACK;
+        if (canAdvance) {
+            lastLocalFrame = frame + inputDelay;
+            localInputs[lastLocalFrame % HISTORY] = NetInput::fromPlayerInput(input, localBoard().gameBoundX);
+        } else {
+            ++stalls;
+        }
+        sendInputs();
+        if (canAdvance) {
+            advance();
+        }
+    }
+
+    const GameWorld &board(int player) const { return boards[player]; }
+    const GameWorld &localBoard() const { return boards[localPlayer]; }
+    int localPlayerIndex() const { return localPlayer; }
+
+    bool finished() const { return boards[0].gameOver || boards[1].gameOver; }
+
+    // Gagnant : le dernier plateau encore en jeu, sinon le meilleur score (-1 = égalité)
+    int winner() const {
+        if (boards[0].gameOver != boards[1].gameOver) return boards[0].gameOver ? 1 : 0;
+        if (boards[0].score != boards[1].score) return boards[0].score > boards[1].score ? 0 : 1;
+        return -1;
+    }
+
+    // --- Statistiques (fenêtre versus / rapport de sortie) ---
+    int frame = 0; // Prochaine frame à simuler
+    int remoteFrame = -1; // Dernière frame dont l'entrée adverse est connue (sans trou)
+    long long rollbacks = 0;
+    long long resimulatedFrames = 0;
+    int maxRollbackFrames = 0;
+    double lastRollbackMicros = 0.0;
+    double maxRollbackMicros = 0.0;
+    long long stalls = 0;
+
+private:
+    std::unique_ptr<DatagramTransport> transport;
+    int localPlayer;
+    int inputDelay;
+    GameWorld boards[2];
+    GameWorld snapshots[HISTORY][2]; // État au début de chaque frame
+    NetInput localInputs[HISTORY];
+    NetInput remoteInputs[HISTORY];
+    NetInput usedRemoteInputs[HISTORY]; // Entrée adverse (prédite ou reçue) simulée
+    int lastLocalFrame = -1;
+    int ackedLocalFrame = -1; // Dernière entrée locale reçue par l'adversaire
+    int rollbackFrame = 0x7FFFFFFF;
+
+    NetInput remoteInputFor(int f) const {
+        if (f <= remoteFrame) return remoteInputs[f % HISTORY];
+        return remoteFrame >= 0 ? remoteInputs[remoteFrame % HISTORY] : NetInput(); // Prédiction
+    }
+
+    void simulateFrame(int f) {
+        GameWorld(&snapshot)[2] = snapshots[f % HISTORY];
+        snapshot[0] = boards[0]; // Affectation : réutilise les tampons des vecteurs
+        snapshot[1] = boards[1];
+
+        const NetInput remote = remoteInputFor(f);
+        usedRemoteInputs[f % HISTORY] = remote;
+        const NetInput local = localInputs[f % HISTORY];
+        for (int p = 0; p < 2; ++p) {
+            GameWorld &board = boards[p];
+            const NetInput &input = p == localPlayer ? local : remote;
+            board.applyInput(input.toPlayerInput(board.gameBoundX), VERSUS_TIME_STEP);
+            board.update(VERSUS_TIME_STEP);
+        }
+    }
+
+    void advance() {
+        simulateFrame(frame);
+        ++frame;
+    }
+
+    void rollback() {
+        const auto start = std::chrono::steady_clock::now();
+        const int count = frame - rollbackFrame;
+        boards[0] = snapshots[rollbackFrame % HISTORY][0];
+        boards[1] = snapshots[rollbackFrame % HISTORY][1];
+        for (int f = rollbackFrame; f < frame; ++f) {
+            simulateFrame(f);
+        }
+        rollbackFrame = 0x7FFFFFFF;
+
+        lastRollbackMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).
+                count();
+        maxRollbackMicros = std::max(maxRollbackMicros, lastRollbackMicros);
+        maxRollbackFrames = std::max(maxRollbackFrames, count);
+        resimulatedFrames += count;
+        ++rollbacks;
+    }
+
+    // Paquet : magic, dernière entrée adverse reçue (acquittement), première frame,
+    // nombre d'entrées, puis les entrées locales non acquittées (redondance contre les pertes)
+    void sendInputs() {
+        uint8_t packet[16 + MAX_PACKET_INPUTS * 3];
+        const int first = std::max(ackedLocalFrame + 1, lastLocalFrame - MAX_PACKET_INPUTS + 1);
+        const int count = lastLocalFrame - first + 1;
+        const int32_t header[3] = {remoteFrame, first, count};
+        const uint32_t magic = VERSUS_MAGIC;
+        std::memcpy(packet, &magic, 4);
+        std::memcpy(packet + 4, header, sizeof(header));
+        size_t size = 16;
+        for (int f = first; f <= lastLocalFrame; ++f) {
+            const NetInput &input = localInputs[f % HISTORY];
+            std::memcpy(packet + size, &input.pointer, 2);
+            packet[size + 2] = input.launch;
+            size += 3;
+        }
+        transport->send(packet, size);
+    }
+
+    void receivePackets() {
+        uint8_t packet[16 + MAX_PACKET_INPUTS * 3];
+        int size;
+        while ((size = transport->receive(packet, sizeof(packet))) >= 0) {
+            uint32_t magic;
+            int32_t header[3];
+            if (size < 16) continue;
+            std::memcpy(&magic, packet, 4);
+            std::memcpy(header, packet + 4, sizeof(header));
+            const int ack = header[0], first = header[1], count = header[2];
+            if (magic != VERSUS_MAGIC || count < 0 || count > MAX_PACKET_INPUTS || size < 16 + count * 3) {
+                continue;
+            }
+            ackedLocalFrame = std::max(ackedLocalFrame, std::min(ack, lastLocalFrame));
+
+            for (int i = 0; i < count; ++i) {
+                const int f = first + i;
+                if (f != remoteFrame + 1) {
+                    continue; // Déjà connue, ou trou : elle sera renvoyée
+                }
+                NetInput input;
+                std::memcpy(&input.pointer, packet + 16 + i * 3, 2);
+                input.launch = packet[16 + i * 3 + 2];
+                remoteInputs[f % HISTORY] = input;
+                remoteFrame = f;
+                if (f < frame && usedRemoteInputs[f % HISTORY] != input) {
+                    rollbackFrame = std::min(rollbackFrame, f); // Prédiction fausse
+                }
+            }
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Spectator Broadcast
+//-----------------------------------------------------------------------------
+// L'hôte encode une seule fois par tick les changements de l'état (briques touchées
+// ou détruites, balle, raquette, bonus) dans un tampon immuable partagé ; chaque
+// spectateur ne reçoit que des références à ces tampons, envoyées par sendmsg
+// (scatter-gather). Un spectateur qui arrive reçoit la dernière keyframe puis les
+// deltas qui la suivent. Socket Unix locale (--broadcast=chemin / --spectate=chemin).
+
+using SharedBuffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+#if !defined(_WIN32) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0 // macOS : pas de drapeau, SIGPIPE ignoré au démarrage du mode hôte
+#endif
+
+enum class SpectatorMessage : uint8_t { KEYFRAME = 1, DELTA = 2 };
+
+constexpr size_t SPECTATOR_HEADER_SIZE = 9; // u32 taille du contenu, u8 type, u32 tick
+
+void beginSpectatorMessage(std::vector<uint8_t> &out, SpectatorMessage type, uint32_t tick) {
+    out.resize(SPECTATOR_HEADER_SIZE);
+    out[4] = static_cast<uint8_t>(type);
+    std::memcpy(out.data() + 5, &tick, 4);
+}
+
+void endSpectatorMessage(std::vector<uint8_t> &out) {
+    const auto payloadSize = static_cast<uint32_t>(out.size() - SPECTATOR_HEADER_SIZE);
+    std::memcpy(out.data(), &payloadSize, 4);
+}
+
+class SpectatorBroadcaster {
+public:
+    static constexpr uint32_t KEYFRAME_INTERVAL = 120; // Ticks entre deux keyframes (2 s)
+    static constexpr size_t MAX_PENDING_MESSAGES = 256; // Au-delà, le client repart d'une keyframe
+    static constexpr int MAX_IOVECS = 64;
+
+    SpectatorBroadcaster() = default;
+
+    // Écoute sur une socket Unix (le chemin est recréé)
+    explicit SpectatorBroadcaster(const std::string &socketPath) : path(socketPath) {
+#ifndef _WIN32
+        sockaddr_un address{};
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Broadcast socket path too long: " + socketPath);
+        }
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(socketPath.c_str());
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            ::listen(listenFd, 64) < 0 || ::fcntl(listenFd, F_SETFL, O_NONBLOCK) < 0) {
+            const std::string error = std::strerror(errno);
+            if (listenFd >= 0) ::close(listenFd);
+            throw std::runtime_error("Cannot listen on " + socketPath + ": " + error);
+        }
+#else
+        throw std::runtime_error("Spectator broadcast requires Unix domain sockets");
+#endif
+    }
+
+    ~SpectatorBroadcaster() {
+#ifndef _WIN32
+        for (const Client &client: clients) ::close(client.fd);
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            ::unlink(path.c_str());
+        }
+#endif
+    }
+
+    SpectatorBroadcaster(const SpectatorBroadcaster &) = delete;
+    SpectatorBroadcaster &operator=(const SpectatorBroadcaster &) = delete;
+
+    // Ajoute une connexion déjà établie (socket non bloquante) : démarre à la keyframe
+    void addClient(int fd) {
+#ifndef _WIN32
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        clients.push_back(Client{fd, {}, 0});
+        bootstrap(clients.back());
+    }
+
+    void acceptClients() {
+#ifndef _WIN32
+        if (listenFd < 0) return;
+        int fd;
+        while ((fd = ::accept(listenFd, nullptr, nullptr)) >= 0) {
+            addClient(fd);
+        }
+#endif
+    }
+
+    // Encode l'état du tick une fois et le met en file pour tous les spectateurs
+    void publish(const GameWorld &world) {
+        const auto start = std::chrono::steady_clock::now();
+        const bool newLayout = world.blocks.size() != lastBricks.size() || world.currentLevel != lastLevel ||
+                               world.score < lastScore;
+        if (!keyframe || newLayout || tick - keyframeTick >= KEYFRAME_INTERVAL) {
+            auto buffer = std::make_shared<std::vector<uint8_t>>();
+            beginSpectatorMessage(*buffer, SpectatorMessage::KEYFRAME, tick);
+            const float bounds[2] = {world.gameBoundX, world.gameBoundY};
+            buffer->insert(buffer->end(), reinterpret_cast<const uint8_t *>(bounds),
+                           reinterpret_cast<const uint8_t *>(bounds) + sizeof(bounds));
+            std::vector<uint8_t> state;
+            world.saveState(state);
+            buffer->insert(buffer->end(), state.begin(), state.end());
+            endSpectatorMessage(*buffer);
+            keyframe = buffer;
+            keyframeTick = tick;
+            deltasSinceKeyframe.clear();
+            enqueueAll(keyframe);
+        } else {
+            auto buffer = std::make_shared<std::vector<uint8_t>>();
+            encodeDelta(world, *buffer);
+            deltasSinceKeyframe.push_back(buffer);
+            enqueueAll(buffer);
+        }
+        lastBricks.resize(world.blocks.size());
+        for (size_t i = 0; i < world.blocks.size(); ++i) {
+            lastBricks[i] = BrickState{world.blocks[i].hitCounter, world.blocks[i].active};
+        }
+        lastLevel = world.currentLevel;
+        lastScore = world.score;
+        ++tick;
+        encodeMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Envoie les messages en attente : un sendmsg par client, sans copie des tampons
+    void flush() {
+#ifndef _WIN32
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < clients.size();) {
+            Client &client = clients[c];
+            bool alive = true;
+            while (!client.pending.empty()) {
+                iovec vectors[MAX_IOVECS];
+                int count = 0;
+                size_t offset = client.frontOffset;
+                for (auto it = client.pending.begin(); it != client.pending.end() && count < MAX_IOVECS; ++it) {
+                    vectors[count].iov_base = const_cast<uint8_t *>((*it)->data() + offset);
+                    vectors[count].iov_len = (*it)->size() - offset;
+                    offset = 0;
+                    ++count;
+                }
+                msghdr message{};
+                message.msg_iov = vectors;
+                message.msg_iovlen = count;
+                const ssize_t sent = ::sendmsg(client.fd, &message, MSG_NOSIGNAL);
+                if (sent < 0) {
+                    alive = errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+                    break;
+                }
+                consume(client, static_cast<size_t>(sent));
+                bytesSent += static_cast<size_t>(sent);
+                if (count < MAX_IOVECS && !client.pending.empty()) {
+                    break; // Envoi partiel : tampon noyau plein
+                }
+            }
+            if (!alive) {
+                ::close(client.fd);
+                clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(c));
+                continue;
+            }
+            ++c;
+        }
+        flushMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+#endif
+    }
+
+    size_t clientCount() const { return clients.size(); }
+
+    // --- Statistiques ---
+    uint32_t tick = 0;
+    double encodeMicros = 0.0;
+    double flushMicros = 0.0;
+    size_t bytesEncoded = 0;
+    size_t bytesSent = 0;
+    size_t resyncs = 0; // Clients trop lents renvoyés à la keyframe
+
+private:
+    struct Client {
+        int fd;
+        std::deque<SharedBuffer> pending;
+        size_t frontOffset; // Octets déjà envoyés du premier tampon
+    };
+
+    struct BrickState {
+        int hitCounter;
+        bool active;
+    };
+
+    std::string path;
+    int listenFd = -1;
+    std::vector<Client> clients;
+    SharedBuffer keyframe;
+    uint32_t keyframeTick = 0;
+    std::vector<SharedBuffer> deltasSinceKeyframe;
+    std::vector<BrickState> lastBricks;
+    int lastLevel = 0;
+    int lastScore = 0;
+
+    void bootstrap(Client &client) const {
+        if (!keyframe) return;
+        client.pending.push_back(keyframe);
+        client.pending.insert(client.pending.end(), deltasSinceKeyframe.begin(), deltasSinceKeyframe.end());
+    }
+
+    void enqueueAll(const SharedBuffer &buffer) {
+        bytesEncoded += buffer->size();
+        for (Client &client: clients) {
+            if (client.pending.size() >= MAX_PENDING_MESSAGES) {
+                // Client trop lent : garder le message entamé, reprendre à cette keyframe
+                const bool partial = client.frontOffset > 0;
+                SharedBuffer front = client.pending.front();
+                client.pending.clear();
+                if (partial) client.pending.push_back(front);
+                else client.frontOffset = 0;
+                ++resyncs;
+                if (buffer != keyframe) {
+                    bootstrap(client); // Se termine déjà par buffer (dans deltasSinceKeyframe)
+                    continue;
+                }
+            }
+            client.pending.push_back(buffer);
+        }
+    }
+
+    static void consume(Client &client, size_t sent) {
+        while (sent > 0) {
+            const size_t remaining = client.pending.front()->size() - client.frontOffset;
+            if (sent < remaining) {
+                client.frontOffset += sent;
+                return;
+            }
+            sent -= remaining;
+            client.pending.pop_front();
+            client.frontOffset = 0;
+        }
+    }
+
+    // Delta : compteurs, raquette, balle, briques modifiées depuis le tick précédent, bonus
+    void encodeDelta(const GameWorld &world, std::vector<uint8_t> &out) const {
+        beginSpectatorMessage(out, SpectatorMessage::DELTA, tick);
+        std::vector<uint8_t> payload;
+        StateWriter writer(payload);
+        writer.write(GameCounters{world.score, world.lives, world.currentLevel, world.levelColumns, world.levelRows});
+        writer.writeScalar(world.playerPaddle.position.x);
+        writer.writeScalar(world.playerPaddle.size.x);
+        writer.writeScalar(world.gameBall.position.x);
+        writer.writeScalar(world.gameBall.position.y);
+        writer.writeScalar(static_cast<uint8_t>(world.gameBall.stuckToPaddle));
+
+        uint32_t changed = 0;
+        const size_t countOffset = payload.size();
+        writer.writeScalar(changed);
+        for (size_t i = 0; i < world.blocks.size(); ++i) {
+            const Block &block = world.blocks[i];
+            if (block.hitCounter != lastBricks[i].hitCounter || block.active != lastBricks[i].active) {
+                writer.writeScalar(static_cast<uint32_t>(i));
+                writer.writeScalar(static_cast<int32_t>(block.hitCounter));
+                writer.writeScalar(static_cast<uint8_t>(block.active));
+                ++changed;
+            }
+        }
+        std::memcpy(payload.data() + countOffset, &changed, sizeof(changed));
+        writer.writeArray(world.fallingBonuses);
+
+        out.insert(out.end(), payload.begin(), payload.end());
+        endSpectatorMessage(out);
+    }
+};
+
+// Côté spectateur : reconstruit un GameWorld miroir à partir du flux de l'hôte
+class SpectatorClient {
+public:
+    explicit SpectatorClient(int connectedFd) : fd(connectedFd) {
+#ifndef _WIN32
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    static int connectTo(const std::string &socketPath) {
+#ifndef _WIN32
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            const std::string error = std::strerror(errno);
+            if (fd >= 0) ::close(fd);
+            throw std::runtime_error("Cannot connect to " + socketPath + ": " + error);
+        }
+        return fd;
+#else
+        throw std::runtime_error("Spectator mode requires Unix domain sockets");
+#endif
+    }
+
+    ~SpectatorClient() {
+#ifndef _WIN32
+        ::close(fd);
+#endif
+    }
+
+    SpectatorClient(const SpectatorClient &) = delete;
+    SpectatorClient &operator=(const SpectatorClient &) = delete;
+
+    // Lit tout ce qui est disponible et l'applique au miroir ; false si l'hôte est parti
+    bool poll(GameWorld &mirror) {
+#ifndef _WIN32
+        uint8_t chunk[16384];
+        for (;;) {
+            const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received > 0) {
+                buffer.insert(buffer.end(), chunk, chunk + received);
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                connected = false;
+            }
+            break;
+        }
+#endif
+        size_t offset = 0;
+        while (buffer.size() - offset >= SPECTATOR_HEADER_SIZE) {
+            uint32_t payloadSize;
+            std::memcpy(&payloadSize, buffer.data() + offset, 4);
+            if (buffer.size() - offset - SPECTATOR_HEADER_SIZE < payloadSize) break;
+            const auto type = static_cast<SpectatorMessage>(buffer[offset + 4]);
+            std::memcpy(&lastTick, buffer.data() + offset + 5, 4);
+            apply(type, buffer.data() + offset + SPECTATOR_HEADER_SIZE, payloadSize, mirror);
+            offset += SPECTATOR_HEADER_SIZE + payloadSize;
+            ++messages;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+        return connected;
+    }
+
+    bool synced = false; // Une keyframe a été reçue
+    uint32_t lastTick = 0;
+    size_t messages = 0;
+
+private:
+    int fd;
+    bool connected = true;
+    std::vector<uint8_t> buffer;
+
+    void apply(SpectatorMessage type, const uint8_t *data, size_t size, GameWorld &mirror) {
+        if (type == SpectatorMessage::KEYFRAME) {
+            if (size < 8) throw std::runtime_error("Truncated spectator keyframe");
+            float boundX, boundY;
+            std::memcpy(&boundX, data, 4);
+            std::memcpy(&boundY, data + 4, 4);
+            if (!(boundX > 0.0f && boundY > 0.0f && std::isfinite(boundX) && std::isfinite(boundY))) {
+                throw std::runtime_error("Invalid spectator keyframe (world bounds)");
+            }
+            mirror.loadState(data + 8, size - 8, boundX, boundY);
+            synced = true;
+            return;
+        }
+        if (type != SpectatorMessage::DELTA || !synced) {
+            return; // Delta sans keyframe de référence : attendre la suivante
+        }
+        StateReader reader(data, size);
+        GameCounters counters;
+        reader.read(counters);
+        mirror.score = counters.score;
+        mirror.lives = counters.lives;
+        mirror.currentLevel = counters.currentLevel;
+        mirror.playerPaddle.position.x = reader.readScalar<float>();
+        mirror.playerPaddle.size.x = reader.readScalar<float>();
+        mirror.gameBall.position.x = reader.readScalar<float>();
+        mirror.gameBall.position.y = reader.readScalar<float>();
+        mirror.gameBall.stuckToPaddle = reader.readBool();
+
+        const auto changed = reader.readScalar<uint32_t>();
+        bool relink = false;
+        for (uint32_t i = 0; i < changed; ++i) {
+            const auto index = reader.readScalar<uint32_t>();
+            const auto hitCounter = reader.readScalar<int32_t>();
+            const bool active = reader.readBool();
+            if (index >= mirror.blocks.size()) throw std::runtime_error("Spectator delta: brick index out of range");
+            Block &block = mirror.blocks[index];
+            mirror.brickHash ^= GameWorld::brickHashTerm(index, block);
+            relink |= block.active != active;
+            block.hitCounter = hitCounter;
+            block.active = active;
+            mirror.brickHash ^= GameWorld::brickHashTerm(index, block);
+            block.color = getColorFromEnum(block.colorType); // Brique à compteur touchée : couleur de base
+        }
+        if (relink) {
+            mirror.rebuildBrickIndex();
+        }
+        reader.readArray(mirror.fallingBonuses);
+        for (const FallingBonus &bonus: mirror.fallingBonuses) {
+            StateReader::requireInRange(isBonusType(bonus.type));
+        }
+    }
+};
+
+// --bench-broadcast : coût de l'hôte par tick selon le nombre de spectateurs, avec de
+// vrais clients sur des paires de sockets Unix lus par un thread séparé.
+void runBroadcastBenchmark() {
+#ifndef _WIN32
+    constexpr int TICKS = 1200;
+    const int clientCounts[] = {0, 1, 4, 16, 64};
+    std::cout << "Spectator broadcast (" << TICKS << " ticks, autopiloted game)\n";
+    for (const int clientCount: clientCounts) {
+        GameWorld world;
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        world.initGame();
+        Autopilot pilot;
+        SpectatorBroadcaster broadcaster;
+
+        std::vector<std::unique_ptr<SpectatorClient>> clients;
+        std::vector<GameWorld> mirrors(clientCount);
+        for (int i = 0; i < clientCount; ++i) {
+            int fds[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+                throw std::runtime_error(std::string("socketpair: ") + std::strerror(errno));
+            }
+            broadcaster.addClient(fds[0]);
+            clients.emplace_back(new SpectatorClient(fds[1]));
+        }
+        std::atomic<bool> stop(false);
+        std::thread reader([&]() {
+            while (!stop.load()) {
+                for (int i = 0; i < clientCount; ++i) clients[i]->poll(mirrors[i]);
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+            for (int i = 0; i < clientCount; ++i) clients[i]->poll(mirrors[i]);
+        });
+
+        for (int t = 0; t < TICKS; ++t) {
+            world.applyInput(pilot.decide(world), VERSUS_TIME_STEP);
+            world.update(VERSUS_TIME_STEP);
+            broadcaster.publish(world);
+            broadcaster.flush();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        broadcaster.flush();
+        stop.store(true);
+        reader.join();
+
+        int inSync = 0;
+        for (const GameWorld &mirror: mirrors) {
+            bool same = mirror.score == world.score && mirror.blocks.size() == world.blocks.size() &&
+                        mirror.gameBall.position.x == world.gameBall.position.x;
+            for (size_t b = 0; same && b < world.blocks.size(); ++b) {
+                same = mirror.blocks[b].active == world.blocks[b].active;
+            }
+            inSync += same ? 1 : 0;
+        }
+        std::cout << "  " << clientCount << " spectators: encode " << broadcaster.encodeMicros / TICKS
+                << " us/tick, fan-out " << broadcaster.flushMicros / TICKS << " us/tick, "
+                << broadcaster.bytesEncoded / TICKS << " B/tick encoded, " << inSync << "/" << clientCount
+                << " mirrors in sync" << std::endl;
+    }
+#else
+    std::cout << "Spectator broadcast benchmark requires Unix domain sockets" << std::endl;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Headless Match Server
+//-----------------------------------------------------------------------------
+// --server=PORT : parties autoritaires côté serveur, une par connexion TCP. Le thread
+// réseau (epoll) reçoit les entrées ; à chaque tick fixe de 60 Hz, toutes les parties
+// sont avancées en lot par les threads de travail (une tranche contiguë chacun).
+// Entre deux ticks une partie est stockée sous forme compacte (quelques centaines
+// d'octets) : les briques se réduisent à leur compteur, la géométrie est partagée.
+
+// Partie compacte : tout ce qui n'est pas déductible du niveau
+struct CompactWorld {
+    Paddle paddle;
+    Ball ball;
+    int32_t score = 0;
+    int32_t lives = 3;
+    int32_t currentLevel = 1;
+    uint32_t rngState = 0;
+    bool gameOver = false;
+    std::vector<int8_t> bricks; // Compteur de chaque brique du niveau (0 = détruite, -1 = mur)
+    std::vector<FallingBonus> bonuses;
+
+    size_t memoryBytes() const {
+        return sizeof(*this) + bricks.capacity() + bonuses.capacity() * sizeof(FallingBonus);
+    }
+};
+
+// Passage compact <-> GameWorld complet à partir d'un modèle du niveau (une instance
+// par thread : le GameWorld de travail réutilise ses tampons d'un tick à l'autre)
+class CompactWorldCodec {
+public:
+    explicit CompactWorldCodec(const std::shared_ptr<const LevelData> &level) {
+        scratch.level = level;
+        scratch.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        scratch.initGame();
+        templateBlocks = scratch.blocks;
+    }
+
+    void initialize(CompactWorld &compact, uint32_t seed) {
+        scratch.rngState = seed ? seed : 1u;
+        scratch.initGame();
+        pack(compact);
+    }
+
+    // Le GameWorld de travail prend l'état de la partie (les bonus sont échangés, pas copiés)
+    GameWorld &unpack(CompactWorld &compact) {
+        scratch.playerPaddle = compact.paddle;
+        scratch.gameBall = compact.ball;
+        scratch.score = compact.score;
+        scratch.lives = compact.lives;
+        scratch.currentLevel = compact.currentLevel;
+        scratch.rngState = compact.rngState;
+        scratch.gameOver = compact.gameOver;
+        scratch.fallingBonuses.swap(compact.bonuses);
+        scratch.blocks = templateBlocks;
+        for (size_t i = 0; i < templateBlocks.size(); ++i) {
+            Block &block = scratch.blocks[i];
+            const int hits = compact.bricks[i];
+            if (hits == 0) {
+                block.active = false;
+            } else if (hits != block.hitCounter) {
+                block.hitCounter = hits;
+                block.color = getColorFromEnum(block.colorType); // Brique à compteur déjà touchée
+            }
+        }
+        scratch.rehashBricks();
+        scratch.rebuildBrickIndex();
+        return scratch;
+    }
+
+    void pack(CompactWorld &compact) {
+        compact.paddle = scratch.playerPaddle;
+        compact.ball = scratch.gameBall;
+        compact.score = scratch.score;
+        compact.lives = scratch.lives;
+        compact.currentLevel = scratch.currentLevel;
+        compact.rngState = scratch.rngState;
+        compact.gameOver = scratch.gameOver;
+        compact.bonuses.swap(scratch.fallingBonuses);
+        scratch.fallingBonuses.clear();
+        compact.bricks.resize(scratch.blocks.size());
+        for (size_t i = 0; i < scratch.blocks.size(); ++i) {
+            const Block &block = scratch.blocks[i];
+            compact.bricks[i] = static_cast<int8_t>(block.active ? block.hitCounter : 0);
+        }
+    }
+
+private:
+    GameWorld scratch;
+    std::vector<Block> templateBlocks;
+};
+
+// Messages TCP (taille fixe) : entrée client -> serveur, état serveur -> client
+struct ServerInputMessage {
+    int16_t pointer; // NetInput::pointer
+    uint8_t launch;
+    uint8_t reserved;
+};
+
+struct ServerStateMessage {
+    uint32_t tick;
+    int32_t score;
+    int8_t lives;
+    uint8_t level;
+    uint8_t gameOver;
+    uint8_t reserved;
+    int16_t ballX, ballY, paddleX; // Quantifiés comme NetInput (position / limite * 32767)
+    int16_t reserved2;
+};
+
+constexpr int SERVER_TICK_RATE = 60;
+constexpr int SERVER_SEND_INTERVAL = 3; // État envoyé à 20 Hz
+
+volatile std::sig_atomic_t serverStopRequested = 0;
+
+#ifdef __linux__
+// Relève la limite de descripteurs au maximum autorisé (milliers de connexions)
+void raiseFileLimit() {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Threads de travail persistants : chaque tick, le thread i avance sa tranche de parties
+class TickWorkers {
+public:
+    template<typename Task>
+    TickWorkers(int threadCount, Task task) : count(threadCount) {
+        for (int i = 0; i < count; ++i) {
+            threads.emplace_back([this, i, task]() {
+                uint64_t seen = 0;
+                for (;;) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wake.wait(lock, [&] { return generation != seen || stopping; });
+                        if (stopping) return;
+                        seen = generation;
+                    }
+                    task(i, count);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (++finished == count) idle.notify_one();
+                }
+            });
+        }
+    }
+
+    ~TickWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &thread: threads) thread.join();
+    }
+
+    // Lance un tick sur tous les threads et attend la fin (barrière)
+    void runTick() {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished = 0;
+        ++generation;
+        wake.notify_all();
+        idle.wait(lock, [&] { return finished == count; });
+    }
+
+private:
+    int count;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    uint64_t generation = 0;
+    int finished = 0;
+    bool stopping = false;
+};
+
+class MatchServer {
+public:
+    explicit MatchServer(const RuntimeOptions &runtimeOptions) : options(runtimeOptions) {
+        if (!options.levelPath.empty()) {
+            level = std::make_shared<const LevelData>(loadLevelFile(options.levelPath));
+        }
+        raiseFileLimit();
+
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        const int yes = 1;
+        ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(options.serverPort));
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            ::listen(listenFd, SOMAXCONN) < 0) {
+            throw std::runtime_error("Cannot listen on port " + std::to_string(options.serverPort) + ": " +
+                                     std::strerror(errno));
+        }
+        epollFd = ::epoll_create1(0);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = LISTEN_TAG;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+        const int threadCount = options.threads > 0 ? options.threads
+                                                    : static_cast<int>(std::thread::hardware_concurrency());
+        for (int i = 0; i < std::max(1, threadCount); ++i) {
+            codecs.emplace_back(new CompactWorldCodec(level));
+        }
+        codecs.emplace_back(new CompactWorldCodec(level)); // Pour le thread réseau (nouvelles parties)
+        workers.reset(new TickWorkers(static_cast<int>(codecs.size()) - 1, [this](int index, int count) {
+            tickRange(index, count);
+        }));
+    }
+
+    ~MatchServer() {
+        workers.reset();
+        for (const Session &session: sessions) {
+            if (session.fd >= 0) ::close(session.fd);
+        }
+        ::close(epollFd);
+        ::close(listenFd);
+    }
+
+    MatchServer(const MatchServer &) = delete;
+    MatchServer &operator=(const MatchServer &) = delete;
+
+    void run() {
+        std::cout << "Match server on port " << options.serverPort << ", " << codecs.size() - 1
+                << " tick threads (Ctrl+C to stop)" << std::endl;
+        using Clock = std::chrono::steady_clock;
+        const auto period = std::chrono::microseconds(1000000 / SERVER_TICK_RATE);
+        auto nextTick = Clock::now() + period;
+        auto nextReport = Clock::now() + std::chrono::seconds(5);
+        epoll_event events[256];
+
+        while (!serverStopRequested) {
+            const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextTick - Clock::now());
+            const int ready = ::epoll_wait(epollFd, events, 256, std::max(0, static_cast<int>(wait.count())));
+            for (int i = 0; i < ready; ++i) {
+                if (events[i].data.u64 == LISTEN_TAG) {
+                    acceptConnections();
+                    continue;
+                }
+                const auto slot = static_cast<size_t>(events[i].data.u64);
+                if ((events[i].events & EPOLLOUT) && sessions[slot].fd >= 0) {
+                    flushOutput(slot);
+                }
+                if ((events[i].events & ~EPOLLOUT) && sessions[slot].fd >= 0) {
+                    readInputs(slot);
+                }
+            }
+
+            const auto now = Clock::now();
+            if (now >= nextTick) {
+                runTick();
+                nextTick += period;
+                if (now - nextTick > period * 4) {
+                    nextTick = now + period; // Trop en retard : on saute des ticks plutôt que de rattraper
+                    ++lateTicks;
+                }
+            }
+            if (now >= nextReport) {
+                report();
+                nextReport = now + std::chrono::seconds(5);
+            }
+        }
+        report();
+    }
+
+private:
+    static constexpr uint64_t LISTEN_TAG = ~0ull;
+
+    struct Session {
+        int fd = -1;
+        CompactWorld world;
+        ServerInputMessage input{0, 0, 0};
+        uint8_t partial[sizeof(ServerInputMessage)] = {};
+        uint8_t partialSize = 0;
+        // Fin d'un état envoyé en partie : écrite sur EPOLLOUT avant tout nouvel état, pour
+        // que le client ne reçoive jamais d'enregistrement tronqué
+        uint8_t unsent[sizeof(ServerStateMessage)] = {};
+        uint8_t unsentOffset = 0;
+        uint8_t unsentSize = 0;
+    };
+
+    RuntimeOptions options;
+    std::shared_ptr<const LevelData> level;
+    int listenFd = -1;
+    int epollFd = -1;
+    std::vector<Session> sessions; // Emplacements réutilisés (fd = -1 : libre)
+    std::vector<size_t> freeSlots;
+    size_t activeGames = 0;
+    std::vector<std::unique_ptr<CompactWorldCodec>> codecs;
+    std::unique_ptr<TickWorkers> workers;
+    uint32_t tick = 0;
+
+    // --- Statistiques (fenêtre de 5 s) ---
+    long long ticksInWindow = 0;
+    double tickMicrosTotal = 0.0;
+    double tickMicrosMax = 0.0;
+    long long lateTicks = 0;
+    size_t bytesIn = 0;
+    size_t bytesOut = 0;
+
+    void acceptConnections() {
+        int fd;
+        while ((fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+            const int yes = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            size_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = sessions.size();
+                sessions.emplace_back();
+            }
+            Session &session = sessions[slot];
+            session.fd = fd;
+            session.input = ServerInputMessage{0, 0, 0};
+            session.partialSize = 0;
+            session.unsentOffset = 0;
+            session.unsentSize = 0;
+            codecs.back()->initialize(session.world, 0x9E3779B9u * static_cast<uint32_t>(slot + 1) ^ tick);
+            ++activeGames;
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = slot;
+            ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    void closeSession(size_t slot) {
+        Session &session = sessions[slot];
+        ::close(session.fd); // Retire aussi le descripteur d'epoll
+        session.fd = -1;
+        session.world.bonuses.clear();
+        freeSlots.push_back(slot);
+        --activeGames;
+    }
+
+    // Seule la dernière entrée reçue compte (état de la souris, pas des événements)
+    void readInputs(size_t slot) {
+        Session &session = sessions[slot];
+        uint8_t buffer[1024];
+        for (;;) {
+            const ssize_t received = ::recv(session.fd, buffer, sizeof(buffer), 0);
+            if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                closeSession(slot);
+                return;
+            }
+            if (received < 0) return;
+            bytesIn += static_cast<size_t>(received);
+            for (ssize_t i = 0; i < received; ++i) {
+                session.partial[session.partialSize++] = buffer[i];
+                if (session.partialSize == sizeof(ServerInputMessage)) {
+                    std::memcpy(&session.input, session.partial, sizeof(ServerInputMessage));
+                    session.partialSize = 0;
+                }
+            }
+        }
+    }
+
+    void tickRange(int index, int count) {
+        CompactWorldCodec &codec = *codecs[index];
+        const size_t begin = sessions.size() * index / count;
+        const size_t end = sessions.size() * (index + 1) / count;
+        for (size_t i = begin; i < end; ++i) {
+            Session &session = sessions[i];
+            if (session.fd < 0) continue;
+            if (session.world.gameOver && !session.input.launch) continue;
+            GameWorld &world = codec.unpack(session.world);
+            if (world.gameOver) {
+                world.initGame(); // Nouvelle partie au prochain clic
+            }
+            NetInput input;
+            input.pointer = session.input.pointer;
+            input.launch = session.input.launch;
+            world.applyInput(input.toPlayerInput(world.gameBoundX), 1.0f / SERVER_TICK_RATE);
+            world.update(1.0f / SERVER_TICK_RATE);
+            codec.pack(session.world);
+        }
+    }
+
+    void runTick() {
+        const auto start = std::chrono::steady_clock::now();
+        workers->runTick();
+        const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).
+                count();
+        tickMicrosTotal += micros;
+        tickMicrosMax = std::max(tickMicrosMax, micros);
+        ++ticksInWindow;
+        ++tick;
+        if (tick % SERVER_SEND_INTERVAL == 0) {
+            sendStates();
+        }
+    }
+
+    static int16_t quantize(float value, float bound) {
+        return static_cast<int16_t>(std::lround(std::max(-1.0f, std::min(value / bound, 1.0f)) * 32767.0f));
+    }
+
+    // Écrit la fin de l'état en attente ; false si la socket est encore pleine (ou fermée)
+    bool flushOutput(size_t slot) {
+        Session &session = sessions[slot];
+        while (session.unsentOffset < session.unsentSize) {
+            const ssize_t sent = ::send(session.fd, session.unsent + session.unsentOffset,
+                                        session.unsentSize - session.unsentOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+            if (sent <= 0) {
+                closeSession(slot);
+                return false;
+            }
+            bytesOut += static_cast<size_t>(sent);
+            session.unsentOffset = static_cast<uint8_t>(session.unsentOffset + sent);
+        }
+        session.unsentOffset = 0;
+        session.unsentSize = 0;
+        watchOutput(slot, false);
+        return true;
+    }
+
+    void watchOutput(size_t slot, bool writable) {
+        epoll_event event{};
+        event.events = writable ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.u64 = slot;
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, sessions[slot].fd, &event);
+    }
+
+    // Un client trop lent perd des états entiers (le suivant remplace celui qui ne passe pas) ;
+    // un état commencé est toujours terminé avant le suivant.
+    void sendStates() {
+        const float boundX = REFERENCE_WIDTH / REFERENCE_HEIGHT;
+        for (size_t slot = 0; slot < sessions.size(); ++slot) {
+            Session &session = sessions[slot];
+            if (session.fd < 0) continue;
+            if (session.unsentSize > 0 && !flushOutput(slot)) continue; // Toujours plein : état sauté
+            const CompactWorld &w = session.world;
+            ServerStateMessage message{};
+            message.tick = tick;
+            message.score = w.score;
+            message.lives = static_cast<int8_t>(w.lives);
+            message.level = static_cast<uint8_t>(std::min(w.currentLevel, 255));
+            message.gameOver = w.gameOver ? 1 : 0;
+            message.ballX = quantize(w.ball.position.x, boundX);
+            message.ballY = quantize(w.ball.position.y, 1.0f);
+            message.paddleX = quantize(w.paddle.position.x, boundX);
+            const ssize_t sent = ::send(session.fd, &message, sizeof(message), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent <= 0) continue; // Socket pleine : rien n'est parti, l'état est sauté
+            bytesOut += static_cast<size_t>(sent);
+            if (static_cast<size_t>(sent) < sizeof(message)) {
+                std::memcpy(session.unsent, &message, sizeof(message));
+                session.unsentOffset = static_cast<uint8_t>(sent);
+                session.unsentSize = sizeof(message);
+                watchOutput(slot, true);
+            }
+        }
+    }
+
+    void report() {
+        size_t memory = 0;
+        for (const Session &session: sessions) {
+            if (session.fd >= 0) memory += session.world.memoryBytes() + sizeof(Session) - sizeof(CompactWorld);
+        }
+        const double window = 5.0;
+        std::cout << "[server] games " << activeGames << "  tick avg "
+                << (ticksInWindow ? tickMicrosTotal / ticksInWindow : 0.0) << " us  max " << tickMicrosMax
+                << " us  late " << lateTicks << "  in " << bytesIn / window / 1024.0 << " KB/s  out "
+                << bytesOut / window / 1024.0 << " KB/s  memory/game " << (activeGames ? memory / activeGames : 0)
+                << " B" << std::endl;
+        ticksInWindow = 0;
+        tickMicrosTotal = 0.0;
+        tickMicrosMax = 0.0;
+        bytesIn = 0;
+        bytesOut = 0;
+    }
+};
+
+// --load=N : générateur de charge, N clients TCP qui envoient des entrées à 20 Hz
+// et comptent les états reçus.
+void runLoadGenerator(const RuntimeOptions &options) {
+    raiseFileLimit();
+    char host[256] = {};
+    int port = 0;
+    if (std::sscanf(options.connectAddress.c_str(), "%255[^:]:%d", host, &port) != 2) {
+        throw std::runtime_error("Invalid --connect value (expected HOST:PORT): " + options.connectAddress);
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *server = nullptr;
+    if (::getaddrinfo(host, std::to_string(port).c_str(), &hints, &server) != 0 || !server) {
+        throw std::runtime_error(std::string("Cannot resolve ") + host);
+    }
+
+    struct LoadClient {
+        int fd;
+        float pointer;
+        long long states;
+        uint32_t lastTick;
+        uint8_t partial[sizeof(ServerStateMessage)];
+        size_t partialSize;
+    };
+    std::vector<LoadClient> clients;
+    const int epollFd = ::epoll_create1(0);
+    for (int i = 0; i < options.loadClients; ++i) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, server->ai_addr, server->ai_addrlen) < 0) {
+            std::cerr << "Connection " << i << " failed: " << std::strerror(errno) << std::endl;
+            if (fd >= 0) ::close(fd);
+            break;
+        }
+        ::fcntl(fd, F_SETFL, O_NONBLOCK);
+        clients.push_back(LoadClient{fd, 0.0f, 0, 0, {}, 0});
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = clients.size() - 1;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+    ::freeaddrinfo(server);
+    std::cout << "Load generator: " << clients.size() << " clients connected to " << options.connectAddress
+            << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::seconds(options.durationSeconds);
+    auto nextSend = start;
+    LevelRng rng(0x2545F491u);
+    long long totalStates = 0;
+    epoll_event events[256];
+    while (Clock::now() < end) {
+        if (Clock::now() >= nextSend) {
+            for (LoadClient &client: clients) {
+                client.pointer = std::max(-1.0f, std::min(1.0f, client.pointer + rng.range(-100, 99) / 1000.0f));
+                const ServerInputMessage input{static_cast<int16_t>(client.pointer * 32767.0f), 1, 0};
+                (void) ::send(client.fd, &input, sizeof(input), MSG_NOSIGNAL | MSG_DONTWAIT);
+            }
+            nextSend += std::chrono::milliseconds(50);
+        }
+        const int ready = ::epoll_wait(epollFd, events, 256, 5);
+        for (int i = 0; i < ready; ++i) {
+            LoadClient &client = clients[events[i].data.u64];
+            uint8_t buffer[4096];
+            const ssize_t received = ::recv(client.fd, buffer, sizeof(buffer), 0);
+            for (ssize_t b = 0; b < received; ++b) {
+                client.partial[client.partialSize++] = buffer[b];
+                if (client.partialSize == sizeof(ServerStateMessage)) {
+                    ServerStateMessage message;
+                    std::memcpy(&message, client.partial, sizeof(message));
+                    client.lastTick = message.tick;
+                    client.partialSize = 0;
+                    ++client.states;
+                    ++totalStates;
+                }
+            }
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    long long starved = 0;
+    for (const LoadClient &client: clients) {
+        if (client.states < elapsed * SERVER_TICK_RATE / SERVER_SEND_INTERVAL * 0.5) ++starved;
+        ::close(client.fd);
+    }
+    ::close(epollFd);
+    std::cout << "  " << totalStates / elapsed << " states/s received (expected "
+            << clients.size() * SERVER_TICK_RATE / SERVER_SEND_INTERVAL << "), " << starved
+            << " clients below half rate" << std::endl;
+}
+#else
+void runLoadGenerator(const RuntimeOptions &) {
+    throw std::runtime_error("The load generator requires Linux (epoll)");
+}
+#endif
+
+void runMatchServer(const RuntimeOptions &options) {
+#ifdef __linux__
+    std::signal(SIGINT, [](int) { serverStopRequested = 1; });
+    std::signal(SIGTERM, [](int) { serverStopRequested = 1; });
+    MatchServer server(options);
+    server.run();
+#else
+    (void) options;
+    throw std::runtime_error("The match server requires Linux (epoll)");
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// State Sync Codec
+//-----------------------------------------------------------------------------
+// Synchronisation réseau par différence avec le dernier instantané acquitté par le
+// client : champs quantifiés, entiers de longueur variable et flux de bits. Une
+// brique détruite coûte quelques bits, une balle qui bouge deux petits entiers.
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t> &out) : out(out) {
+    }
+
+    void writeBits(uint32_t value, int count) {
+        accumulator |= static_cast<uint64_t>(value & ((count < 32 ? (1u << count) : 0u) - 1u)) << used;
+        used += count;
+        while (used >= 8) {
+            out.push_back(static_cast<uint8_t>(accumulator));
+            accumulator >>= 8;
+            used -= 8;
+        }
+    }
+
+    void writeBit(bool bit) { writeBits(bit ? 1u : 0u, 1); }
+
+    // Groupes de 4 bits + bit de continuation : les petites valeurs (fréquentes) tiennent en 5 bits
+    void writeVarUint(uint32_t value) {
+        do {
+            const uint32_t group = value & 0xFu;
+            value >>= 4;
+            writeBits(group | (value ? 0x10u : 0u), 5);
+        } while (value);
+    }
+
+    void writeVarInt(int32_t value) {
+        writeVarUint((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31)); // zigzag
+    }
+
+    void finish() {
+        if (used > 0) {
+            out.push_back(static_cast<uint8_t>(accumulator));
+        }
+        accumulator = 0;
+        used = 0;
+    }
+
+private:
+    std::vector<uint8_t> &out;
+    uint64_t accumulator = 0;
+    int used = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t size) : data(data), size(size) {
+    }
+
+    uint32_t readBits(int count) {
+        while (available < count) {
+            if (offset >= size) {
+                throw std::runtime_error("Truncated sync packet");
+            }
+            accumulator |= static_cast<uint64_t>(data[offset++]) << available;
+            available += 8;
+        }
+        const auto value = static_cast<uint32_t>(accumulator & ((1ull << count) - 1ull));
+        accumulator >>= count;
+        available -= count;
+        return value;
+    }
+
+    bool readBit() { return readBits(1) != 0; }
+
+    uint32_t readVarUint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 32; shift += 4) {
+            const uint32_t group = readBits(5);
+            value |= (group & 0xFu) << shift;
+            if (!(group & 0x10u)) return value;
+        }
+        throw std::runtime_error("Invalid varint in sync packet");
+    }
+
+    int32_t readVarInt() {
+        const uint32_t raw = readVarUint();
+        return static_cast<int32_t>(raw >> 1) ^ -static_cast<int32_t>(raw & 1u);
+    }
+
+    // Taille de tableau : rejetée avant toute allocation si le reste du paquet ne peut pas
+    // contenir autant d'éléments d'au moins minItemBits bits
+    uint32_t readCount(int minItemBits) {
+        const uint32_t count = readVarUint();
+        const size_t remainingBits = (size - offset) * 8 + static_cast<size_t>(available);
+        if (count > remainingBits / static_cast<size_t>(minItemBits)) {
+            throw std::runtime_error("Truncated sync packet");
+        }
+        return count;
+    }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t offset = 0;
+    uint64_t accumulator = 0;
+    int available = 0;
+};
+
+// Quantification : positions sur 16 bits dans [-2, 2], vitesses sur 16 bits dans [-8, 8]
+constexpr float SYNC_POSITION_RANGE = 2.0f;
+constexpr float SYNC_VELOCITY_RANGE = 8.0f;
+
+inline int32_t quantizeSync(float value, float range) {
+    const float clamped = std::max(-range, std::min(value, range));
+    return static_cast<int32_t>(std::lround(clamped / range * 32767.0f));
+}
+
+inline float dequantizeSync(int32_t value, float range) { return static_cast<float>(value) / 32767.0f * range; }
+
+struct SyncBonus {
+    int32_t x = 0, y = 0;
+    uint8_t type = 0;
+
+    bool operator==(const SyncBonus &o) const { return x == o.x && y == o.y && type == o.type; }
+};
+
+// État quantifié d'un tick, tel que le client le reconstruit
+struct SyncSnapshot {
+    uint32_t tick = 0;
+    int32_t score = 0, lives = 0, level = 0;
+    int32_t paddleX = 0, paddleWidth = 0;
+    int32_t ballX = 0, ballY = 0, ballVX = 0, ballVY = 0;
+    bool ballStuck = true;
+    std::vector<int8_t> bricks; // Compteur de coups (0 = détruite)
+    std::vector<SyncBonus> bonuses;
+
+    bool operator==(const SyncSnapshot &o) const {
+        return tick == o.tick && score == o.score && lives == o.lives && level == o.level && paddleX == o.paddleX &&
+               paddleWidth == o.paddleWidth && ballX == o.ballX && ballY == o.ballY && ballVX == o.ballVX &&
+               ballVY == o.ballVY && ballStuck == o.ballStuck && bricks == o.bricks && bonuses == o.bonuses;
+    }
+
+    static SyncSnapshot capture(const GameWorld &world, uint32_t tick) {
+        SyncSnapshot s;
+        s.tick = tick;
+        s.score = world.score;
+        s.lives = world.lives;
+        s.level = world.currentLevel;
+        s.paddleX = quantizeSync(world.playerPaddle.position.x, SYNC_POSITION_RANGE);
+        s.paddleWidth = quantizeSync(world.playerPaddle.size.x, SYNC_POSITION_RANGE);
+        s.ballX = quantizeSync(world.gameBall.position.x, SYNC_POSITION_RANGE);
+        s.ballY = quantizeSync(world.gameBall.position.y, SYNC_POSITION_RANGE);
+        s.ballVX = quantizeSync(world.gameBall.velocity.x, SYNC_VELOCITY_RANGE);
+        s.ballVY = quantizeSync(world.gameBall.velocity.y, SYNC_VELOCITY_RANGE);
+        s.ballStuck = world.gameBall.stuckToPaddle;
+        s.bricks.resize(world.blocks.size());
+        for (size_t i = 0; i < world.blocks.size(); ++i) {
+            const Block &block = world.blocks[i];
+            s.bricks[i] = static_cast<int8_t>(block.active ? std::max(-1, std::min(block.hitCounter, 127)) : 0);
+        }
+        s.bonuses.reserve(world.fallingBonuses.size());
+        for (const FallingBonus &bonus: world.fallingBonuses) {
+            s.bonuses.push_back(SyncBonus{
+                quantizeSync(bonus.position.x, SYNC_POSITION_RANGE), quantizeSync(bonus.position.y, SYNC_POSITION_RANGE),
+                static_cast<uint8_t>(bonus.type)
+            });
+        }
+        return s;
+    }
+};
+
+// Masque des sections présentes dans un paquet
+enum SyncSection : uint32_t {
+    SYNC_COUNTERS = 1u << 0,
+    SYNC_PADDLE = 1u << 1,
+    SYNC_BALL = 1u << 2,
+    SYNC_VELOCITY = 1u << 3,
+    SYNC_BRICKS = 1u << 4,
+    SYNC_BRICK_LAYOUT = 1u << 5, // Nouveau niveau : liste complète
+    SYNC_BONUSES = 1u << 6,
+    SYNC_SECTION_BITS = 7
+};
+
+// Encode target par rapport à baseline (le dernier instantané acquitté)
+void encodeSyncDelta(const SyncSnapshot &baseline, const SyncSnapshot &target, std::vector<uint8_t> &out) {
+    BitWriter bits(out);
+    bits.writeVarUint(target.tick - baseline.tick);
+
+    uint32_t sections = 0;
+    if (target.score != baseline.score || target.lives != baseline.lives || target.level != baseline.level)
+        sections |= SYNC_COUNTERS;
+    if (target.paddleX != baseline.paddleX || target.paddleWidth != baseline.paddleWidth) sections |= SYNC_PADDLE;
+    if (target.ballX != baseline.ballX || target.ballY != baseline.ballY || target.ballStuck != baseline.ballStuck)
+        sections |= SYNC_BALL;
+    if (target.ballVX != baseline.ballVX || target.ballVY != baseline.ballVY) sections |= SYNC_VELOCITY;
+    if (target.bricks.size() != baseline.bricks.size()) sections |= SYNC_BRICK_LAYOUT;
+    else if (target.bricks != baseline.bricks) sections |= SYNC_BRICKS;
+    if (target.bonuses != baseline.bonuses) sections |= SYNC_BONUSES;
+    bits.writeBits(sections, SYNC_SECTION_BITS);
+
+    if (sections & SYNC_COUNTERS) {
+        bits.writeVarInt(target.score - baseline.score);
+        bits.writeVarInt(target.lives - baseline.lives);
+        bits.writeVarInt(target.level - baseline.level);
+    }
+    if (sections & SYNC_PADDLE) {
+        bits.writeVarInt(target.paddleX - baseline.paddleX);
+        bits.writeVarInt(target.paddleWidth - baseline.paddleWidth);
+    }
+    if (sections & SYNC_BALL) {
+        bits.writeVarInt(target.ballX - baseline.ballX);
+        bits.writeVarInt(target.ballY - baseline.ballY);
+        bits.writeBit(target.ballStuck);
+    }
+    if (sections & SYNC_VELOCITY) {
+        // Les rebonds inversent le signe : valeur absolue sur 16 bits plutôt qu'un delta
+        bits.writeBits(static_cast<uint32_t>(target.ballVX) & 0xFFFFu, 16);
+        bits.writeBits(static_cast<uint32_t>(target.ballVY) & 0xFFFFu, 16);
+    }
+    if (sections & SYNC_BRICK_LAYOUT) {
+        bits.writeVarUint(static_cast<uint32_t>(target.bricks.size()));
+        for (int8_t hits: target.bricks) bits.writeVarInt(hits);
+    } else if (sections & SYNC_BRICKS) {
+        // Événements : écart depuis la brique modifiée précédente, puis 1 bit "détruite"
+        // ou le nouveau compteur
+        uint32_t changes = 0;
+        for (size_t i = 0; i < target.bricks.size(); ++i) changes += target.bricks[i] != baseline.bricks[i];
+        bits.writeVarUint(changes);
+        size_t previous = 0;
+        for (size_t i = 0; i < target.bricks.size(); ++i) {
+            if (target.bricks[i] == baseline.bricks[i]) continue;
+            bits.writeVarUint(static_cast<uint32_t>(i - previous));
+            previous = i;
+            bits.writeBit(target.bricks[i] == 0);
+            if (target.bricks[i] != 0) bits.writeVarInt(target.bricks[i]);
+        }
+    }
+    if (sections & SYNC_BONUSES) {
+        bits.writeVarUint(static_cast<uint32_t>(target.bonuses.size()));
+        for (const SyncBonus &bonus: target.bonuses) {
+            bits.writeBits(bonus.type, 3);
+            bits.writeBits(static_cast<uint32_t>(bonus.x) & 0xFFFFu, 16);
+            bits.writeBits(static_cast<uint32_t>(bonus.y) & 0xFFFFu, 16);
+        }
+    }
+    bits.finish();
+}
+
+// Reconstruit l'instantané à partir de la même baseline
+SyncSnapshot decodeSyncDelta(const SyncSnapshot &baseline, const uint8_t *data, size_t size) {
+    const auto signed16 = [](uint32_t raw) { return static_cast<int32_t>(static_cast<int16_t>(raw)); };
+    BitReader bits(data, size);
+    SyncSnapshot s = baseline;
+    s.tick = baseline.tick + bits.readVarUint();
+    const uint32_t sections = bits.readBits(SYNC_SECTION_BITS);
+
+    if (sections & SYNC_COUNTERS) {
+        s.score += bits.readVarInt();
+        s.lives += bits.readVarInt();
+        s.level += bits.readVarInt();
+    }
+    if (sections & SYNC_PADDLE) {
+        s.paddleX += bits.readVarInt();
+        s.paddleWidth += bits.readVarInt();
+    }
+    if (sections & SYNC_BALL) {
+        s.ballX += bits.readVarInt();
+        s.ballY += bits.readVarInt();
+        s.ballStuck = bits.readBit();
+    }
+    if (sections & SYNC_VELOCITY) {
+        s.ballVX = signed16(bits.readBits(16));
+        s.ballVY = signed16(bits.readBits(16));
+    }
+    if (sections & SYNC_BRICK_LAYOUT) {
+        s.bricks.resize(bits.readCount(5)); // Un varint : au moins un groupe de 5 bits
+        for (int8_t &hits: s.bricks) hits = static_cast<int8_t>(bits.readVarInt());
+    } else if (sections & SYNC_BRICKS) {
+        const uint32_t changes = bits.readVarUint();
+        size_t index = 0;
+        for (uint32_t c = 0; c < changes; ++c) {
+            index += bits.readVarUint();
+            if (index >= s.bricks.size()) throw std::runtime_error("Sync packet: brick index out of range");
+            s.bricks[index] = bits.readBit() ? 0 : static_cast<int8_t>(bits.readVarInt());
+        }
+    }
+    if (sections & SYNC_BONUSES) {
+        s.bonuses.resize(bits.readCount(3 + 16 + 16));
+        for (SyncBonus &bonus: s.bonuses) {
+            bonus.type = static_cast<uint8_t>(bits.readBits(3));
+            bonus.x = signed16(bits.readBits(16));
+            bonus.y = signed16(bits.readBits(16));
+        }
+    }
+    return s;
+}
+
+// --bench-sync : octets et coût par tick. Scène typique : partie autopilotée, baseline
+// acquittée 6 ticks plus tôt (~100 ms de RTT). Scène de stress : niveau 128x64,
+// 40 briques touchées et une vingtaine de bonus par tick, baseline vieille de 30 ticks.
+void runSyncBenchmark() {
+    constexpr int TICKS = 3000;
+    const auto runScene = [](const char *name, GameWorld &world, int ackLag, bool stress) {
+        Autopilot pilot;
+        std::vector<SyncSnapshot> history; // Instantanés envoyés, indexés par tick
+        std::vector<uint8_t> packet;
+        LevelRng stressRng(0x9E3779B9u);
+        size_t totalBytes = 0, fullBytes = 0;
+        double encodeNs = 0.0, decodeNs = 0.0;
+        int mismatches = 0;
+        for (int t = 0; t < TICKS; ++t) {
+            world.applyInput(pilot.decide(world), VERSUS_TIME_STEP);
+            world.update(VERSUS_TIME_STEP);
+            if (stress) {
+                for (int k = 0; k < 40; ++k) {
+                    const auto index = static_cast<uint32_t>(stressRng.next() % world.blocks.size());
+                    Block &block = world.blocks[index];
+                    if (block.active && !block.isWall && --block.hitCounter <= 0) {
+                        block.active = false;
+                        world.liveBricks.remove(block, index);
+                        world.brickGrid.remove(block);
+                        if (world.fallingBonuses.size() < 24) world.spawnBonus(block);
+                    }
+                }
+                if (world.liveBricks.live().size() < world.blocks.size() / 4) {
+                    world.initBlocks(); // Garder une scène chargée
+                }
+            }
+            history.push_back(SyncSnapshot::capture(world, static_cast<uint32_t>(t)));
+            const SyncSnapshot &baseline = history[std::max(0, t - ackLag)];
+
+            packet.clear();
+            const auto encodeStart = std::chrono::steady_clock::now();
+            encodeSyncDelta(baseline, history.back(), packet);
+            const auto decodeStart = std::chrono::steady_clock::now();
+            const SyncSnapshot decoded = decodeSyncDelta(baseline, packet.data(), packet.size());
+            const auto decodeEnd = std::chrono::steady_clock::now();
+            encodeNs += std::chrono::duration<double, std::nano>(decodeStart - encodeStart).count();
+            decodeNs += std::chrono::duration<double, std::nano>(decodeEnd - decodeStart).count();
+            totalBytes += packet.size();
+            mismatches += !(decoded == history.back());
+
+            std::vector<uint8_t> full;
+            world.saveState(full);
+            fullBytes += full.size();
+        }
+        std::cout << "  " << name << ": " << static_cast<double>(totalBytes) / TICKS << " B/tick (full state "
+                << fullBytes / TICKS << " B), encode " << encodeNs / TICKS << " ns, decode " << decodeNs / TICKS
+                << " ns, " << mismatches << " mismatches" << std::endl;
+    };
+
+    std::cout << "State sync codec (" << TICKS << " ticks)" << std::endl;
+    GameWorld typical;
+    typical.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+    typical.initGame();
+    runScene("typical", typical, 6, false);
+
+    GameWorld stress;
+    stress.level = std::make_shared<const LevelData>(makeBenchmarkLevel(128, 64));
+    stress.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+    stress.initGame();
+    runScene("stress", stress, 30, true);
+}
+
+//-----------------------------------------------------------------------------
+// Replays & Determinism
+//-----------------------------------------------------------------------------
+// Un replay contient l'état initial complet puis, pour chaque tick, l'entrée, le pas de
+// temps, les limites du monde et l'empreinte de l'état après le tick. La relecture
+// resimule et signale le premier tick dont l'empreinte diffère (désynchronisation).
+
+struct ReplayTick {
+    float dt = 0.0f;
+    float pointerX = 0.0f;
+    float boundX = 1.0f;
+    float boundY = 1.0f;
+    uint8_t launch = 0;
+    uint64_t hash = 0; // GameWorld::stateHash() après le tick
+};
+
+#define REPLAY_TICK_FIELDS(F) F(2, dt) F(2, pointerX) F(2, boundX) F(2, boundY) F(2, launch) F(2, hash)
+BREAKOUT_SCHEMA(ReplayTick, REPLAY_TICK_FIELDS)
+
+constexpr uint32_t REPLAY_MAGIC = 0x50524B42; // "BKRP"
+
+struct Replay {
+    uint32_t rngState = 0;
+    float boundX = 1.0f;
+    float boundY = 1.0f;
+    GameTuning tuning;
+    std::shared_ptr<const LevelData> level; // nullptr = niveau d'origine
+    std::vector<uint8_t> initialState; // GameWorld::saveState() au début
+    std::vector<ReplayTick> ticks;
+
+    void begin(const GameWorld &world) {
+        rngState = world.rngState;
+        boundX = world.gameBoundX;
+        boundY = world.gameBoundY;
+        tuning = world.tuning;
+        level = world.level;
+        initialState.clear();
+        world.saveState(initialState);
+        ticks.clear();
+    }
+
+    void record(const PlayerInput &input, float dt, const GameWorld &world) {
+        ReplayTick tick;
+        tick.dt = dt;
+        tick.pointerX = input.pointerX;
+        tick.launch = input.launch ? 1 : 0;
+        tick.boundX = world.gameBoundX;
+        tick.boundY = world.gameBoundY;
+        tick.hash = world.stateHash();
+        ticks.push_back(tick);
+    }
+
+    // Monde dans l'état du début de l'enregistrement
+    GameWorld startWorld() const {
+        GameWorld world;
+        world.level = level;
+        world.tuning = tuning;
+        world.gameBoundX = boundX;
+        world.gameBoundY = boundY;
+        world.loadState(initialState.data(), initialState.size());
+        world.rngState = rngState;
+        return world;
+    }
+};
+
+void saveReplayFile(const std::string &path, const Replay &replay) {
+    std::vector<uint8_t> buffer;
+    StateWriter writer(buffer);
+    writer.writeScalar(REPLAY_MAGIC);
+    writer.writeScalar(replay.rngState);
+    writer.writeScalar(replay.boundX);
+    writer.writeScalar(replay.boundY);
+    writer.writeScalar(static_cast<uint32_t>(sizeof(TUNING_PARAMETERS) / sizeof(TUNING_PARAMETERS[0])));
+    for (const TuningParameter &parameter: TUNING_PARAMETERS) {
+        writer.writeScalar(parameter.get(replay.tuning));
+    }
+    writer.writeScalar(static_cast<uint8_t>(replay.level != nullptr));
+    if (replay.level) {
+        writer.writeScalar(static_cast<int32_t>(replay.level->width));
+        writer.writeScalar(static_cast<int32_t>(replay.level->height));
+        writer.writeArray(replay.level->cells);
+    }
+    writer.writeScalar(static_cast<uint32_t>(replay.initialState.size()));
+    for (uint8_t byte: replay.initialState) {
+        writer.writeScalar(byte);
+    }
+    writer.writeArray(replay.ticks);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write replay " + path);
+    }
+}
+
+Replay loadReplayFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open replay " + path);
+    }
+    const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    StateReader reader(buffer.data(), buffer.size());
+    if (reader.version() < 2 || reader.readScalar<uint32_t>() != REPLAY_MAGIC) {
+        throw std::runtime_error(path + " is not a replay file");
+    }
+    Replay replay;
+    replay.rngState = reader.readScalar<uint32_t>();
+    replay.boundX = reader.readScalar<float>();
+    replay.boundY = reader.readScalar<float>();
+    const auto parameterCount = reader.readScalar<uint32_t>();
+    for (uint32_t i = 0; i < parameterCount; ++i) {
+        const float value = reader.readScalar<float>();
+        if (i < sizeof(TUNING_PARAMETERS) / sizeof(TUNING_PARAMETERS[0])) {
+            TUNING_PARAMETERS[i].set(replay.tuning, value);
+        }
+    }
+    if (reader.readBool()) {
+        LevelData level;
+        level.width = reader.readScalar<int32_t>();
+        level.height = reader.readScalar<int32_t>();
+        reader.readArray(level.cells);
+        for (const LevelCell &cell: level.cells) {
+            StateReader::requireInRange(isValidCell(cell));
+        }
+        if (!isLevelSize(level.width, level.height) ||
+            level.cells.size() != static_cast<size_t>(level.width) * level.height) {
+            throw std::runtime_error(path + ": inconsistent level size");
+        }
+        replay.level = std::make_shared<const LevelData>(std::move(level));
+    }
+    replay.initialState.resize(reader.readScalar<uint32_t>());
+    for (uint8_t &byte: replay.initialState) {
+        byte = reader.readScalar<uint8_t>();
+    }
+    reader.readArray(replay.ticks);
+    for (const ReplayTick &tick: replay.ticks) {
+        StateReader::requireInRange(tick.launch <= 1); // Booléen stocké sur un octet
+    }
+    return replay;
+}
+
+struct ReplayCheck {
+    size_t ticks = 0; // Ticks rejoués
+    long long divergedTick = -1; // Premier tick dont l'empreinte diffère, -1 si aucun
+    uint64_t expected = 0;
+    uint64_t actual = 0;
+};
+
+ReplayCheck verifyReplay(const Replay &replay) {
+    ReplayCheck check;
+    GameWorld world = replay.startWorld();
+    for (const ReplayTick &tick: replay.ticks) {
+        if (tick.boundX != world.gameBoundX || tick.boundY != world.gameBoundY) {
+            world.setBounds(tick.boundX, tick.boundY); // Fenêtre redimensionnée pendant l'enregistrement
+        }
+        PlayerInput input;
+        input.pointerX = tick.pointerX;
+        input.launch = tick.launch != 0;
+        world.applyInput(input, tick.dt);
+        world.update(tick.dt);
+        const uint64_t hash = world.stateHash();
+        if (hash != tick.hash) {
+            check.divergedTick = static_cast<long long>(check.ticks);
+            check.expected = tick.hash;
+            check.actual = hash;
+            return check;
+        }
+        ++check.ticks;
+    }
+    return check;
+}
+
+// --make-replay=fichier : partie autopilotée à pas fixe, enregistrée avec ses empreintes
+void runMakeReplay(const RuntimeOptions &options) {
+    GameWorld world;
+    if (!options.levelPath.empty()) {
+        world.level = std::make_shared<const LevelData>(loadLevelFile(options.levelPath));
+    }
+    world.rngState = static_cast<uint32_t>(options.seed) * 0x9E3779B9u + 1u;
+    world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+    world.initGame();
+    Autopilot pilot(static_cast<uint32_t>(options.seed) ^ 0x85EBCA6Bu, 0.9f);
+
+    Replay replay;
+    replay.begin(world);
+    const int ticks = options.frameLimit > 0 ? options.frameLimit : 3600;
+    for (int t = 0; t < ticks && !world.gameOver; ++t) {
+        const PlayerInput input = pilot.decide(world);
+        world.applyInput(input, VERSUS_TIME_STEP);
+        world.update(VERSUS_TIME_STEP);
+        replay.record(input, VERSUS_TIME_STEP, world);
+    }
+    saveReplayFile(options.makeReplayPath, replay);
+    std::cout << "Replay " << options.makeReplayPath << ": " << replay.ticks.size() << " ticks, final hash "
+            << std::hex << replay.ticks.back().hash << std::dec << ", score " << world.score << std::endl;
+}
+
+// --verify-replay=fichier : false si la simulation diverge
+bool runVerifyReplay(const RuntimeOptions &options) {
+    const Replay replay = loadReplayFile(options.verifyReplayPath);
+    const ReplayCheck check = verifyReplay(replay);
+    if (check.divergedTick >= 0) {
+        std::cout << "Replay " << options.verifyReplayPath << " DIVERGED at tick " << check.divergedTick << " of "
+                << replay.ticks.size() << " (expected " << std::hex << check.expected << ", got " << check.actual
+                << std::dec << ")" << std::endl;
+        return false;
+    }
+    std::cout << "Replay " << options.verifyReplayPath << " OK: " << check.ticks << " ticks identical" << std::endl;
+    return true;
+}
+
+// --check-determinism : les mêmes parties, jouées séquentiellement puis réparties sur
+// 1, 2, 4... threads, doivent produire exactement les mêmes empreintes à chaque tick.
+// Vérifie aussi l'empreinte incrémentale des briques contre un recalcul complet.
+bool runDeterminismCheck(const RuntimeOptions &options) {
+    constexpr int GAMES = 32;
+    constexpr int TICKS = 3600;
+    const auto playGame = [&](int game, std::vector<uint64_t> &hashes, bool checkIncremental) {
+        GameWorld world;
+        world.rngState = static_cast<uint32_t>(options.seed) + 0x9E3779B9u * static_cast<uint32_t>(game + 1);
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        world.initGame();
+        Autopilot pilot(0x85EBCA6Bu * static_cast<uint32_t>(game + 1), 0.5f + 0.5f * (game % 4) / 3.0f);
+        hashes.resize(TICKS);
+        long long incrementalErrors = 0;
+        for (int t = 0; t < TICKS; ++t) {
+            world.applyInput(pilot.decide(world), VERSUS_TIME_STEP);
+            world.update(VERSUS_TIME_STEP);
+            if (world.gameOver) {
+                world.initGame();
+            }
+            hashes[t] = world.stateHash();
+            if (checkIncremental && world.brickHash != world.computeBrickHash()) {
+                ++incrementalErrors;
+            }
+        }
+        return incrementalErrors;
+    };
+
+    std::vector<std::vector<uint64_t>> reference(GAMES);
+    long long incrementalErrors = 0;
+    for (int g = 0; g < GAMES; ++g) {
+        incrementalErrors += playGame(g, reference[g], true);
+    }
+    std::cout << "Determinism: " << GAMES << " games x " << TICKS << " ticks, incremental brick hash "
+            << (incrementalErrors ? "MISMATCH" : "OK") << std::endl;
+
+    bool identical = incrementalErrors == 0;
+    const int maxThreads = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<std::vector<uint64_t>> results(GAMES);
+        parallelFor(GAMES, threads, "games", [&](int g) { playGame(g, results[g], false); }, options.numa);
+        int divergedGame = -1, divergedTick = -1;
+        for (int g = 0; g < GAMES && divergedGame < 0; ++g) {
+            for (int t = 0; t < TICKS; ++t) {
+                if (results[g][t] != reference[g][t]) {
+                    divergedGame = g;
+                    divergedTick = t;
+                    break;
+                }
+            }
+        }
+        if (divergedGame >= 0) {
+            identical = false;
+            std::cout << "  " << threads << " threads: DIVERGED (game " << divergedGame << ", first tick "
+                    << divergedTick << ")" << std::endl;
+        } else {
+            std::cout << "  " << threads << " threads: identical" << std::endl;
+        }
+    }
+    return identical;
+}
+
+//-----------------------------------------------------------------------------
+// Rewind
+//-----------------------------------------------------------------------------
+// Historique des dernières secondes de la partie, pour revoir tick par tick un comportement
+// suspect depuis la fenêtre de debug. Chaque tick ajoute à des anneaux de taille fixe l'état
+// scalaire du monde (compteurs, raquette, balle, générateur), ses bonus et les briques
+// touchées depuis le tick précédent (GameWorld::changedBricks) : le coût d'un tick ne dépend
+// que de ce qui a changé, pas du nombre de briques. Le tableau de briques n'est copié en
+// entier que lorsqu'il est remplacé (nouveau niveau, nouvelle partie, chargement).
+// Les briques du tick le plus ancien sont gardées à part (base) ; quand ce tick sort de
+// l'historique, les modifications du suivant sont appliquées à la base. Restaurer un tick
+// repart de la base et rejoue les modifications jusqu'à lui.
+
+constexpr int REWIND_FRAMES = 8192; // Ticks gardés au plus (34 s à 240 Hz)
+constexpr int REWIND_BRICK_CHANGES = 16384;
+constexpr int REWIND_BONUSES = 32768;
+constexpr size_t REWIND_MAX_LAYOUT_BYTES = 64u << 20; // Tableaux de briques complets gardés
+
+class RewindBuffer {
+public:
+    // Anneaux alloués une fois pour toutes : l'enregistrement n'alloue jamais
+    explicit RewindBuffer(float historySeconds = 30.0f) : seconds(historySeconds) {
+        if (enabled()) {
+            frames.resize(REWIND_FRAMES);
+            changes.resize(REWIND_BRICK_CHANGES);
+            bonuses.resize(REWIND_BONUSES);
+        }
+    }
+
+    bool enabled() const { return seconds > 0.0f; }
+    int size() const { return count; }
+    uint64_t tickAt(int index) const { return frame(index).tick; }
+    uint64_t nextTick() const { return count ? frame(count - 1).tick + 1 : tick0; }
+    double secondsAt(int index) const { return frame(index).time; } // Depuis le début de l'historique
+    double span() const { return count ? frame(count - 1).time - frame(0).time : 0.0; }
+    double meanRecordMicros() const { return recordedTicks ? recordSeconds / recordedTicks * 1e6 : 0.0; }
+
+    size_t memoryBytes() const {
+        return frames.capacity() * sizeof(Frame) + changes.capacity() * sizeof(BrickChange) +
+               bonuses.capacity() * sizeof(FallingBonus) + (base.blocks.capacity() * sizeof(Block)) + layoutBytes;
+    }
+
+    void clear() {
+        tick0 = nextTick();
+        count = 0;
+        changeBegin = changeEnd = bonusBegin = bonusEnd = 0;
+        layoutBytes = 0;
+        for (Frame &f: frames) f.layout.reset();
+    }
+
+    // À appeler après chaque tick (et une fois au début de la partie, dt = 0)
+    void record(GameWorld &world, float dt) {
+        if (!enabled()) return;
+        const auto start = std::chrono::steady_clock::now();
+        const bool newLayout = count == 0 || world.layoutGeneration != layoutGeneration;
+        const size_t changeCount = newLayout ? 0 : world.changedBricks.size();
+        const size_t bonusCount = world.fallingBonuses.size();
+        const size_t newLayoutBytes = newLayout && count > 0 ? world.blocks.size() * sizeof(Block) : 0;
+        const double time = count ? frame(count - 1).time + dt : 0.0;
+
+        // Faire de la place : durée, nombre de ticks, modifications, bonus, briques gardées
+        const auto overBudget = [&]() {
+            return count == REWIND_FRAMES || (count > 1 && time - frame(1).time > seconds) ||
+                   changeEnd - changeBegin + changeCount > REWIND_BRICK_CHANGES ||
+                   bonusEnd - bonusBegin + bonusCount > REWIND_BONUSES ||
+                   layoutBytes + newLayoutBytes > REWIND_MAX_LAYOUT_BYTES;
+        };
+        while (count > 1 && overBudget()) dropOldest();
+        if (count == 1 && overBudget()) clear();
+        if (count == 0) first = 0;
+
+        Frame &f = frames[(first + count) % REWIND_FRAMES];
+        f.tick = nextTick();
+        f.time = count ? time : 0.0;
+        f.boundX = world.gameBoundX;
+        f.boundY = world.gameBoundY;
+        f.score = world.score;
+        f.lives = world.lives;
+        f.currentLevel = world.currentLevel;
+        f.gameOver = world.gameOver;
+        f.rngState = world.rngState;
+        f.paddle = world.playerPaddle;
+        f.ball = world.gameBall;
+        f.layout.reset();
+        if (count == 0) {
+            base.capture(world); // Le tick le plus ancien n'a pas de modifications à lui
+        } else if (newLayout) {
+            auto layout = std::make_shared<Layout>();
+            layout->capture(world);
+            layoutBytes += newLayoutBytes;
+            f.layout = std::move(layout);
+        }
+        const size_t storedChanges = count == 0 ? 0 : changeCount;
+        f.firstChange = changeEnd;
+        f.changeCount = static_cast<uint32_t>(storedChanges);
+        for (size_t i = 0; i < storedChanges; ++i) {
+            const uint32_t index = world.changedBricks[i];
+            const Block &block = world.blocks[index];
+            changes[changeEnd++ % REWIND_BRICK_CHANGES] = BrickChange{index, block.hitCounter, block.color, block.active};
+        }
+        f.firstBonus = bonusEnd;
+        f.bonusCount = static_cast<uint32_t>(bonusCount);
+        for (const FallingBonus &bonus: world.fallingBonuses) bonuses[bonusEnd++ % REWIND_BONUSES] = bonus;
+        ++count;
+
+        world.changedBricks.clear();
+        layoutGeneration = world.layoutGeneration;
+        recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++recordedTicks;
+    }
+
+    // Remet le monde dans l'état du tick index (0 = le plus ancien), aux limites actuelles
+    void restore(int index, GameWorld &world) {
+        const Frame &target = frame(index);
+        Layout state = base;
+        for (int i = 1; i <= index; ++i) {
+            const Frame &f = frame(i);
+            if (f.layout) state = *f.layout;
+            apply(f, state.blocks);
+        }
+        const float boundX = world.gameBoundX, boundY = world.gameBoundY;
+        world.blocks.swap(state.blocks);
+        world.level = state.level;
+        world.levelColumns = state.columns;
+        world.levelRows = state.rows;
+        world.score = target.score;
+        world.lives = target.lives;
+        world.currentLevel = target.currentLevel;
+        world.gameOver = target.gameOver;
+        world.rngState = target.rngState;
+        world.playerPaddle = target.paddle;
+        world.gameBall = target.ball;
+        world.fallingBonuses.clear();
+        for (uint32_t b = 0; b < target.bonusCount; ++b) {
+            world.fallingBonuses.push_back(bonuses[(target.firstBonus + b) % REWIND_BONUSES]);
+        }
+        world.gameBoundX = target.boundX;
+        world.gameBoundY = target.boundY;
+        world.setBounds(boundX, boundY); // Comme un redimensionnement si la fenêtre a changé depuis
+        world.rehashBricks();
+        world.rebuildBrickIndex();
+        world.changedBricks.clear();
+        layoutGeneration = world.layoutGeneration;
+    }
+
+    // Oublie les ticks postérieurs à index : la partie reprend à partir de lui
+    void truncate(int index) {
+        for (int i = index + 1; i < count; ++i) {
+            Frame &f = frame(i);
+            if (f.layout) layoutBytes -= f.layout->blocks.size() * sizeof(Block);
+            f.layout.reset();
+        }
+        const Frame &last = frame(index);
+        changeEnd = last.firstChange + last.changeCount;
+        bonusEnd = last.firstBonus + last.bonusCount;
+        count = index + 1;
+    }
+
+private:
+    struct BrickChange {
+        uint32_t index;
+        int32_t hitCounter;
+        Color color;
+        bool active;
+    };
+
+    // Tableau de briques complet et niveau auquel il appartient
+    struct Layout {
+        std::vector<Block> blocks;
+        std::shared_ptr<const LevelData> level;
+        int columns = 0, rows = 0;
+
+        void capture(const GameWorld &world) {
+            blocks = world.blocks;
+            level = world.level;
+            columns = world.levelColumns;
+            rows = world.levelRows;
+        }
+    };
+
+    struct Frame {
+        uint64_t tick = 0;
+        double time = 0.0; // Secondes de jeu depuis le début de l'historique
+        float boundX = 1.0f, boundY = 1.0f;
+        int score = 0, lives = 0, currentLevel = 0;
+        bool gameOver = false;
+        uint32_t rngState = 0;
+        Paddle paddle;
+        Ball ball;
+        uint64_t firstChange = 0, firstBonus = 0; // Positions absolues dans les anneaux
+        uint32_t changeCount = 0, bonusCount = 0;
+        std::shared_ptr<const Layout> layout; // Briques remplacées à ce tick
+    };
+
+    float seconds;
+    std::vector<Frame> frames;
+    std::vector<BrickChange> changes;
+    std::vector<FallingBonus> bonuses;
+    int first = 0, count = 0;
+    uint64_t changeBegin = 0, changeEnd = 0, bonusBegin = 0, bonusEnd = 0;
+    uint64_t tick0 = 0;
+    Layout base; // Briques au tick le plus ancien
+    size_t layoutBytes = 0;
+    uint32_t layoutGeneration = 0;
+    double recordSeconds = 0.0;
+    long long recordedTicks = 0;
+
+    Frame &frame(int index) { return frames[(first + index) % REWIND_FRAMES]; }
+    const Frame &frame(int index) const { return frames[(first + index) % REWIND_FRAMES]; }
+
+    void apply(const Frame &f, std::vector<Block> &blocks) const {
+        for (uint32_t c = 0; c < f.changeCount; ++c) {
+            const BrickChange &change = changes[(f.firstChange + c) % REWIND_BRICK_CHANGES];
+            Block &block = blocks[change.index];
+            block.hitCounter = change.hitCounter;
+            block.color = change.color;
+            block.active = change.active;
+        }
+    }
+
+    // Le deuxième tick devient le plus ancien : ses modifications passent dans la base
+    void dropOldest() {
+        Frame &next = frame(1);
+        if (next.layout) {
+            layoutBytes -= next.layout->blocks.size() * sizeof(Block);
+            base = *next.layout;
+            next.layout.reset();
+        }
+        apply(next, base.blocks);
+        changeBegin = next.firstChange + next.changeCount;
+        bonusBegin = next.firstBonus;
+        frame(0).layout.reset();
+        first = (first + 1) % REWIND_FRAMES;
+        --count;
+    }
+};
+
+// --bench-rewind : coût d'enregistrement par tick sur des parties autopilotées (niveau
+// d'origine, niveau 128x64), avec une nouvelle partie à chaque défaite. Un tick restauré doit
+// redonner la même empreinte, et les entrées rejouées à partir de lui les mêmes ticks suivants.
+void runRewindBenchmark() {
+    constexpr int TICKS = BENCH_GAME_TICKS;
+    constexpr int CHECKS = 200; // Ticks restaurés et vérifiés
+    constexpr int REPLAYED = 60; // Ticks rejoués après chaque restauration
+    using Clock = std::chrono::steady_clock;
+    const auto runScene = [](const char *name, const std::shared_ptr<const LevelData> &level) {
+        GameWorld world;
+        world.level = level;
+        world.trackBrickChanges = true;
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        world.initGame();
+        Autopilot pilot;
+        RewindBuffer rewind;
+        std::vector<uint64_t> hashes{world.stateHash()}; // Par tick
+        std::vector<PlayerInput> inputs{PlayerInput()}; // Entrée qui mène au tick
+        rewind.record(world, 0.0f);
+        std::vector<double> recordUs; // Mesuré de l'extérieur, pour le centile
+        recordUs.reserve(TICKS);
+        for (int t = 1; t <= TICKS; ++t) {
+            inputs.push_back(pilot.decide(world));
+            world.applyInput(inputs.back(), HEADLESS_TIME_STEP);
+            world.update(HEADLESS_TIME_STEP);
+            if (world.gameOver) world.initGame();
+            hashes.push_back(world.stateHash());
+            const auto start = Clock::now();
+            rewind.record(world, HEADLESS_TIME_STEP);
+            recordUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        std::sort(recordUs.begin(), recordUs.end());
+
+        int mismatches = 0;
+        double restoreUs = 0.0;
+        GameWorld replay = world;
+        for (int c = 0; c < CHECKS; ++c) {
+            const int index = static_cast<int>(static_cast<long long>(c) * (rewind.size() - 1) / (CHECKS - 1));
+            const auto start = Clock::now();
+            rewind.restore(index, replay);
+            restoreUs += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            const auto tick = static_cast<size_t>(rewind.tickAt(index));
+            mismatches += replay.stateHash() != hashes[tick];
+            for (size_t t = tick + 1; t < std::min(hashes.size(), tick + 1 + REPLAYED); ++t) {
+                replay.applyInput(inputs[t], HEADLESS_TIME_STEP);
+                replay.update(HEADLESS_TIME_STEP);
+                if (replay.gameOver) replay.initGame();
+                mismatches += replay.stateHash() != hashes[t];
+            }
+        }
+        std::cout << "  " << name << ": record " << rewind.meanRecordMicros() << " us/tick (p99.9 "
+                << recordUs[recordUs.size() * 999 / 1000] << " us), " << rewind.size() << " ticks kept (" << rewind.span() << " s), "
+                << rewind.memoryBytes() / 1024 << " KB; restore " << restoreUs / CHECKS << " us, " << mismatches
+                << " mismatches" << std::endl;
+    };
+
+    std::cout << "Rewind (" << TICKS << " ticks, " << CHECKS << " restores)" << std::endl;
+    runScene("stock level", nullptr);
+    runScene("128x64 level", std::make_shared<const LevelData>(makeBenchmarkLevel(128, 64)));
+}
+
+//-----------------------------------------------------------------------------
+// Event Stream
+//-----------------------------------------------------------------------------
+// Événements de gameplay pour l'analytique (--events=chemin) : le monde les empile pendant
+// le pas de simulation (recordEvents), le jeu les publie en un lot par frame, et un thread
+// de fond les encode puis les écrit dans une socket Unix (si le chemin en est une : le
+// consommateur écoute) ou à la fin d'un fichier. Le jeu ne se bloque jamais sur l'écriture :
+// au-delà de MAX_PENDING_EVENTS événements en attente, un lot publié est compté puis
+// abandonné ; après une erreur d'écriture (consommateur parti), tous les suivants le sont.
+// NDJSON : une ligne par événement. Binaire : un message par frame, u32 taille du contenu
+// puis un flux StateWriter (EVENT_STREAM_MAGIC, u32 frame, u64 heure en ms, GameEvent[]).
+
+constexpr uint32_t EVENT_STREAM_MAGIC = 0x5645424B; // "BKEV"
+
+const char *gameEventName(GameEventType type) {
+    switch (type) {
+        case GameEventType::BRICK_DESTROYED: return "brick_destroyed";
+        case GameEventType::BONUS_SPAWNED: return "bonus_spawned";
+        case GameEventType::BONUS_CAUGHT: return "bonus_caught";
+        case GameEventType::LIFE_LOST: return "life_lost";
+        default: return "level_up";
+    }
+}
+
+class GameEventStream {
+public:
+    static constexpr size_t MAX_PENDING_EVENTS = 65536;
+    static constexpr int STOP_TIMEOUT_MS = 1000; // Attente maximale d'un consommateur qui ne lit plus, à la fermeture
+
+    GameEventStream(const std::string &path, EventFormat format) : GameEventStream(openTarget(path), format) {}
+
+    // Prend possession d'un descripteur déjà ouvert (socket ou fichier)
+    GameEventStream(int fd, EventFormat format) : fd(fd), format(format) {
+#ifndef _WIN32
+        struct stat info{};
+        isSocket = ::fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+        if (isSocket) ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        worker = std::thread([this] { run(); });
+    }
+
+    ~GameEventStream() {
+        finish();
+#ifndef _WIN32
+        ::close(fd);
+#endif
+    }
+
+    GameEventStream(const GameEventStream &) = delete;
+    GameEventStream &operator=(const GameEventStream &) = delete;
+
+    // Thread du jeu, une fois par frame : copie les événements (même vides, la frame compte)
+    void publish(const std::vector<GameEvent> &frameEvents) {
+        const uint32_t frame = frames++;
+        if (frameEvents.empty()) return;
+        const auto timeMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        bool writerIdle;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (failed || pendingEvents.size() + frameEvents.size() > MAX_PENDING_EVENTS) {
+                droppedEvents += frameEvents.size();
+                ++droppedBatches;
+                return;
+            }
+            pendingBatches.push_back(EventBatch{frame, timeMs, static_cast<uint32_t>(frameEvents.size())});
+            pendingEvents.insert(pendingEvents.end(), frameEvents.begin(), frameEvents.end());
+            writerIdle = waiting;
+        }
+        if (writerIdle) wake.notify_one(); // Sinon le thread de fond reprendra ce lot après son écriture
+    }
+
+    // Écrit ce qui est en attente puis arrête le thread de fond (sans effet la seconde fois)
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    void printSummary(std::ostream &out) const {
+        out << "Event stream: " << eventsWritten << " events in " << batchesWritten << " frames written ("
+                << bytesWritten / 1024 << " KB, " << eventFormatName(format) << "), " << droppedEvents
+                << " events in " << droppedBatches << " frames dropped" << std::endl;
+    }
+
+    std::atomic<uint64_t> eventsWritten{0};
+    std::atomic<uint64_t> batchesWritten{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> droppedEvents{0}; // Consommateur trop lent ou parti
+    std::atomic<uint64_t> droppedBatches{0};
+    std::atomic<bool> failed{false};
+
+private:
+    struct EventBatch {
+        uint32_t frame;
+        uint64_t timeMs;
+        uint32_t count; // Événements de la frame, à la suite dans pendingEvents
+    };
+
+    const int fd;
+    const EventFormat format;
+    bool isSocket = false;
+    uint32_t frames = 0; // Thread du jeu uniquement
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false}; // Modifié sous mutex, lu sans verrou pendant une écriture
+    bool waiting = false; // Thread de fond endormi sur wake (protégé par mutex)
+    std::vector<EventBatch> pendingBatches; // Protégés par mutex
+    std::vector<GameEvent> pendingEvents;
+
+    static int openTarget(const std::string &path) {
+#ifndef _WIN32
+        struct stat info{};
+        if (::stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            sockaddr_un address{};
+            if (path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Event socket path too long: " + path);
+            }
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+                const std::string error = std::strerror(errno);
+                if (fd >= 0) ::close(fd);
+                throw std::runtime_error("Cannot connect to " + path + ": " + error);
+            }
+            return fd;
+        }
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        return fd;
+#else
+        throw std::runtime_error("Event stream requires a POSIX system: " + path);
+#endif
+    }
+
+    void run() {
+        std::vector<EventBatch> batches;
+        std::vector<GameEvent> events;
+        std::vector<GameEvent> batchEvents; // Événements d'une frame, pour writeArray
+        std::vector<uint8_t> out;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                waiting = true;
+                wake.wait(lock, [this] { return stopping || !pendingBatches.empty(); });
+                waiting = false;
+                if (pendingBatches.empty()) return; // Arrêt demandé, tout est écrit
+                batches.swap(pendingBatches);
+                events.swap(pendingEvents);
+            }
+            out.clear();
+            const GameEvent *first = events.data();
+            for (const EventBatch &batch: batches) {
+                if (format == EventFormat::BINARY) {
+                    batchEvents.assign(first, first + batch.count);
+                    encodeBinary(batch, batchEvents, out);
+                } else {
+                    encodeNdjson(batch, first, out);
+                }
+                first += batch.count;
+            }
+            if (!failed && writeAll(out)) {
+                eventsWritten += events.size();
+                batchesWritten += batches.size();
+                bytesWritten += out.size();
+            } else {
+                failed = true;
+                droppedEvents += events.size();
+                droppedBatches += batches.size();
+            }
+            batches.clear();
+            events.clear();
+        }
+    }
+
+    static void encodeBinary(const EventBatch &batch, const std::vector<GameEvent> &events, std::vector<uint8_t> &out) {
+        const size_t start = out.size();
+        out.resize(start + 4);
+        StateWriter writer(out);
+        writer.writeScalar(EVENT_STREAM_MAGIC);
+        writer.writeScalar(batch.frame);
+        writer.writeScalar(batch.timeMs);
+        writer.writeArray(events);
+        const auto payloadSize = static_cast<uint32_t>(out.size() - start - 4);
+        std::memcpy(out.data() + start, &payloadSize, 4);
+    }
+
+    static void encodeNdjson(const EventBatch &batch, const GameEvent *events, std::vector<uint8_t> &out) {
+        char line[192];
+        for (uint32_t i = 0; i < batch.count; ++i) {
+            const GameEvent &event = events[i];
+            int n = std::snprintf(line, sizeof(line), "{\"frame\":%u,\"time_ms\":%llu,\"event\":\"%s\"", batch.frame,
+                                  static_cast<unsigned long long>(batch.timeMs), gameEventName(event.type));
+            switch (event.type) {
+                case GameEventType::BRICK_DESTROYED:
+                    n += std::snprintf(line + n, sizeof(line) - n, ",\"row\":%d,\"column\":%d,\"points\":%d",
+                                       event.row, event.column, event.value);
+                    break;
+                case GameEventType::BONUS_SPAWNED:
+                    n += std::snprintf(line + n, sizeof(line) - n, ",\"row\":%d,\"column\":%d", event.row, event.column);
+                    break;
+                case GameEventType::LIFE_LOST:
+                    n += std::snprintf(line + n, sizeof(line) - n, ",\"lives\":%d", event.value);
+                    break;
+                case GameEventType::LEVEL_UP:
+                    n += std::snprintf(line + n, sizeof(line) - n, ",\"level\":%d", event.value);
+                    break;
+                default:
+                    break;
+            }
+            if (event.bonus != NO_BONUS) {
+                n += std::snprintf(line + n, sizeof(line) - n, ",\"bonus\":%d", event.bonus);
+            }
+            n += std::snprintf(line + n, sizeof(line) - n, ",\"score\":%d}\n", event.score);
+            out.insert(out.end(), line, line + n);
+        }
+    }
+
+    // Socket non bloquante : on attend qu'elle se libère, au plus STOP_TIMEOUT_MS une fois l'arrêt demandé
+    bool writeAll(const std::vector<uint8_t> &data) {
+#ifndef _WIN32
+        size_t done = 0;
+        int waitedAfterStop = 0;
+        while (done < data.size()) {
+            const ssize_t written = isSocket ? ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL)
+                                             : ::write(fd, data.data() + done, data.size() - done);
+            if (written > 0) {
+                done += static_cast<size_t>(written);
+            } else if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (stopping && waitedAfterStop >= STOP_TIMEOUT_MS) {
+                    std::cerr << "Event stream: consumer not reading, remaining events dropped" << std::endl;
+                    return false;
+                }
+                pollfd writable{fd, POLLOUT, 0};
+                ::poll(&writable, 1, 50);
+                if (stopping) waitedAfterStop += 50;
+            } else {
+                std::cerr << "Event stream: " << (written < 0 ? std::strerror(errno) : "write failed")
+                        << ", further events dropped" << std::endl;
+                return false;
+            }
+        }
+        return true;
+#else
+        (void) data;
+        return false;
+#endif
+    }
+};
+
+// --bench-events : coût de publication par frame d'une partie autopilotée (consommateur
+// qui lit tout), puis rafales de 512 événements par frame vers un consommateur bloqué :
+// la publication doit rester bornée, le surplus compté comme abandonné.
+void runEventStreamBenchmark() {
+#ifndef _WIN32
+    constexpr int TICKS = BENCH_GAME_TICKS;
+    constexpr int FLOOD_FRAMES = 2000;
+    constexpr size_t FLOOD_EVENTS = 512;
+    using Clock = std::chrono::steady_clock;
+    const auto percentile = [](std::vector<double> &values, int perMille) {
+        std::sort(values.begin(), values.end());
+        return values[values.size() * perMille / 1000];
+    };
+    std::cout << "Event stream (" << TICKS << " autopiloted ticks, then " << FLOOD_FRAMES << " frames of "
+            << FLOOD_EVENTS << " events to a stalled consumer)" << std::endl;
+    for (const EventFormat format: {EventFormat::NDJSON, EventFormat::BINARY}) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+            throw std::runtime_error(std::string("socketpair: ") + std::strerror(errno));
+        }
+        std::atomic<bool> draining(true);
+        std::atomic<uint64_t> received(0);
+        std::thread consumer([&]() {
+            char buffer[65536];
+            for (;;) {
+                if (!draining) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                const ssize_t n = ::read(fds[1], buffer, sizeof(buffer));
+                if (n <= 0) break;
+                received += static_cast<uint64_t>(n);
+            }
+        });
+
+        GameEventStream stream(fds[0], format);
+        GameWorld world;
+        world.recordEvents = true;
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        world.initGame();
+        Autopilot pilot;
+        std::vector<double> publishUs;
+        publishUs.reserve(TICKS);
+        size_t gameEvents = 0;
+        for (int t = 0; t < TICKS; ++t) {
+            world.applyInput(pilot.decide(world), HEADLESS_TIME_STEP);
+            world.update(HEADLESS_TIME_STEP);
+            if (world.gameOver) world.initGame();
+            gameEvents += world.events.size();
+            const auto start = Clock::now();
+            stream.publish(world.events);
+            publishUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            world.events.clear();
+        }
+        double gameMean = 0.0;
+        for (const double us: publishUs) gameMean += us / TICKS;
+        const double gameP999 = percentile(publishUs, 999);
+
+        draining = false; // Le consommateur ne lit plus : le tampon de la socket se remplit
+        std::vector<GameEvent> burst(FLOOD_EVENTS);
+        publishUs.clear();
+        for (int f = 0; f < FLOOD_FRAMES; ++f) {
+            const auto start = Clock::now();
+            stream.publish(burst);
+            publishUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        const double floodMedian = percentile(publishUs, 500);
+        const double floodP999 = percentile(publishUs, 999);
+        draining = true;
+        stream.finish();
+        ::shutdown(fds[0], SHUT_WR);
+        consumer.join();
+        ::close(fds[1]);
+
+        std::cout << "  " << eventFormatName(format) << ": " << gameEvents << " game events, publish " << gameMean
+                << " us/frame (p99.9 " << gameP999 << " us), flood publish " << floodMedian << " us (p99.9 "
+                << floodP999 << " us); "
+                << stream.eventsWritten << " events written, " << stream.droppedEvents << " dropped in "
+                << stream.droppedBatches << " frames, " << received / 1024 << " KB received" << std::endl;
+    }
+#else
+    std::cout << "Event stream benchmark requires Unix domain sockets" << std::endl;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// High Scores
+//-----------------------------------------------------------------------------
+// Stockage local des scores :
+// - journal en ajout seul (path.<génération>.log), un enregistrement de 24 octets avec
+//   somme de contrôle par partie : une écriture interrompue ne corrompt que la fin ;
+// - instantané compacté (path) : histogramme creux des scores + meilleurs scores, qui
+//   couvre tous les journaux de génération <= la sienne ;
+// - en mémoire : arbre de Fenwick sur les scores (rang en O(log n)) et top-K trié.
+// Le thread de la partie ne fait que mettre à jour l'index en mémoire ; les écritures
+// disque, le chargement et la compaction sont faits par un thread de fond.
+
+struct ScoreRecord {
+    uint32_t score = 0;
+    uint32_t level = 0;
+    int64_t time = 0; // Horodatage Unix
+};
+
+#define SCORE_RECORD_FIELDS(F) F(2, score) F(2, level) F(2, time)
+BREAKOUT_SCHEMA(ScoreRecord, SCORE_RECORD_FIELDS)
+
+// Nombre de parties ayant obtenu un score donné (instantané)
+struct ScoreBucket {
+    uint32_t score = 0;
+    uint32_t count = 0;
+};
+
+#define SCORE_BUCKET_FIELDS(F) F(2, score) F(2, count)
+BREAKOUT_SCHEMA(ScoreBucket, SCORE_BUCKET_FIELDS)
+
+constexpr uint32_t SCORE_LOG_MAGIC = 0x474C5342; // "BSLG"
+constexpr uint32_t SCORE_SNAPSHOT_MAGIC = 0x4E535342; // "BSSN"
+constexpr size_t SCORE_LOG_RECORD_SIZE = 24; // 16 octets de données + 8 de somme de contrôle
+constexpr uint64_t SCORE_COMPACT_RECORDS = 65536; // Compaction quand le journal dépasse cette taille
+constexpr size_t TOP_SCORES = 10;
+
+std::string scoreLogPath(const std::string &path, uint64_t generation) {
+    return path + "." + std::to_string(generation) + ".log";
+}
+
+uint64_t scoreChecksum(const uint8_t *data, size_t size) {
+    uint64_t hash = 0x5C0E5C0E5C0E5C0Eull;
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, std::min<size_t>(8, size - i));
+        hash = hashCombine(hash, word);
+    }
+    return hash;
+}
+
+// Index des scores : arbre de Fenwick sur les valeurs de score (agrandi par doublement),
+// compte exact par score pour l'instantané, et les TOP_SCORES meilleurs enregistrements
+class ScoreRankIndex {
+public:
+    void add(const ScoreRecord &record, uint32_t count = 1) {
+        if (record.score >= counts.size()) {
+            grow(record.score + 1);
+        }
+        counts[record.score] += count;
+        for (size_t i = record.score + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += count;
+        }
+        total += count;
+
+        const auto position = std::upper_bound(best.begin(), best.end(), record,
+                                               [](const ScoreRecord &a, const ScoreRecord &b) {
+                                                   return a.score > b.score;
+                                               });
+        if (position - best.begin() < static_cast<std::ptrdiff_t>(TOP_SCORES)) {
+            best.insert(position, record);
+            if (best.size() > TOP_SCORES) best.pop_back();
+        }
+    }
+
+    // 1 + nombre de parties strictement meilleures (les ex aequo partagent le rang)
+    uint64_t rank(uint32_t score) const {
+        return 1 + total - countAtMost(score);
+    }
+
+    uint64_t size() const { return total; }
+    const std::vector<ScoreRecord> &top() const { return best; }
+
+    void exportBuckets(std::vector<ScoreBucket> &out) const {
+        out.clear();
+        for (size_t score = 0; score < counts.size(); ++score) {
+            if (counts[score] > 0) out.push_back({static_cast<uint32_t>(score), counts[score]});
+        }
+    }
+
+    // Reconstruit l'index d'un instantané (construction linéaire de l'arbre)
+    void assign(const std::vector<ScoreBucket> &buckets, const std::vector<ScoreRecord> &topRecords) {
+        uint32_t maxScore = 0;
+        for (const ScoreBucket &bucket: buckets) maxScore = std::max(maxScore, bucket.score);
+        counts.assign(buckets.empty() ? 0 : maxScore + 1, 0);
+        total = 0;
+        for (const ScoreBucket &bucket: buckets) {
+            counts[bucket.score] += bucket.count;
+            total += bucket.count;
+        }
+        rebuildTree();
+        best = topRecords;
+        if (best.size() > TOP_SCORES) best.resize(TOP_SCORES);
+    }
+
+private:
+    std::vector<uint32_t> counts;
+    std::vector<uint64_t> tree; // Indices 1..n
+    std::vector<ScoreRecord> best; // Score décroissant
+    uint64_t total = 0;
+
+    uint64_t countAtMost(uint32_t score) const {
+        uint64_t sum = 0;
+        for (size_t i = std::min<size_t>(score + 1, counts.size()); i > 0; i -= i & (~i + 1)) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+
+    void grow(size_t needed) {
+        size_t capacity = std::max<size_t>(1024, counts.size());
+        while (capacity < needed) capacity *= 2;
+        counts.resize(capacity, 0);
+        rebuildTree();
+    }
+
+    void rebuildTree() {
+        tree.assign(counts.size() + 1, 0);
+        for (size_t i = 1; i < tree.size(); ++i) {
+            tree[i] += counts[i - 1];
+            const size_t parent = i + (i & (~i + 1));
+            if (parent < tree.size()) tree[parent] += tree[i];
+        }
+    }
+};
+
+// Rang d'un score au moment de la requête
+struct HighScoreRank {
+    uint64_t rank = 0;
+    uint64_t total = 0;
+    uint32_t best = 0;
+};
+
+class HighScoreStore {
+public:
+    explicit HighScoreStore(std::string path) : path(std::move(path)) {
+        worker = std::thread([this] { run(); });
+    }
+
+    ~HighScoreStore() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join(); // Écrit les derniers scores en attente
+    }
+
+    HighScoreStore(const HighScoreStore &) = delete;
+    HighScoreStore &operator=(const HighScoreStore &) = delete;
+
+    // Quelques centaines de ns : l'écriture disque est laissée au thread de fond
+    void submit(uint32_t score, uint32_t level) {
+        ScoreRecord record;
+        record.score = score;
+        record.level = level;
+        record.time = static_cast<int64_t>(std::time(nullptr));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (loaded) index.add(record);
+            pending.push_back(record);
+        }
+        wake.notify_one();
+    }
+
+    // Ne bloque jamais : false tant que le stockage se charge ou si le verrou est pris
+    bool tryQuery(uint32_t score, HighScoreRank &out) {
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock() || !loaded) {
+            return false;
+        }
+        out.rank = index.rank(score);
+        out.total = index.size();
+        out.best = index.top().empty() ? 0 : index.top().front().score;
+        return true;
+    }
+
+    // Attend la fin du chargement (outils hors jeu)
+    void waitLoaded() {
+        std::unique_lock<std::mutex> lock(mutex);
+        loadedSignal.wait(lock, [this] { return loaded; });
+    }
+
+    std::vector<ScoreRecord> top() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.top();
+    }
+
+    // Supprime l'instantané et tous les journaux d'un stockage (aucune instance ouverte)
+    static void removeFiles(const std::string &path) {
+        uint64_t covered = 0;
+        std::ifstream snapshotFile(path, std::ios::binary);
+        if (snapshotFile) {
+            const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(snapshotFile)),
+                                              std::istreambuf_iterator<char>());
+            try {
+                StateReader reader(buffer.data(), buffer.size());
+                if (reader.readScalar<uint32_t>() == SCORE_SNAPSHOT_MAGIC) covered = reader.readScalar<uint64_t>();
+            } catch (const std::exception &) {
+            }
+            snapshotFile.close();
+            std::remove(path.c_str());
+        }
+        for (uint64_t gen = covered; gen > 0 && std::remove(scoreLogPath(path, gen).c_str()) == 0; --gen) {
+        }
+        for (uint64_t gen = covered + 1; std::remove(scoreLogPath(path, gen).c_str()) == 0; ++gen) {
+        }
+    }
+
+    std::atomic<uint64_t> compactions{0};
+    std::atomic<uint64_t> corruptRecords{0}; // Enregistrements illisibles ignorés au chargement
+
+private:
+    const std::string path;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable loadedSignal;
+    bool stopping = false;
+    bool loaded = false;
+    ScoreRankIndex index; // Protégé par mutex
+    std::vector<ScoreRecord> pending; // Scores à écrire (et à indexer si pas encore chargé)
+
+    // Thread de fond uniquement
+    uint64_t generation = 0; // Génération du journal courant
+    uint64_t snapshotGeneration = 0;
+    uint64_t logRecords = 0;
+    std::ofstream log;
+    bool persistent = true; // false si les fichiers existants sont illisibles : on ne les écrase pas
+
+    std::string logPath(uint64_t gen) const { return scoreLogPath(path, gen); }
+
+    void run() {
+        ScoreRankIndex loadedIndex;
+        try {
+            load(loadedIndex);
+        } catch (const std::exception &e) {
+            std::cerr << "High scores: " << e.what() << ", scores will not be saved" << std::endl;
+            persistent = false;
+        }
+        if (persistent) {
+            openLog(generation + 1); // Jamais d'ajout derrière une fin de journal éventuellement tronquée
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const ScoreRecord &record: pending) loadedIndex.add(record);
+            index = std::move(loadedIndex);
+            loaded = true;
+        }
+        loadedSignal.notify_all();
+        if (corruptRecords > 0 || generation > snapshotGeneration + 2) {
+            compact(); // Repartir d'un journal sain et court
+        }
+
+        std::vector<ScoreRecord> batch;
+        for (;;) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !pending.empty(); });
+                batch.swap(pending);
+                stop = stopping;
+            }
+            if (!batch.empty()) {
+                append(batch);
+                batch.clear();
+            }
+            if (logRecords >= SCORE_COMPACT_RECORDS) {
+                compact();
+            }
+            if (stop) {
+                break;
+            }
+        }
+    }
+
+    void load(ScoreRankIndex &target) {
+        std::ifstream snapshotFile(path, std::ios::binary);
+        if (snapshotFile) {
+            const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(snapshotFile)),
+                                              std::istreambuf_iterator<char>());
+            if (buffer.size() < 8 ||
+                scoreChecksum(buffer.data(), buffer.size() - 8) != readChecksum(buffer.data() + buffer.size() - 8)) {
+                throw std::runtime_error(path + ": corrupt snapshot");
+            }
+            StateReader reader(buffer.data(), buffer.size() - 8);
+            if (reader.readScalar<uint32_t>() != SCORE_SNAPSHOT_MAGIC) {
+                throw std::runtime_error(path + " is not a high score file");
+            }
+            snapshotGeneration = reader.readScalar<uint64_t>();
+            std::vector<ScoreBucket> buckets;
+            std::vector<ScoreRecord> topRecords;
+            reader.readArray(buckets);
+            reader.readArray(topRecords);
+            target.assign(buckets, topRecords);
+        }
+
+        // Journaux restants d'une compaction interrompue
+        for (uint64_t gen = snapshotGeneration; gen > 0 && std::remove(logPath(gen).c_str()) == 0; --gen) {
+        }
+        // Journaux plus récents que l'instantané, dans l'ordre
+        generation = snapshotGeneration;
+        for (;;) {
+            std::ifstream logFile(logPath(generation + 1), std::ios::binary);
+            if (!logFile) break;
+            ++generation;
+            const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(logFile)),
+                                              std::istreambuf_iterator<char>());
+            replayLog(buffer, target);
+        }
+    }
+
+    void replayLog(const std::vector<uint8_t> &buffer, ScoreRankIndex &target) {
+        StateReader reader(buffer.data(), buffer.size());
+        if (reader.readScalar<uint32_t>() != SCORE_LOG_MAGIC || reader.readScalar<uint64_t>() != generation) {
+            throw std::runtime_error(logPath(generation) + ": bad log header");
+        }
+        for (size_t offset = logHeaderSize(); offset < buffer.size(); offset += SCORE_LOG_RECORD_SIZE) {
+            if (buffer.size() - offset < SCORE_LOG_RECORD_SIZE ||
+                scoreChecksum(buffer.data() + offset, 16) != readChecksum(buffer.data() + offset + 16)) {
+                corruptRecords += (buffer.size() - offset + SCORE_LOG_RECORD_SIZE - 1) / SCORE_LOG_RECORD_SIZE;
+                break;
+            }
+            ScoreRecord record;
+            std::memcpy(&record.score, buffer.data() + offset, 4);
+            std::memcpy(&record.level, buffer.data() + offset + 4, 4);
+            std::memcpy(&record.time, buffer.data() + offset + 8, 8);
+            target.add(record);
+        }
+    }
+
+    static uint64_t readChecksum(const uint8_t *data) {
+        uint64_t value;
+        std::memcpy(&value, data, 8);
+        return value;
+    }
+
+    static size_t logHeaderSize() {
+        std::vector<uint8_t> header;
+        StateWriter writer(header);
+        writer.writeScalar(SCORE_LOG_MAGIC);
+        writer.writeScalar(uint64_t(0));
+        return header.size();
+    }
+
+    void openLog(uint64_t gen) {
+        if (log.is_open()) log.close();
+        generation = gen;
+        logRecords = 0;
+        std::vector<uint8_t> header;
+        StateWriter writer(header);
+        writer.writeScalar(SCORE_LOG_MAGIC);
+        writer.writeScalar(gen);
+        log.open(logPath(gen), std::ios::binary | std::ios::trunc);
+        log.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+        log.flush();
+        if (!log) {
+            std::cerr << "High scores: cannot write " << logPath(gen) << std::endl;
+        }
+    }
+
+    void append(const std::vector<ScoreRecord> &records) {
+        if (!persistent || records.empty()) {
+            return;
+        }
+        std::vector<uint8_t> bytes(records.size() * SCORE_LOG_RECORD_SIZE);
+        uint8_t *dst = bytes.data();
+        for (const ScoreRecord &record: records) {
+            std::memcpy(dst, &record.score, 4);
+            std::memcpy(dst + 4, &record.level, 4);
+            std::memcpy(dst + 8, &record.time, 8);
+            const uint64_t checksum = scoreChecksum(dst, 16);
+            std::memcpy(dst + 16, &checksum, 8);
+            dst += SCORE_LOG_RECORD_SIZE;
+        }
+        log.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        log.flush();
+        logRecords += records.size();
+    }
+
+    // Seule la copie de l'index se fait sous verrou ; le journal courant est complété puis
+    // remplacé, l'instantané écrit, et les journaux qu'il couvre supprimés
+    void compact() {
+        if (!persistent) {
+            return;
+        }
+        std::vector<ScoreBucket> buckets;
+        std::vector<ScoreRecord> topRecords;
+        std::vector<ScoreRecord> indexed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            indexed.swap(pending); // Déjà dans l'index copié : ils appartiennent au journal couvert
+            index.exportBuckets(buckets);
+            topRecords = index.top();
+        }
+        append(indexed);
+        const uint64_t covered = generation;
+        openLog(generation + 1);
+
+        std::vector<uint8_t> buffer;
+        StateWriter writer(buffer);
+        writer.writeScalar(SCORE_SNAPSHOT_MAGIC);
+        writer.writeScalar(covered);
+        writer.writeArray(buckets);
+        writer.writeArray(topRecords);
+        writer.writeScalar(scoreChecksum(buffer.data(), buffer.size()));
+
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            if (!file) {
+                std::cerr << "High scores: cannot write " << temporary << std::endl;
+                return;
+            }
+        }
+#ifdef _WIN32
+        std::remove(path.c_str()); // rename ne remplace pas un fichier existant sous Windows
+#endif
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::cerr << "High scores: cannot replace " << path << std::endl;
+            return;
+        }
+        for (uint64_t gen = covered; gen > snapshotGeneration; --gen) {
+            std::remove(logPath(gen).c_str());
+        }
+        snapshotGeneration = covered;
+        ++compactions;
+    }
+};
+
+// --bench-scores : coût de l'index seul, puis du stockage complet (journal + compactions)
+void runScoreBenchmark(const RuntimeOptions &options) {
+    constexpr int ENTRIES = 1000000;
+    using Clock = std::chrono::steady_clock;
+    const auto nanosPer = [](Clock::time_point start, int count) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+    };
+    // Scores répartis comme en jeu : beaucoup de petites parties, quelques longues
+    LevelRng rng(options.seed);
+    std::vector<uint32_t> scores(ENTRIES);
+    for (uint32_t &score: scores) {
+        const double u = (rng.next() >> 11) * (1.0 / 9007199254740992.0);
+        score = static_cast<uint32_t>(-std::log(1.0 - u) * 400.0);
+    }
+
+    ScoreRankIndex index;
+    auto start = Clock::now();
+    for (uint32_t score: scores) {
+        ScoreRecord record;
+        record.score = score;
+        index.add(record);
+    }
+    const double insertNs = nanosPer(start, ENTRIES);
+    uint64_t checksum = 0;
+    start = Clock::now();
+    for (uint32_t score: scores) checksum += index.rank(score);
+    const double rankNs = nanosPer(start, ENTRIES);
+    std::cout << "Rank index: " << ENTRIES << " scores, insert " << insertNs << " ns, rank " << rankNs
+            << " ns (checksum " << checksum << ")" << std::endl;
+
+    const std::string path = options.outPrefix.empty() ? "bench_scores.dat" : options.outPrefix + ".dat";
+    HighScoreStore::removeFiles(path);
+    std::unique_ptr<HighScoreStore> store(new HighScoreStore(path));
+    store->waitLoaded();
+    start = Clock::now();
+    for (int i = 0; i < ENTRIES; ++i) store->submit(scores[i], 1);
+    const double submitNs = nanosPer(start, ENTRIES);
+    start = Clock::now();
+    HighScoreRank rank;
+    while (!store->tryQuery(scores[0], rank)) {
+    }
+    const double queryNs = nanosPer(start, 1);
+    std::cout << "Store: submit " << submitNs << " ns, rank query " << queryNs << " ns (" << scores[0] << " ranks "
+            << rank.rank << " / " << rank.total << "), " << store->compactions << " compactions so far" << std::endl;
+    start = Clock::now();
+    store.reset(); // Attend l'écriture des scores en attente
+    const double persistMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    start = Clock::now();
+    store.reset(new HighScoreStore(path));
+    store->waitLoaded();
+    const double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    while (!store->tryQuery(0, rank)) {
+    }
+    std::cout << "Store: final flush " << persistMs << " ms, reload "
+            << loadMs << " ms, " << rank.total << " scores (" << (rank.total == ENTRIES ? "OK" : "MISMATCH")
+            << "), best " << rank.best << std::endl;
+    store.reset();
+    HighScoreStore::removeFiles(path);
+}
+
+//-----------------------------------------------------------------------------
+// Batched Rendering
+//-----------------------------------------------------------------------------
+// Transformation monde -> écran d'une case de la grille (échelle uniforme + translation)
+struct WorldTransform {
+    float scale = 1.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+
+    void addObject(DrawCommandBuffer &commands, const Vec2 &position, const Vec2 &size, const Color &color) const {
+        DrawQuad &quad = commands.addQuad(DrawLayer::WORLD, DrawMaterial::SOLID);
+        quad.x0 = offsetX + position.x * scale;
+        quad.y0 = offsetY + position.y * scale;
+        quad.x1 = quad.x0 + size.x * scale;
+        quad.y1 = quad.y0 + size.y * scale;
+        quad.u0 = quad.v0 = quad.u1 = quad.v1 = 0.0f;
+        setQuadColor(quad, color);
+    }
+};
+
+// Ajoute tous les objets visibles d'un monde au tampon de commandes
+void batchWorld(DrawCommandBuffer &commands, const GameWorld &world, const WorldTransform &transform) {
+    for (const uint32_t handle: world.liveBricks.live()) {
+        const Block &block = world.blocks[handle];
+        transform.addObject(commands, block.position, block.size, block.color);
+    }
+    for (const auto &bonus: world.fallingBonuses) {
+        if (bonus.active) {
+            transform.addObject(commands, bonus.position, bonus.size, bonus.color);
+        }
+    }
+    transform.addObject(commands, world.playerPaddle.position, world.playerPaddle.size, world.playerPaddle.color);
+    if (!world.gameOver) {
+        transform.addObject(commands, world.gameBall.position, world.gameBall.size, world.gameBall.color);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Render Backends
+//-----------------------------------------------------------------------------
+// Exécutants d'un DrawCommandBuffer trié (--backend=...) :
+//   gl2  : mode immédiat (glBegin/glEnd), le chemin d'origine du jeu
+//   gl   : tableaux clients entrelacés, un glDrawArrays par commande (défaut)
+//   soft : rastériseur logiciel dans une image CPU, envoyée à l'écran par glDrawPixels
+//   null : ne dessine rien et se contente de compter, pour mesurer le coût CPU seul
+
+// Cible d'une exécution : limites de la couche WORLD, taille de la fenêtre pour la couche
+// SCREEN et taille en pixels du framebuffer
+struct DrawView {
+    float boundX = 1.0f;
+    float boundY = 1.0f;
+    int screenWidth = WINDOW_WIDTH;
+    int screenHeight = WINDOW_HEIGHT;
+    int targetWidth = WINDOW_WIDTH;
+    int targetHeight = WINDOW_HEIGHT;
+};
+
+// Compteurs cumulés depuis le dernier takeStats()
+struct RenderStats {
+    uint32_t commands = 0;
+    uint32_t drawCalls = 0;
+    uint32_t stateChanges = 0; // Changements de couche ou de matériau
+    size_t quads = 0;
+};
+
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // Exécute les commandes [begin, end) du tampon trié (une frame peut être coupée en deux
+    // appels, par exemple autour du post-traitement)
+    virtual void execute(const DrawCommandBuffer &buffer, const DrawView &view, size_t begin, size_t end) = 0;
+
+    void execute(const DrawCommandBuffer &buffer, const DrawView &view) {
+        execute(buffer, view, 0, buffer.commands().size());
+    }
+
+    RenderStats takeStats() {
+        const RenderStats result = stats;
+        stats = RenderStats();
+        return result;
+    }
+
+protected:
+    RenderStats stats;
+
+    // Compte la commande ; vrai si elle change la couche ou le matériau de la précédente
+    bool countCommand(const DrawCommand &command, const DrawCommand *&previous) {
+        ++stats.commands;
+        stats.quads += command.count;
+        const bool changed = !previous || previous->layer != command.layer || previous->material != command.material;
+        stats.stateChanges += changed;
+        previous = &command;
+        return changed;
+    }
+};
+
+class NullBackend : public RenderBackend {
+public:
+    using RenderBackend::execute;
+
+    void execute(const DrawCommandBuffer &buffer, const DrawView &, size_t begin, size_t end) override {
+        const DrawCommand *previous = nullptr;
+        for (size_t i = begin; i < end; ++i) {
+            countCommand(buffer.commands()[i], previous);
+        }
+    }
+};
+
+// Base des deux chemins OpenGL : la couche WORLD utilise les matrices courantes (celles de
+// updateProjectionMatrix), la couche SCREEN un repère en pixels empilé le temps des commandes
+class GlBackendBase : public RenderBackend {
+public:
+    using RenderBackend::execute;
+
+    explicit GlBackendBase(const SdfFont *textFont) : font(textFont) {
+    }
+
+    void execute(const DrawCommandBuffer &buffer, const DrawView &view, size_t begin, size_t end) override {
+        const DrawCommand *previous = nullptr;
+        bool screen = false;
+        for (size_t i = begin; i < end; ++i) {
+            const DrawCommand &command = buffer.commands()[i];
+            countCommand(command, previous);
+            if (command.material == DrawMaterial::CLEAR) {
+                glClearColor(command.clearColor.r, command.clearColor.g, command.clearColor.b, command.clearColor.a);
+                glClear(GL_COLOR_BUFFER_BIT);
+                continue;
+            }
+            if (command.layer == DrawLayer::SCREEN && !screen) {
+                beginScreen(view);
+                screen = true;
+            }
+            if (command.material == DrawMaterial::TEXT) {
+                if (!font || !font->ready()) continue;
+                font->bindGl();
+                drawQuads(buffer.quads().data() + command.first, command.first, command.count, true);
+                font->unbindGl();
+            } else {
+                drawQuads(buffer.quads().data() + command.first, command.first, command.count, false);
+            }
+            ++stats.drawCalls;
+        }
+        if (screen) endScreen();
+    }
+
+protected:
+    const SdfFont *font;
+
+    // first : index du premier quad dans le tampon (pour les tableaux de sommets)
+    virtual void drawQuads(const DrawQuad *quads, uint32_t first, uint32_t count, bool textured) = 0;
+
+    static void beginScreen(const DrawView &view) {
+        // Repère écran en pixels (origine en haut à gauche), comme ImGui
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0.0, view.screenWidth, view.screenHeight, 0.0, -1.0, 1.0);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+    }
+
+    static void endScreen() {
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+};
+
+class Gl2Backend : public GlBackendBase {
+public:
+    using GlBackendBase::GlBackendBase;
+
+protected:
+    void drawQuads(const DrawQuad *quads, uint32_t, uint32_t count, bool textured) override {
+        glBegin(GL_QUADS);
+        for (uint32_t i = 0; i < count; ++i) {
+            const DrawQuad &q = quads[i];
+            glColor4ubv(q.color);
+            if (textured) glTexCoord2f(q.u0, q.v0);
+            glVertex2f(q.x0, q.y0);
+            if (textured) glTexCoord2f(q.u1, q.v0);
+            glVertex2f(q.x1, q.y0);
+            if (textured) glTexCoord2f(q.u1, q.v1);
+            glVertex2f(q.x1, q.y1);
+            if (textured) glTexCoord2f(q.u0, q.v1);
+            glVertex2f(q.x0, q.y1);
+        }
+        glEnd();
+    }
+};
+
+// Sommets entrelacés (20 octets) construits une fois par quad, aux mêmes index que le tampon
+class GlArrayBackend : public GlBackendBase {
+public:
+    using GlBackendBase::GlBackendBase;
+
+protected:
+    void drawQuads(const DrawQuad *quads, uint32_t first, uint32_t count, bool textured) override {
+        if (vertices.size() < (static_cast<size_t>(first) + count) * 4) {
+            vertices.resize((static_cast<size_t>(first) + count) * 4);
+        }
+        Vertex *out = &vertices[static_cast<size_t>(first) * 4];
+        for (uint32_t i = 0; i < count; ++i) {
+            const DrawQuad &q = quads[i];
+            const Vertex corners[4] = {
+                {q.x0, q.y0, q.u0, q.v0, {}}, {q.x1, q.y0, q.u1, q.v0, {}},
+                {q.x1, q.y1, q.u1, q.v1, {}}, {q.x0, q.y1, q.u0, q.v1, {}}
+            };
+            for (const Vertex &corner: corners) {
+                *out = corner;
+                std::memcpy(out->color, q.color, sizeof(q.color));
+                ++out;
+            }
+        }
+        const Vertex *base = &vertices[static_cast<size_t>(first) * 4];
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &base->x);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), base->color);
+        if (textured) {
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &base->u);
+        }
+        glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(count * 4));
+        if (textured) glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+
+private:
+    struct Vertex {
+        float x, y, u, v;
+        uint8_t color[4];
+    };
+
+    std::vector<Vertex> vertices;
+};
+
+// Rastérisation CPU dans une image RGBA8 de la taille de la cible : les quads sont alignés
+// sur les axes, un pixel est couvert si son centre est dans le rectangle. Le texte suit le
+// shader SDF (distance bilinéaire, bord adouci sur environ un pixel). Sans présentation
+// (present = false), l'image reste en mémoire, ce qui permet de la mesurer sans OpenGL.
+class SoftwareBackend : public RenderBackend {
+public:
+    using RenderBackend::execute;
+
+    SoftwareBackend(const SdfFont *textFont, bool presentToGl) : font(textFont), present(presentToGl) {
+    }
+
+    void execute(const DrawCommandBuffer &buffer, const DrawView &view, size_t begin, size_t end) override {
+        width = std::max(view.targetWidth, 1);
+        height = std::max(view.targetHeight, 1);
+        pixels.resize(static_cast<size_t>(width) * height);
+        const DrawCommand *previous = nullptr;
+        for (size_t i = begin; i < end; ++i) {
+            const DrawCommand &command = buffer.commands()[i];
+            countCommand(command, previous);
+            if (command.material == DrawMaterial::CLEAR) {
+                std::fill(pixels.begin(), pixels.end(), packRgba(command.clearColor));
+                continue;
+            }
+            // Passage en pixels cible : y vers le bas, ligne 0 en haut
+            float scaleX, scaleY, offsetX, offsetY;
+            if (command.layer == DrawLayer::WORLD) {
+                scaleX = width / (2.0f * view.boundX);
+                scaleY = -height / (2.0f * view.boundY);
+                offsetX = view.boundX * scaleX;
+                offsetY = height * 0.5f;
+            } else {
+                scaleX = static_cast<float>(width) / std::max(view.screenWidth, 1);
+                scaleY = static_cast<float>(height) / std::max(view.screenHeight, 1);
+                offsetX = offsetY = 0.0f;
+            }
+            const bool textured = command.material == DrawMaterial::TEXT;
+            if (textured && (!font || !font->generated())) continue;
+            for (uint32_t q = 0; q < command.count; ++q) {
+                fillQuad(buffer.quads()[command.first + q], scaleX, scaleY, offsetX, offsetY, textured);
+            }
+        }
+        if (present) {
+            presentImage();
+            ++stats.drawCalls;
+        }
+    }
+
+    const std::vector<uint32_t> &image() const { return pixels; } // Lignes de haut en bas
+
+private:
+    const SdfFont *font;
+    bool present;
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels; // RGBA8, octets dans l'ordre r, g, b, a
+    std::vector<uint32_t> flipped; // Lignes de bas en haut pour glDrawPixels
+
+    static uint32_t packRgba(const Color &color) {
+        const uint8_t rgba[4] = {
+            static_cast<uint8_t>(color.r * 255.0f), static_cast<uint8_t>(color.g * 255.0f),
+            static_cast<uint8_t>(color.b * 255.0f), static_cast<uint8_t>(color.a * 255.0f)
+        };
+        uint32_t packed;
+        std::memcpy(&packed, rgba, sizeof(packed));
+        return packed;
+    }
+
+    // Mélange source-over (alpha 0..255) de la couleur du quad dans le pixel
+    static void blend(uint32_t &pixel, const uint8_t *color, int alpha) {
+        uint8_t dst[4];
+        std::memcpy(dst, &pixel, sizeof(dst));
+        for (int c = 0; c < 3; ++c) {
+            dst[c] = static_cast<uint8_t>((color[c] * alpha + dst[c] * (255 - alpha) + 127) / 255);
+        }
+        dst[3] = 255;
+        std::memcpy(&pixel, dst, sizeof(dst));
+    }
+
+    void fillQuad(const DrawQuad &quad, float scaleX, float scaleY, float offsetX, float offsetY, bool textured) {
+        float px0 = offsetX + quad.x0 * scaleX, px1 = offsetX + quad.x1 * scaleX;
+        float py0 = offsetY + quad.y0 * scaleY, py1 = offsetY + quad.y1 * scaleY;
+        float u0 = quad.u0, u1 = quad.u1, v0 = quad.v0, v1 = quad.v1;
+        if (px1 < px0) {
+            std::swap(px0, px1);
+            std::swap(u0, u1);
+        }
+        if (py1 < py0) {
+            std::swap(py0, py1);
+            std::swap(v0, v1);
+        }
+        // Pixels dont le centre (x + 0.5) est dans [p0, p1)
+        const int xBegin = std::max(0, static_cast<int>(std::ceil(px0 - 0.5f)));
+        const int xEnd = std::min(width, static_cast<int>(std::ceil(px1 - 0.5f)));
+        const int yBegin = std::max(0, static_cast<int>(std::ceil(py0 - 0.5f)));
+        const int yEnd = std::min(height, static_cast<int>(std::ceil(py1 - 0.5f)));
+        if (xBegin >= xEnd || yBegin >= yEnd) return;
+
+        if (!textured) {
+            const int alpha = quad.color[3];
+            uint32_t packed;
+            std::memcpy(&packed, quad.color, sizeof(packed));
+            for (int y = yBegin; y < yEnd; ++y) {
+                uint32_t *row = &pixels[static_cast<size_t>(y) * width];
+                if (alpha == 255) {
+                    std::fill(row + xBegin, row + xEnd, packed);
+                } else {
+                    for (int x = xBegin; x < xEnd; ++x) blend(row[x], quad.color, alpha);
+                }
+            }
+            return;
+        }
+
+        // Équivalent de fwidth : variation de la distance stockée pour un pixel écran
+        const float dudx = (u1 - u0) / (px1 - px0), dvdy = (v1 - v0) / (py1 - py0);
+        const float texelsPerPixel = std::fabs(dudx) * SDF_ATLAS_WIDTH;
+        const float edge = std::max(texelsPerPixel * (128.0f / SDF_PADDING / 255.0f) * 0.7f, 0.01f);
+        for (int y = yBegin; y < yEnd; ++y) {
+            const float v = v0 + (y + 0.5f - py0) * dvdy;
+            uint32_t *row = &pixels[static_cast<size_t>(y) * width];
+            for (int x = xBegin; x < xEnd; ++x) {
+                const float d = font->distance(u0 + (x + 0.5f - px0) * dudx, v);
+                const float t = std::min(std::max((d - 0.5f + edge) / (2.0f * edge), 0.0f), 1.0f);
+                const int alpha = static_cast<int>(t * t * (3.0f - 2.0f * t) * quad.color[3] + 0.5f);
+                if (alpha > 0) blend(row[x], quad.color, alpha);
+            }
+        }
+    }
+
+    void presentImage() {
+        flipped.resize(pixels.size());
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(&flipped[static_cast<size_t>(height - 1 - y) * width], &pixels[static_cast<size_t>(y) * width],
+                        width * sizeof(uint32_t));
+        }
+        // Position raster au coin bas gauche du viewport, indépendamment des matrices du jeu
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+        glRasterPos2f(-1.0f, -1.0f);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, flipped.data());
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+};
+
+inline std::unique_ptr<RenderBackend> makeRenderBackend(RenderBackendType type, const SdfFont *font) {
+    switch (type) {
+        case RenderBackendType::GL2: return std::unique_ptr<RenderBackend>(new Gl2Backend(font));
+        case RenderBackendType::SOFTWARE: return std::unique_ptr<RenderBackend>(new SoftwareBackend(font, true));
+        case RenderBackendType::NONE: return std::unique_ptr<RenderBackend>(new NullBackend());
+        default: return std::unique_ptr<RenderBackend>(new GlArrayBackend(font));
+    }
+}
+
+// --bench-render : coût CPU d'une frame sans fenêtre ni OpenGL (simulation, enregistrement
+// des commandes, tri), puis exécution par le backend null et par le rastériseur logiciel
+void runRenderBenchmark() {
+    constexpr int FRAMES = 5000;
+    using Clock = std::chrono::steady_clock;
+    const auto micros = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+    // Atlas SDF (partie CPU) depuis la police par défaut d'ImGui, comme en jeu
+    ImGui::CreateContext();
+    ImFontAtlas *fonts = ImGui::GetIO().Fonts;
+    fonts->AddFontDefault();
+    SdfFont font;
+    const bool text = font.generate(fonts->Sources[0].FontData);
+
+    const auto runScene = [&](const char *name, GameWorld &world) {
+        Autopilot pilot;
+        DrawCommandBuffer commands;
+        NullBackend nullBackend;
+        SoftwareBackend softBackend(&font, false);
+        DrawView view;
+        view.boundX = world.gameBoundX;
+        view.boundY = world.gameBoundY;
+        std::vector<DrawQuad> hud;
+        double updateUs = 0.0, recordUs = 0.0, sortUs = 0.0, nullUs = 0.0, softUs = 0.0;
+        for (int f = 0; f < FRAMES; ++f) {
+            const auto start = Clock::now();
+            world.applyInput(pilot.decide(world), VERSUS_TIME_STEP);
+            world.update(VERSUS_TIME_STEP);
+            if (world.gameOver) world.initGame();
+            const auto updated = Clock::now();
+            commands.reset();
+            commands.clear(Color{0.1f, 0.1f, 0.12f, 1.0f});
+            // HUD enregistré en premier : le tri doit le repasser au-dessus du monde
+            hud.clear();
+            if (text) {
+                font.addText(hud, 15.0f, 10.0f, HUD_TEXT_SIZE, IM_COL32(255, 255, 255, 255),
+                             "SCORE: " + std::to_string(world.score));
+                font.addText(hud, view.screenWidth - 100.0f, 10.0f, HUD_TEXT_SIZE, IM_COL32(255, 255, 255, 255),
+                             "LIVES: " + std::to_string(world.lives));
+            }
+            commands.addQuads(DrawLayer::SCREEN, DrawMaterial::TEXT, hud.data(), hud.size());
+            batchWorld(commands, world, WorldTransform());
+            const auto recorded = Clock::now();
+            commands.finish();
+            const auto sorted = Clock::now();
+            nullBackend.execute(commands, view);
+            const auto nulled = Clock::now();
+            softBackend.execute(commands, view);
+            const auto rasterized = Clock::now();
+            updateUs += micros(updated - start);
+            recordUs += micros(recorded - updated);
+            sortUs += micros(sorted - recorded);
+            nullUs += micros(nulled - sorted);
+            softUs += micros(rasterized - nulled);
+        }
+        const RenderStats stats = nullBackend.takeStats();
+        std::cout << "  " << name << ": " << static_cast<double>(stats.quads) / FRAMES << " quads, "
+                << static_cast<double>(stats.commands) / FRAMES << " commands/frame; update " << updateUs / FRAMES
+                << " us, record " << recordUs / FRAMES << " us, sort " << sortUs / FRAMES << " us, null "
+                << nullUs / FRAMES << " us (CPU frame " << (updateUs + recordUs + sortUs + nullUs) / FRAMES
+                << " us), soft " << view.targetWidth << "x" << view.targetHeight << " " << softUs / FRAMES << " us"
+                << std::endl;
+    };
+
+    std::cout << "Render command buffer (" << FRAMES << " frames" << (text ? "" : ", no SDF font") << ")"
+            << std::endl;
+    GameWorld typical;
+    typical.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+    typical.initGame();
+    runScene("typical", typical);
+
+    GameWorld stress;
+    stress.level = std::make_shared<const LevelData>(makeBenchmarkLevel(128, 64));
+    stress.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+    stress.initGame();
+    runScene("128x64 level", stress);
+    ImGui::DestroyContext();
+}
+
+// --bench-bricks : niveau de 1024 x 1024 briques rangé ligne par ligne puis en ordre de
+// Morton. Requêtes de collision le long de trajectoires verticales, horizontales et
+// diagonales, niveau plein puis vidé à 90 % (la requête lit alors tout le voisinage de la
+// balle), et enregistrement des quads des briques restantes.
+void runBrickLayoutBenchmark() {
+    constexpr int SIDE = 1024;
+    constexpr int PATHS = 2000;
+    constexpr int STEPS = 256;
+    using Clock = std::chrono::steady_clock;
+    const auto level = std::make_shared<const LevelData>(makeBenchmarkLevel(SIDE, SIDE));
+    std::cout << "Brick layout (" << SIDE << "x" << SIDE << " level, " << PATHS * STEPS << " queries per sweep)"
+            << std::endl;
+
+    uint64_t reference[6] = {};
+    for (const BrickLayout layout: {BrickLayout::ROW_MAJOR, BrickLayout::MORTON}) {
+        GameWorld world;
+        world.level = level;
+        world.brickLayout = layout;
+        world.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+        auto start = Clock::now();
+        world.initGame();
+        const double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        // Trajectoires rectilignes repliées dans la zone des briques ; la somme de contrôle
+        // porte sur (rangée, colonne) de la brique touchée, indépendante du rangement
+        int sweepIndex = 0;
+        bool identical = true;
+        const auto sweep = [&](float dx, float dy) {
+            LevelRng rng(42);
+            GameObject ball;
+            ball.size = Vec2{BALL_RADIUS * 2.0f, BALL_RADIUS * 2.0f};
+            const float width = 2.0f * world.gameBoundX - ball.size.x;
+            uint64_t checksum = 0;
+            const auto sweepStart = Clock::now();
+            for (int p = 0; p < PATHS; ++p) {
+                float x = rng.unit() * width, y = rng.unit() * LEVEL_AREA_HEIGHT;
+                for (int s = 0; s < STEPS; ++s) {
+                    x = std::fmod(x + dx * 0.004f + width, width);
+                    y = std::fmod(y + dy * 0.004f + LEVEL_AREA_HEIGHT, LEVEL_AREA_HEIGHT);
+                    ball.position = Vec2{x - world.gameBoundX, BRICK_START_Y - y};
+                    const uint32_t hit = world.findBrickHit(ball);
+                    if (hit != LiveBrickSet::NO_SLOT) {
+                        checksum = checksum * 31 + world.blocks[hit].row * SIDE + world.blocks[hit].column;
+                    }
+                }
+            }
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - sweepStart).count() /
+                              (PATHS * STEPS);
+            if (layout == BrickLayout::ROW_MAJOR) {
+                reference[sweepIndex] = checksum;
+            } else {
+                identical = identical && reference[sweepIndex] == checksum;
+            }
+            ++sweepIndex;
+            return ns;
+        };
+
+        const double fullVertical = sweep(0.0f, 1.0f), fullHorizontal = sweep(1.0f, 0.0f);
+        const double fullDiagonal = sweep(0.7f, 0.7f);
+        // 90 % des briques détruites, les mêmes pour les deux rangements
+        for (Block &block: world.blocks) {
+            if (mixHash(static_cast<uint64_t>(block.row) * SIDE + block.column) % 10 != 0) block.active = false;
+        }
+        world.rebuildBrickIndex();
+        const double sparseVertical = sweep(0.0f, 1.0f), sparseHorizontal = sweep(1.0f, 0.0f);
+        const double sparseDiagonal = sweep(0.7f, 0.7f);
+
+        DrawCommandBuffer commands;
+        start = Clock::now();
+        batchWorld(commands, world, WorldTransform());
+        const double recordMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        std::cout << "  " << (layout == BrickLayout::MORTON ? "morton   " : "row-major") << ": build "
+                << buildMs << " ms; query full " << fullVertical << " / " << fullHorizontal << " / " << fullDiagonal
+                << " ns, 90% destroyed " << sparseVertical << " / " << sparseHorizontal << " / " << sparseDiagonal
+                << " ns (vertical / horizontal / diagonal); record " << commands.quads().size() << " quads "
+                << recordMs << " ms" << (layout == BrickLayout::MORTON ? identical ? ", same hits" : ", HITS DIFFER" : "")
+                << std::endl;
+    }
+}
+
+#ifdef BREAKOUT_VULKAN
+//-----------------------------------------------------------------------------
+// Vulkan Renderer
+//-----------------------------------------------------------------------------
+// Rendu optionnel (--renderer=vulkan, compilé avec -DBREAKOUT_VULKAN=ON). Tous les objets du
+// jeu sont des instances d'un même quad : le lot de la frame est recopié dans un tampon
+// d'instances mappé une fois pour toutes, un par frame en vol. Chaque frame en vol a sa
+// barrière (fence) et son sémaphore d'acquisition ; le sémaphore de fin de rendu appartient
+// à l'image de la swapchain. ImGui est dessiné par imgui_impl_vulkan dans la même passe.
+
+// SPIR-V produit par glslc au moment de la compilation (shaders/vk_quad.*, voir CMakeLists.txt)
+const uint32_t VK_QUAD_VERT_SPV[] =
+#include "vk_quad.vert.inc"
+;
+const uint32_t VK_QUAD_FRAG_SPV[] =
+#include "vk_quad.frag.inc"
+;
+
+constexpr VkDeviceSize VK_MIN_INSTANCES = 1024; // Capacité initiale de chaque tampon d'instances
+constexpr uint32_t VK_IMGUI_DESCRIPTOR_SETS = 8; // Textures ImGui simultanées (atlas de police et ses remplaçants)
+
+void checkVk(VkResult result, const char *what) {
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(std::string("Vulkan: ") + what + " failed (" + std::to_string(result) + ")");
+    }
+}
+
+VkPresentModeKHR vulkanPresentMode(PresentMode mode) {
+    switch (mode) {
+        case PresentMode::FIFO_RELAXED: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        case PresentMode::MAILBOX: return VK_PRESENT_MODE_MAILBOX_KHR;
+        case PresentMode::IMMEDIATE: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        default: return VK_PRESENT_MODE_FIFO_KHR;
+    }
+}
+
+// Une instance par objet : rectangle en coordonnées monde et couleur RGBA8
+struct QuadInstance {
+    float x0, y0, x1, y1;
+    uint32_t color;
+};
+
+class VulkanRenderer {
+public:
+    VulkanRenderer(GLFWwindow *targetWindow, PresentMode mode, int framesInFlight) : window(targetWindow),
+        requestedMode(mode) {
+        if (!glfwVulkanSupported()) {
+            throw std::runtime_error("Vulkan: no loader or driver found");
+        }
+        createDevice();
+        createRenderPass();
+        createPipeline();
+        createFrames(framesInFlight);
+        if (!createSwapchain()) {
+            throw std::runtime_error("Vulkan: window has no drawable area");
+        }
+    }
+
+    ~VulkanRenderer() {
+        if (device) {
+            vkDeviceWaitIdle(device);
+            for (Frame &frame: frames) {
+                destroyInstanceBuffer(frame);
+                vkDestroyFence(device, frame.inFlight, nullptr);
+                vkDestroySemaphore(device, frame.imageAcquired, nullptr);
+            }
+            destroySwapchainResources();
+            if (swapchain) vkDestroySwapchainKHR(device, swapchain, nullptr);
+            vkDestroyPipeline(device, pipeline, nullptr);
+            vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+            vkDestroyRenderPass(device, renderPass, nullptr);
+            vkDestroyCommandPool(device, commandPool, nullptr);
+            vkDestroyDevice(device, nullptr);
+        }
+        if (surface) vkDestroySurfaceKHR(instance, surface, nullptr);
+        if (instance) vkDestroyInstance(instance, nullptr);
+    }
+
+    VulkanRenderer(const VulkanRenderer &) = delete;
+    VulkanRenderer &operator=(const VulkanRenderer &) = delete;
+
+    // À appeler après ImGui_ImplGlfw_InitForVulkan
+    void initImGui() {
+        ImGui_ImplVulkan_InitInfo info = {};
+        info.ApiVersion = VK_API_VERSION_1_0;
+        info.Instance = instance;
+        info.PhysicalDevice = physicalDevice;
+        info.Device = device;
+        info.QueueFamily = queueFamily;
+        info.Queue = queue;
+        // Le backend exige strictement plus que le minimum : l'atlas recréé coexiste un temps avec l'ancien
+        info.DescriptorPoolSize = VK_IMGUI_DESCRIPTOR_SETS;
+        info.RenderPass = renderPass;
+        info.MinImageCount = std::max(2u, minImageCount);
+        info.ImageCount = std::max(info.MinImageCount, static_cast<uint32_t>(images.size()));
+        info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+        info.CheckVkResultFn = [](VkResult result) {
+            if (result != VK_SUCCESS) std::cerr << "Vulkan (ImGui): error " << result << std::endl;
+        };
+        if (!ImGui_ImplVulkan_Init(&info)) {
+            throw std::runtime_error("Vulkan: ImGui backend initialization failed");
+        }
+    }
+
+    void waitIdle() const { vkDeviceWaitIdle(device); }
+
+    // Taille du framebuffer changée : la swapchain est recréée à la frame suivante
+    void resized() { swapchainDirty = true; }
+
+    PresentMode presentMode() const { return activeMode; }
+    bool supports(PresentMode mode) const {
+        return std::find(supportedModes.begin(), supportedModes.end(), vulkanPresentMode(mode)) !=
+               supportedModes.end();
+    }
+
+    void setPresentMode(PresentMode mode) {
+        requestedMode = mode;
+        swapchainDirty = true;
+    }
+
+    int framesInFlight() const { return static_cast<int>(frames.size()); }
+    uint32_t imageCount() const { return static_cast<uint32_t>(images.size()); }
+    const char *deviceName() const { return deviceProperties.deviceName; }
+
+    // Dessine les quads unis de la couche monde du tampon trié (visibles dans [-boundX, boundX]
+    // x [-boundY, boundY]) puis l'interface ImGui si ui n'est pas nul, et présente l'image
+    void drawFrame(const DrawCommandBuffer &scene, float boundX, float boundY, ImDrawData *ui) {
+        if (swapchainDirty && !recreateSwapchain()) {
+            return; // Fenêtre réduite
+        }
+        Frame &frame = frames[frameIndex];
+        // La frame qui utilisait ces ressources il y a framesInFlight() frames doit être terminée
+        checkVk(vkWaitForFences(device, 1, &frame.inFlight, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+
+        uint32_t imageIndex = 0;
+        const VkResult acquired = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frame.imageAcquired,
+                                                        VK_NULL_HANDLE, &imageIndex);
+        if (acquired == VK_ERROR_OUT_OF_DATE_KHR) {
+            swapchainDirty = true;
+            return;
+        }
+        if (acquired == VK_SUBOPTIMAL_KHR) {
+            swapchainDirty = true; // L'image reste utilisable pour cette frame
+        } else {
+            checkVk(acquired, "vkAcquireNextImageKHR");
+        }
+        checkVk(vkResetFences(device, 1, &frame.inFlight), "vkResetFences"); // Seulement si on soumet
+
+        // --- Instances : écriture directe dans le tampon mappé de cette frame ---
+        Color background{0.1f, 0.1f, 0.12f, 1.0f};
+        size_t count = 0;
+        for (const DrawCommand &command: scene.commands()) {
+            if (command.layer != DrawLayer::WORLD) break; // Tampon trié : la suite est le HUD
+            if (command.material == DrawMaterial::CLEAR) {
+                background = command.clearColor;
+            } else if (command.material == DrawMaterial::SOLID) {
+                count += command.count;
+            }
+        }
+        reserveInstances(frame, count);
+        size_t written = 0;
+        for (const DrawCommand &command: scene.commands()) {
+            if (command.layer != DrawLayer::WORLD) break;
+            if (command.material != DrawMaterial::SOLID) continue;
+            for (uint32_t i = 0; i < command.count; ++i) {
+                const DrawQuad &source = scene.quads()[command.first + i];
+                QuadInstance &quad = frame.mapped[written++];
+                quad.x0 = source.x0;
+                quad.y0 = source.y0;
+                quad.x1 = source.x1;
+                quad.y1 = source.y1;
+                std::memcpy(&quad.color, source.color, sizeof(uint32_t));
+            }
+        }
+
+        // --- Enregistrement ---
+        VkCommandBuffer commands = frame.commands;
+        checkVk(vkResetCommandBuffer(commands, 0), "vkResetCommandBuffer");
+        VkCommandBufferBeginInfo begin = {};
+        begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        checkVk(vkBeginCommandBuffer(commands, &begin), "vkBeginCommandBuffer");
+
+        VkClearValue clear = {};
+        clear.color.float32[0] = background.r;
+        clear.color.float32[1] = background.g;
+        clear.color.float32[2] = background.b;
+        clear.color.float32[3] = background.a;
+        VkRenderPassBeginInfo pass = {};
+        pass.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        pass.renderPass = renderPass;
+        pass.framebuffer = framebuffers[imageIndex];
+        pass.renderArea.extent = extent;
+        pass.clearValueCount = 1;
+        pass.pClearValues = &clear;
+        vkCmdBeginRenderPass(commands, &pass, VK_SUBPASS_CONTENTS_INLINE);
+
+        if (count > 0) {
+            const VkViewport viewport = {
+                0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f
+            };
+            const VkRect2D scissor = {{0, 0}, extent};
+            vkCmdSetViewport(commands, 0, 1, &viewport);
+            vkCmdSetScissor(commands, 0, 1, &scissor);
+            vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            // Monde -> NDC ; l'axe Y de Vulkan pointe vers le bas
+            const float projection[4] = {1.0f / boundX, -1.0f / boundY, 0.0f, 0.0f};
+            vkCmdPushConstants(commands, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(projection),
+                               projection);
+            const VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commands, 0, 1, &frame.instances, &offset);
+            vkCmdDraw(commands, 4, static_cast<uint32_t>(count), 0, 0); // Bande de 2 triangles par instance
+        }
+        if (ui) {
+            ImGui_ImplVulkan_RenderDrawData(ui, commands);
+        }
+        vkCmdEndRenderPass(commands);
+        checkVk(vkEndCommandBuffer(commands), "vkEndCommandBuffer");
+
+        // --- Soumission : attend l'image acquise, signale la fin du rendu de cette image ---
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        VkSubmitInfo submit = {};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.waitSemaphoreCount = 1;
+        submit.pWaitSemaphores = &frame.imageAcquired;
+        submit.pWaitDstStageMask = &waitStage;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &commands;
+        submit.signalSemaphoreCount = 1;
+        submit.pSignalSemaphores = &renderFinished[imageIndex];
+        checkVk(vkQueueSubmit(queue, 1, &submit, frame.inFlight), "vkQueueSubmit");
+
+        VkPresentInfoKHR present = {};
+        present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        present.waitSemaphoreCount = 1;
+        present.pWaitSemaphores = &renderFinished[imageIndex];
+        present.swapchainCount = 1;
+        present.pSwapchains = &swapchain;
+        present.pImageIndices = &imageIndex;
+        const VkResult presented = vkQueuePresentKHR(queue, &present);
+        if (presented == VK_ERROR_OUT_OF_DATE_KHR || presented == VK_SUBOPTIMAL_KHR) {
+            swapchainDirty = true;
+        } else {
+            checkVk(presented, "vkQueuePresentKHR");
+        }
+        frameIndex = (frameIndex + 1) % frames.size();
+    }
+
+private:
+    struct Frame {
+        VkCommandBuffer commands = VK_NULL_HANDLE;
+        VkFence inFlight = VK_NULL_HANDLE;
+        VkSemaphore imageAcquired = VK_NULL_HANDLE;
+        VkBuffer instances = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        QuadInstance *mapped = nullptr; // Mappé tant que le tampon existe
+        VkDeviceSize capacity = 0; // En instances
+    };
+
+    GLFWwindow *window;
+    PresentMode requestedMode;
+    PresentMode activeMode = PresentMode::FIFO;
+    VkInstance instance = VK_NULL_HANDLE;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties deviceProperties = {};
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t queueFamily = 0;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkSurfaceFormatKHR surfaceFormat = {};
+    std::vector<VkPresentModeKHR> supportedModes;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkExtent2D extent = {};
+    uint32_t minImageCount = 2;
+    std::vector<VkImage> images;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+    std::vector<VkSemaphore> renderFinished; // Un par image de la swapchain
+    bool swapchainDirty = false;
+
+    std::vector<Frame> frames;
+    size_t frameIndex = 0;
+
+    void createDevice() {
+        uint32_t extensionCount = 0;
+        const char **extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+        VkApplicationInfo application = {};
+        application.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        application.pApplicationName = "BreakOut";
+        application.apiVersion = VK_API_VERSION_1_0;
+        VkInstanceCreateInfo instanceInfo = {};
+        instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        instanceInfo.pApplicationInfo = &application;
+        instanceInfo.enabledExtensionCount = extensionCount;
+        instanceInfo.ppEnabledExtensionNames = extensions;
+        checkVk(vkCreateInstance(&instanceInfo, nullptr, &instance), "vkCreateInstance");
+        checkVk(glfwCreateWindowSurface(instance, window, nullptr, &surface), "glfwCreateWindowSurface");
+
+        // --- Premier GPU capable de présenter sur la fenêtre (les GPU dédiés d'abord) ---
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+        std::vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+        int bestScore = -1;
+        for (VkPhysicalDevice candidate: devices) {
+            uint32_t familyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> families(familyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+            for (uint32_t family = 0; family < familyCount; ++family) {
+                VkBool32 canPresent = VK_FALSE;
+                vkGetPhysicalDeviceSurfaceSupportKHR(candidate, family, surface, &canPresent);
+                if (!(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT) || !canPresent) {
+                    continue;
+                }
+                VkPhysicalDeviceProperties properties;
+                vkGetPhysicalDeviceProperties(candidate, &properties);
+                const int score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 2
+                                  : properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 1 : 0;
+                if (score > bestScore) {
+                    bestScore = score;
+                    physicalDevice = candidate;
+                    queueFamily = family;
+                    deviceProperties = properties;
+                }
+                break;
+            }
+        }
+        if (!physicalDevice) {
+            throw std::runtime_error("Vulkan: no device can present to the window");
+        }
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        const float priority = 1.0f;
+        VkDeviceQueueCreateInfo queueInfo = {};
+        queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueInfo.queueFamilyIndex = queueFamily;
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &priority;
+        const char *deviceExtensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        VkDeviceCreateInfo deviceInfo = {};
+        deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        deviceInfo.enabledExtensionCount = 1;
+        deviceInfo.ppEnabledExtensionNames = deviceExtensions;
+        checkVk(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device), "vkCreateDevice");
+        vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+        checkVk(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool), "vkCreateCommandPool");
+
+        // --- Format : BGRA/RGBA 8 bits linéaire, comme le framebuffer OpenGL par défaut ---
+        uint32_t formatCount = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+        std::vector<VkSurfaceFormatKHR> formats(formatCount);
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, formats.data());
+        if (formats.empty()) {
+            throw std::runtime_error("Vulkan: surface has no format");
+        }
+        surfaceFormat = formats[0];
+        for (const VkSurfaceFormatKHR &format: formats) {
+            if ((format.format == VK_FORMAT_B8G8R8A8_UNORM || format.format == VK_FORMAT_R8G8B8A8_UNORM) &&
+                format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                surfaceFormat = format;
+                break;
+            }
+        }
+
+        uint32_t modeCount = 0;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, nullptr);
+        supportedModes.resize(modeCount);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, supportedModes.data());
+    }
+
+    void createRenderPass() {
+        VkAttachmentDescription color = {};
+        color.format = surfaceFormat.format;
+        color.samples = VK_SAMPLE_COUNT_1_BIT;
+        color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        VkAttachmentReference colorReference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+        // L'écriture attend que le moteur de présentation ait rendu l'image (sémaphore d'acquisition)
+        VkSubpassDependency dependency = {};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        VkRenderPassCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        info.attachmentCount = 1;
+        info.pAttachments = &color;
+        info.subpassCount = 1;
+        info.pSubpasses = &subpass;
+        info.dependencyCount = 1;
+        info.pDependencies = &dependency;
+        checkVk(vkCreateRenderPass(device, &info, nullptr, &renderPass), "vkCreateRenderPass");
+    }
+
+    VkShaderModule createShaderModule(const uint32_t *code, size_t size) const {
+        VkShaderModuleCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        info.codeSize = size;
+        info.pCode = code;
+        VkShaderModule module = VK_NULL_HANDLE;
+        checkVk(vkCreateShaderModule(device, &info, nullptr, &module), "vkCreateShaderModule");
+        return module;
+    }
+
+    void createPipeline() {
+        VkPushConstantRange pushRange = {VK_SHADER_STAGE_VERTEX_BIT, 0, 4 * sizeof(float)};
+        VkPipelineLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushRange;
+        checkVk(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout), "vkCreatePipelineLayout");
+
+        const VkShaderModule vertex = createShaderModule(VK_QUAD_VERT_SPV, sizeof(VK_QUAD_VERT_SPV));
+        const VkShaderModule fragment = createShaderModule(VK_QUAD_FRAG_SPV, sizeof(VK_QUAD_FRAG_SPV));
+        VkPipelineShaderStageCreateInfo stages[2] = {};
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = vertex;
+        stages[0].pName = "main";
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = fragment;
+        stages[1].pName = "main";
+
+        // Pas de tampon de sommets : les coins viennent de gl_VertexIndex, le reste de l'instance
+        VkVertexInputBindingDescription binding = {0, sizeof(QuadInstance), VK_VERTEX_INPUT_RATE_INSTANCE};
+        VkVertexInputAttributeDescription attributes[2] = {
+            {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(QuadInstance, x0)},
+            {1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(QuadInstance, color)}
+        };
+        VkPipelineVertexInputStateCreateInfo vertexInput = {};
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInput.vertexBindingDescriptionCount = 1;
+        vertexInput.pVertexBindingDescriptions = &binding;
+        vertexInput.vertexAttributeDescriptionCount = 2;
+        vertexInput.pVertexAttributeDescriptions = attributes;
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        VkPipelineViewportStateCreateInfo viewportState = {};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+        VkPipelineRasterizationStateCreateInfo rasterization = {};
+        rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterization.cullMode = VK_CULL_MODE_NONE;
+        rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterization.lineWidth = 1.0f;
+        VkPipelineMultisampleStateCreateInfo multisample = {};
+        multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        VkPipelineColorBlendAttachmentState blendAttachment = {};
+        blendAttachment.blendEnable = VK_TRUE; // Bonus translucides
+        blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+        blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                         VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        VkPipelineColorBlendStateCreateInfo blend = {};
+        blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        blend.attachmentCount = 1;
+        blend.pAttachments = &blendAttachment;
+        const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamic = {};
+        dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamic.dynamicStateCount = 2;
+        dynamic.pDynamicStates = dynamicStates;
+
+        VkGraphicsPipelineCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.stageCount = 2;
+        info.pStages = stages;
+        info.pVertexInputState = &vertexInput;
+        info.pInputAssemblyState = &inputAssembly;
+        info.pViewportState = &viewportState;
+        info.pRasterizationState = &rasterization;
+        info.pMultisampleState = &multisample;
+        info.pColorBlendState = &blend;
+        info.pDynamicState = &dynamic;
+        info.layout = pipelineLayout;
+        info.renderPass = renderPass;
+        const VkResult created = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline);
+        vkDestroyShaderModule(device, vertex, nullptr);
+        vkDestroyShaderModule(device, fragment, nullptr);
+        checkVk(created, "vkCreateGraphicsPipelines");
+    }
+
+    // Faux si la fenêtre n'a pas de surface visible (réduite) : on réessaiera plus tard
+    bool createSwapchain() {
+        VkSurfaceCapabilitiesKHR capabilities;
+        checkVk(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities),
+                "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
+        extent = capabilities.currentExtent;
+        if (extent.width == UINT32_MAX) {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            extent.width = std::min(std::max(static_cast<uint32_t>(width), capabilities.minImageExtent.width),
+                                    capabilities.maxImageExtent.width);
+            extent.height = std::min(std::max(static_cast<uint32_t>(height), capabilities.minImageExtent.height),
+                                     capabilities.maxImageExtent.height);
+        }
+        if (extent.width == 0 || extent.height == 0) {
+            return false;
+        }
+
+        activeMode = supports(requestedMode) ? requestedMode : PresentMode::FIFO;
+        if (activeMode != requestedMode) {
+            std::cerr << "Vulkan: present mode " << presentModeName(requestedMode) << " unsupported, using fifo"
+                    << std::endl;
+            requestedMode = activeMode;
+        }
+        // Une image de plus que de frames en vol : le CPU n'attend jamais une image libre.
+        // Mailbox en veut une de plus pour toujours avoir une image complète à échanger.
+        uint32_t wanted = static_cast<uint32_t>(frames.size()) + 1;
+        if (activeMode == PresentMode::MAILBOX) ++wanted;
+        minImageCount = std::max(capabilities.minImageCount, wanted);
+        if (capabilities.maxImageCount > 0) {
+            minImageCount = std::min(minImageCount, capabilities.maxImageCount);
+        }
+
+        VkSwapchainCreateInfoKHR info = {};
+        info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        info.surface = surface;
+        info.minImageCount = minImageCount;
+        info.imageFormat = surfaceFormat.format;
+        info.imageColorSpace = surfaceFormat.colorSpace;
+        info.imageExtent = extent;
+        info.imageArrayLayers = 1;
+        info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        info.preTransform = capabilities.currentTransform;
+        info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        info.presentMode = vulkanPresentMode(activeMode);
+        info.clipped = VK_TRUE;
+        info.oldSwapchain = swapchain;
+        VkSwapchainKHR created = VK_NULL_HANDLE;
+        checkVk(vkCreateSwapchainKHR(device, &info, nullptr, &created), "vkCreateSwapchainKHR");
+        if (swapchain) vkDestroySwapchainKHR(device, swapchain, nullptr);
+        swapchain = created;
+
+        uint32_t count = 0;
+        vkGetSwapchainImagesKHR(device, swapchain, &count, nullptr);
+        images.resize(count);
+        vkGetSwapchainImagesKHR(device, swapchain, &count, images.data());
+        imageViews.resize(count);
+        framebuffers.resize(count);
+        renderFinished.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            VkImageViewCreateInfo viewInfo = {};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = images[i];
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = surfaceFormat.format;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.layerCount = 1;
+            checkVk(vkCreateImageView(device, &viewInfo, nullptr, &imageViews[i]), "vkCreateImageView");
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = &imageViews[i];
+            framebufferInfo.width = extent.width;
+            framebufferInfo.height = extent.height;
+            framebufferInfo.layers = 1;
+            checkVk(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffers[i]), "vkCreateFramebuffer");
+
+            VkSemaphoreCreateInfo semaphoreInfo = {};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            checkVk(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinished[i]), "vkCreateSemaphore");
+        }
+        swapchainDirty = false;
+        return true;
+    }
+
+    void destroySwapchainResources() {
+        for (size_t i = 0; i < images.size(); ++i) {
+            vkDestroyFramebuffer(device, framebuffers[i], nullptr);
+            vkDestroyImageView(device, imageViews[i], nullptr);
+            vkDestroySemaphore(device, renderFinished[i], nullptr);
+        }
+        images.clear();
+        imageViews.clear();
+        framebuffers.clear();
+        renderFinished.clear();
+    }
+
+    bool recreateSwapchain() {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width == 0 || height == 0) {
+            return false;
+        }
+        vkDeviceWaitIdle(device); // Plus aucune frame en vol n'utilise les anciennes images
+        destroySwapchainResources();
+        if (!createSwapchain()) {
+            return false;
+        }
+        ImGui_ImplVulkan_SetMinImageCount(std::max(2u, minImageCount));
+        return true;
+    }
+
+    void createFrames(int count) {
+        frames.resize(static_cast<size_t>(count));
+        VkCommandBufferAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = commandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // La première attente passe directement
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        for (Frame &frame: frames) {
+            checkVk(vkAllocateCommandBuffers(device, &allocateInfo, &frame.commands), "vkAllocateCommandBuffers");
+            checkVk(vkCreateFence(device, &fenceInfo, nullptr, &frame.inFlight), "vkCreateFence");
+            checkVk(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.imageAcquired), "vkCreateSemaphore");
+            reserveInstances(frame, VK_MIN_INSTANCES);
+        }
+    }
+
+    uint32_t memoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+            if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+                return i;
+            }
+        }
+        throw std::runtime_error("Vulkan: no host-visible coherent memory");
+    }
+
+    // Le tampon de la frame n'est plus lu par le GPU (sa barrière a été attendue) :
+    // on peut le remplacer par un plus grand
+    void reserveInstances(Frame &frame, VkDeviceSize count) {
+        if (count <= frame.capacity) return;
+        destroyInstanceBuffer(frame);
+        VkDeviceSize capacity = std::max(VK_MIN_INSTANCES, frame.capacity);
+        while (capacity < count) capacity *= 2;
+
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = capacity * sizeof(QuadInstance);
+        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        checkVk(vkCreateBuffer(device, &bufferInfo, nullptr, &frame.instances), "vkCreateBuffer");
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, frame.instances, &requirements);
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = memoryType(requirements.memoryTypeBits,
+                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                  VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        checkVk(vkAllocateMemory(device, &allocateInfo, nullptr, &frame.memory), "vkAllocateMemory");
+        checkVk(vkBindBufferMemory(device, frame.instances, frame.memory, 0), "vkBindBufferMemory");
+        void *mapped = nullptr;
+        checkVk(vkMapMemory(device, frame.memory, 0, VK_WHOLE_SIZE, 0, &mapped), "vkMapMemory");
+        frame.mapped = static_cast<QuadInstance *>(mapped);
+        frame.capacity = capacity;
+    }
+
+    void destroyInstanceBuffer(Frame &frame) {
+        if (frame.memory) {
+            vkUnmapMemory(device, frame.memory);
+            vkFreeMemory(device, frame.memory, nullptr);
+        }
+        if (frame.instances) vkDestroyBuffer(device, frame.instances, nullptr);
+        frame.memory = VK_NULL_HANDLE;
+        frame.instances = VK_NULL_HANDLE;
+        frame.mapped = nullptr;
+    }
+};
+#endif // BREAKOUT_VULKAN
+
+//-----------------------------------------------------------------------------
+// Level Editor
+//-----------------------------------------------------------------------------
+// Éditeur ImGui : seules les cellules visibles sont parcourues, et elles sont dessinées
+// comme une texture d'un pixel par cellule (un seul quad ImGui quelle que soit la taille
+// de la grille). Chaque coup de pinceau est enregistré comme une liste de différences
+// (index, avant, après) pour l'annulation.
+class LevelEditor {
+public:
+    enum class Action {
+        NONE,
+        PLAY,
+        EXIT
+    };
+
+    LevelEditor() : level(stockLevel()) {
+    }
+
+    const LevelData &currentLevel() const { return level; }
+
+    void setLevel(const LevelData &newLevel) {
+        level = newLevel;
+        undoStack.clear();
+        redoStack.clear();
+    }
+
+    // À appeler tant que le contexte GL existe encore
+    // Faux : cellules dessinées en rectangles ImGui (rendu sans OpenGL)
+    void setTextureCells(bool enabled) { textureCells = enabled; }
+
+    void releaseGL() {
+        if (texture) {
+            glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+    }
+
+    Action draw(const int &wW, const int &wH) {
+        Action action = Action::NONE;
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(ImVec2(wW, wH));
+        ImGui::Begin("LevelEditor", nullptr,
+                     ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+                     ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoBringToFrontOnFocus);
+
+        ImGui::BeginChild("Tools", ImVec2(230.0f, 0.0f));
+        drawTools(action);
+        ImGui::EndChild();
+        ImGui::SameLine();
+        ImGui::BeginChild("Canvas", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Borders,
+                          ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoMove);
+        drawCanvas();
+        ImGui::EndChild();
+
+        ImGui::End();
+        return action;
+    }
+
+private:
+    struct CellChange {
+        uint32_t index;
+        LevelCell before;
+        LevelCell after;
+    };
+
+    using Stroke = std::vector<CellChange>;
+    static constexpr size_t UNDO_CHANGE_BUDGET = 4u << 20; // Nombre max de cellules mémorisées
+
+    LevelData level;
+    std::vector<Stroke> undoStack;
+    std::vector<Stroke> redoStack;
+    Stroke currentStroke;
+    int lastPaintRow = -1;
+    int lastPaintColumn = -1;
+
+    LevelCell brush{CellKind::RED, 1, NO_BONUS};
+    float cellSize = 24.0f;
+    int newWidth = BRICKS_PER_ROW;
+    int newHeight = BRICK_ROWS;
+    char path[256] = "level.lvl";
+    std::string status;
+
+    bool textureCells = true;
+    GLuint texture = 0;
+    int textureWidth = 0;
+    int textureHeight = 0;
+    std::vector<uint32_t> pixels;
+
+    static uint32_t cellColor(const LevelCell &cell) {
+        if (cell.kind == CellKind::EMPTY) {
+            return IM_COL32(32, 32, 38, 255);
+        }
+        Color color = getColorFromEnum(cellBrickColor(cell.kind), cell.hits > 1);
+        if (cell.bonus != NO_BONUS) {
+            // Briques bonus éclaircies
+            color.r += (1.0f - color.r) * 0.5f;
+            color.g += (1.0f - color.g) * 0.5f;
+            color.b += (1.0f - color.b) * 0.5f;
+        }
+        return IM_COL32(static_cast<int>(color.r * 255.0f), static_cast<int>(color.g * 255.0f),
+                        static_cast<int>(color.b * 255.0f), 255);
+    }
+
+    void drawTools(Action &action) {
+        ImGui::SeparatorText("Brush");
+        static const char *kindNames[] = {"Empty", "Red (7)", "Orange (5)", "Green (3)", "Yellow (1)", "Wall", "Reflective"};
+        int kind = static_cast<int>(brush.kind);
+        for (int i = 0; i < static_cast<int>(CellKind::COUNT); ++i) {
+            ImGui::RadioButton(kindNames[i], &kind, i);
+        }
+        brush.kind = static_cast<CellKind>(kind);
+        int hits = brush.hits;
+        ImGui::SliderInt("Hits", &hits, 1, 9);
+        brush.hits = static_cast<uint8_t>(hits);
+        static const char *bonusNames[] = {
+            "None", "Life +", "Life -", "Paddle +", "Paddle -", "Ball slow", "Ball fast", "Straighten", "Angle"
+        };
+        int bonus = brush.bonus + 1;
+        ImGui::Combo("Bonus", &bonus, bonusNames, IM_ARRAYSIZE(bonusNames));
+        brush.bonus = static_cast<int8_t>(bonus - 1);
+        ImGui::TextDisabled("Left: paint  Right: erase");
+
+        ImGui::SeparatorText("View");
+        ImGui::SliderFloat("Zoom", &cellSize, 2.0f, 48.0f, "%.0f px");
+
+        ImGui::SeparatorText("Grid");
+        ImGui::Text("%d x %d (%zu cells)", level.width, level.height, level.cells.size());
+        ImGui::InputInt("Width", &newWidth);
+        ImGui::InputInt("Height", &newHeight);
+        newWidth = std::max(1, std::min(newWidth, 4096));
+        newHeight = std::max(1, std::min(newHeight, 4096));
+        if (ImGui::Button("New empty grid")) {
+            LevelData fresh;
+            fresh.resize(newWidth, newHeight);
+            setLevel(fresh);
+        }
+
+        ImGui::SeparatorText("History");
+        const ImGuiIO &io = ImGui::GetIO();
+        ImGui::BeginDisabled(undoStack.empty());
+        if (ImGui::Button("Undo") || (io.KeyCtrl && !io.KeyShift && ImGui::IsKeyPressed(ImGuiKey_Z))) {
+            undo();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(redoStack.empty());
+        if (ImGui::Button("Redo") || (io.KeyCtrl && (ImGui::IsKeyPressed(ImGuiKey_Y) ||
+                                                     (io.KeyShift && ImGui::IsKeyPressed(ImGuiKey_Z))))) {
+            redo();
+        }
+        ImGui::EndDisabled();
+        ImGui::Text("%zu undo / %zu redo", undoStack.size(), redoStack.size());
+
+        ImGui::SeparatorText("File");
+        ImGui::InputText("##path", path, sizeof(path));
+        if (ImGui::Button("Save")) {
+            try {
+                saveLevelFile(path, level);
+                status = std::string("Saved ") + path;
+            } catch (const std::exception &e) {
+                status = e.what();
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Load")) {
+            try {
+                setLevel(loadLevelFile(path));
+                status = std::string("Loaded ") + path;
+            } catch (const std::exception &e) {
+                status = e.what();
+            }
+        }
+        if (!status.empty()) {
+            ImGui::TextWrapped("%s", status.c_str());
+        }
+
+        ImGui::Separator();
+        if (ImGui::Button("PLAY", ImVec2(100.0f, 30.0f))) {
+            action = Action::PLAY;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("MENU", ImVec2(100.0f, 30.0f))) {
+            action = Action::EXIT;
+        }
+    }
+
+    void drawCanvas() {
+        const ImVec2 origin = ImGui::GetCursorScreenPos(); // Coin de la cellule (0,0), défilement inclus
+        const ImVec2 viewSize = ImGui::GetContentRegionAvail();
+        ImGui::Dummy(ImVec2(level.width * cellSize, level.height * cellSize));
+
+        // --- Plage visible uniquement ---
+        const float scrollX = ImGui::GetScrollX();
+        const float scrollY = ImGui::GetScrollY();
+        const int firstColumn = std::max(0, static_cast<int>(scrollX / cellSize));
+        const int firstRow = std::max(0, static_cast<int>(scrollY / cellSize));
+        const int lastColumn = std::min(level.width, static_cast<int>((scrollX + viewSize.x) / cellSize) + 1);
+        const int lastRow = std::min(level.height, static_cast<int>((scrollY + viewSize.y) / cellSize) + 1);
+        const int columns = lastColumn - firstColumn;
+        const int rows = lastRow - firstRow;
+        if (columns <= 0 || rows <= 0) {
+            return;
+        }
+
+        handlePainting(origin);
+
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        const ImVec2 p0(origin.x + firstColumn * cellSize, origin.y + firstRow * cellSize);
+        const ImVec2 p1(p0.x + columns * cellSize, p0.y + rows * cellSize);
+        if (textureCells) {
+            // --- Une texture, un pixel par cellule visible ---
+            uploadVisibleCells(firstColumn, firstRow, columns, rows);
+            drawList->AddImage(static_cast<ImTextureID>(texture), p0, p1, ImVec2(0.0f, 0.0f),
+                               ImVec2(static_cast<float>(columns) / textureWidth,
+                                      static_cast<float>(rows) / textureHeight));
+        } else {
+            // Sans OpenGL : un rectangle par cellule visible
+            for (int r = 0; r < rows; ++r) {
+                for (int c = 0; c < columns; ++c) {
+                    const ImVec2 a(p0.x + c * cellSize, p0.y + r * cellSize);
+                    drawList->AddRectFilled(a, ImVec2(a.x + cellSize, a.y + cellSize),
+                                            cellColor(level.at(firstRow + r, firstColumn + c)));
+                }
+            }
+        }
+
+        // Quadrillage seulement quand les cellules sont assez grandes
+        if (cellSize >= 8.0f) {
+            const ImU32 gridColor = IM_COL32(0, 0, 0, 90);
+            for (int c = firstColumn; c <= lastColumn; ++c) {
+                const float x = origin.x + c * cellSize;
+                drawList->AddLine(ImVec2(x, p0.y), ImVec2(x, p1.y), gridColor);
+            }
+            for (int r = firstRow; r <= lastRow; ++r) {
+                const float y = origin.y + r * cellSize;
+                drawList->AddLine(ImVec2(p0.x, y), ImVec2(p1.x, y), gridColor);
+            }
+        }
+
+        // Infobulle de la cellule survolée
+        int hoverRow, hoverColumn;
+        if (ImGui::IsWindowHovered() && cellUnderMouse(origin, hoverRow, hoverColumn)) {
+            const LevelCell &cell = level.at(hoverRow, hoverColumn);
+            ImGui::SetTooltip("(%d, %d) hits %d bonus %d", hoverColumn, hoverRow, cell.hits, cell.bonus);
+        }
+    }
+
+    bool cellUnderMouse(const ImVec2 &origin, int &row, int &column) const {
+        const ImVec2 mouse = ImGui::GetMousePos();
+        column = static_cast<int>(std::floor((mouse.x - origin.x) / cellSize));
+        row = static_cast<int>(std::floor((mouse.y - origin.y) / cellSize));
+        return column >= 0 && row >= 0 && column < level.width && row < level.height;
+    }
+
+    void handlePainting(const ImVec2 &origin) {
+        const bool painting = ImGui::IsMouseDown(ImGuiMouseButton_Left);
+        const bool erasing = ImGui::IsMouseDown(ImGuiMouseButton_Right);
+        int row, column;
+        if ((painting || erasing) && ImGui::IsWindowHovered() && cellUnderMouse(origin, row, column)) {
+            const LevelCell value = painting ? brush : LevelCell();
+            if (lastPaintRow < 0) {
+                paintCell(row, column, value);
+            } else {
+                // Tracer la ligne depuis la cellule précédente pour ne pas laisser de trous
+                const int steps = std::max(std::abs(row - lastPaintRow), std::abs(column - lastPaintColumn));
+                for (int i = 1; i <= steps; ++i) {
+                    paintCell(lastPaintRow + (row - lastPaintRow) * i / steps,
+                              lastPaintColumn + (column - lastPaintColumn) * i / steps, value);
+                }
+            }
+            lastPaintRow = row;
+            lastPaintColumn = column;
+        } else if (!painting && !erasing) {
+            lastPaintRow = -1;
+            lastPaintColumn = -1;
+            if (!currentStroke.empty()) {
+                commitStroke();
+            }
+        }
+    }
+
+    void paintCell(int row, int column, const LevelCell &value) {
+        LevelCell &cell = level.at(row, column);
+        if (cell.kind == value.kind && cell.hits == value.hits && cell.bonus == value.bonus) {
+            return;
+        }
+        currentStroke.push_back(
+            CellChange{static_cast<uint32_t>(static_cast<size_t>(row) * level.width + column), cell, value});
+        cell = value;
+    }
+
+    void commitStroke() {
+        undoStack.push_back(std::move(currentStroke));
+        currentStroke.clear();
+        redoStack.clear();
+
+        // Borner la mémoire de l'historique en oubliant les plus vieux coups
+        size_t total = 0;
+        for (const auto &stroke: undoStack) total += stroke.size();
+        size_t dropped = 0;
+        while (total > UNDO_CHANGE_BUDGET && dropped + 1 < undoStack.size()) {
+            total -= undoStack[dropped].size();
+            ++dropped;
+        }
+        undoStack.erase(undoStack.begin(), undoStack.begin() + static_cast<std::ptrdiff_t>(dropped));
+    }
+
+    void undo() {
+        if (undoStack.empty()) return;
+        Stroke stroke = std::move(undoStack.back());
+        undoStack.pop_back();
+        for (auto it = stroke.rbegin(); it != stroke.rend(); ++it) {
+            level.cells[it->index] = it->before;
+        }
+        redoStack.push_back(std::move(stroke));
+    }
+
+    void redo() {
+        if (redoStack.empty()) return;
+        Stroke stroke = std::move(redoStack.back());
+        redoStack.pop_back();
+        for (const auto &change: stroke) {
+            level.cells[change.index] = change.after;
+        }
+        undoStack.push_back(std::move(stroke));
+    }
+
+    void uploadVisibleCells(int firstColumn, int firstRow, int columns, int rows) {
+        pixels.resize(static_cast<size_t>(columns) * rows);
+        for (int r = 0; r < rows; ++r) {
+            const LevelCell *src = &level.at(firstRow + r, firstColumn);
+            uint32_t *dst = &pixels[static_cast<size_t>(r) * columns];
+            for (int c = 0; c < columns; ++c) {
+                dst[c] = cellColor(src[c]);
+            }
+        }
+
+        if (!texture) {
+            glGenTextures(1, &texture);
+        }
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (columns > textureWidth || rows > textureHeight) {
+            // Agrandir par puissances de deux pour éviter de réallouer à chaque défilement
+            while (textureWidth < columns) textureWidth = std::max(64, textureWidth * 2);
+            while (textureHeight < rows) textureHeight = std::max(64, textureHeight * 2);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, textureWidth, textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                         nullptr);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns, rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
 
 //-----------------------------------------------------------------------------
 // Game Class
 //-----------------------------------------------------------------------------
 class Game {
 public:
-    Game(int width, int height, const char *title)
-        : windowWidth(width), windowHeight(height) // game objects use default constructors
+    Game(int width, int height, const char *title, const RuntimeOptions &runtimeOptions = RuntimeOptions())
+        // game objects use default constructors
+        : windowWidth(width), windowHeight(height), options(runtimeOptions), rewind(runtimeOptions.rewindSeconds)
     {
+#ifndef BREAKOUT_VULKAN
+        if (options.vulkan) {
+            throw std::runtime_error("Vulkan renderer not built (configure with -DBREAKOUT_VULKAN=ON)");
+        }
+#endif
+        if (options.vulkan && options.offscreen) {
+            throw std::runtime_error("--offscreen requires the OpenGL renderer");
+        }
         if (!initGLFW(width, height, title)) {
             throw std::runtime_error("Failed to initialize GLFW or create window");
         }
@@ -210,21 +8941,143 @@ public:
         ImGui::StyleColorsDark();
 
         // Initialize ImGui Backends
-        ImGui_ImplGlfw_InitForOpenGL(window, true); // Installs callbacks
-        ImGui_ImplOpenGL2_Init();
+        if (options.vulkan) {
+#ifdef BREAKOUT_VULKAN
+            vulkanRenderer.reset(new VulkanRenderer(window, options.presentMode, options.framesInFlight));
+            ImGui_ImplGlfw_InitForVulkan(window, true); // Installs callbacks
+            vulkanRenderer->initImGui();
+            levelEditor.setTextureCells(false); // Pas de texture OpenGL : cellules en rectangles ImGui
+            std::cout << "Renderer: Vulkan on " << vulkanRenderer->deviceName() << ", "
+                    << presentModeName(vulkanRenderer->presentMode()) << ", " << vulkanRenderer->imageCount()
+                    << " images, " << vulkanRenderer->framesInFlight() << " frame(s) in flight" << std::endl;
+#endif
+        } else {
+            ImGui_ImplGlfw_InitForOpenGL(window, true); // Installs callbacks
+            ImGui_ImplOpenGL2_Init();
+
+            // --- HUD: atlas SDF généré depuis la police par défaut d'ImGui ---
+            ImFontAtlas *fonts = ImGui::GetIO().Fonts;
+            if (fonts->Sources.empty()) {
+                fonts->AddFontDefault();
+            }
+            if (!hudFont.build(fonts->Sources[0].FontData)) {
+                std::cerr << "SDF font unavailable, HUD drawn with ImGui" << std::endl;
+            }
+            renderBackend = makeRenderBackend(options.backend, &hudFont);
+            if (options.backend != RenderBackendType::GL) {
+                std::cout << "Render backend: " << renderBackendName(options.backend) << std::endl;
+            }
+        }
+
+        // --- Low-jitter mode: préchauffer les pools puis verrouiller la mémoire ---
+        if (options.lowJitter) {
+            prewarmPools();
+            lowJitterReport = applyLowJitterSettings(options);
+            for (const auto &line: lowJitterReport) {
+                std::cout << "[low-jitter] " << line << std::endl;
+            }
+        }
 
         // --- Initialize Game ---
         srand(static_cast<unsigned int>(time(nullptr)));
+        if (!options.levelPath.empty()) {
+            // Niveau personnalisé : joué depuis le menu et ouvert dans l'éditeur
+            LevelData customLevel = loadLevelFile(options.levelPath);
+            levelEditor.setLevel(customLevel);
+            selectedLevel = std::make_shared<const LevelData>(std::move(customLevel));
+        }
         glfwSetWindowUserPointer(window, this); // Link GLFW window to this Game instance
         setupCallbacks(); // Setup non-ImGui callbacks (only framebuffer size needed now)
         updateProjectionMatrix(width, height); // Initial projection setup
+        windowedWidth = width;
+        windowedHeight = height;
+        if (!options.offscreen && options.displayMode != DisplayMode::WINDOWED) {
+            setDisplayMode(options.displayMode, options.monitorIndex);
+        } else if (!options.offscreen) {
+            updateRefreshRate(monitorUnderWindow());
+        }
 
         currentState = GameState::MENU;
+
+        // --- Offscreen mode: tout le rendu va dans un FBO, la partie démarre directement ---
+        if (options.offscreen) {
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            if (!framebufferFunctions.load() ||
+                !offscreenTarget.create(framebufferFunctions, framebufferWidth, framebufferHeight)) {
+                throw std::runtime_error("Offscreen mode requires GL_EXT_framebuffer_object");
+            }
+            framebufferFunctions.bindFramebuffer(FBO_FRAMEBUFFER, offscreenTarget.framebuffer);
+            glViewport(0, 0, framebufferWidth, framebufferHeight);
+            currentState = GameState::PLAYING;
+            initGame();
+        }
+
+        // --- Post-processing ---
+        if (!options.postChain.empty() && options.vulkan) {
+            std::cerr << "Post-processing requires the OpenGL renderer" << std::endl;
+        } else if (!options.postChain.empty() && options.backend != RenderBackendType::GL &&
+                   options.backend != RenderBackendType::GL2) {
+            std::cerr << "Post-processing requires an OpenGL backend (--backend=gl or gl2)" << std::endl;
+        } else if (!options.postChain.empty()) {
+            if ((framebufferFunctions.genFramebuffers || framebufferFunctions.load()) &&
+                postProcessor.init(framebufferFunctions, options.postChain, options.postBudgetMs)) {
+                std::cout << "Post-processing: " << options.postChain << ", budget " << options.postBudgetMs << " ms"
+                        << (postProcessor.hasTimers() ? "" : " (no GPU timer, budget not enforced)") << std::endl;
+            } else {
+                std::cerr << "Post-processing unavailable" << std::endl;
+            }
+        }
+
+        if (isGridMode()) {
+            initGrid();
+        } else if (isVersusMode()) {
+            initVersus();
+        }
+
+        if (!options.broadcastPath.empty()) {
+#if defined(__APPLE__)
+            signal(SIGPIPE, SIG_IGN); // Spectateur déconnecté : erreur EPIPE plutôt que SIGPIPE
+#endif
+            broadcaster.reset(new SpectatorBroadcaster(options.broadcastPath));
+        }
+        if (!options.spectatePath.empty()) {
+            spectatorClient.reset(new SpectatorClient(SpectatorClient::connectTo(options.spectatePath)));
+            currentState = GameState::PLAYING;
+        } else if (!isGridMode() && !isVersusMode() && !options.scoresPath.empty()) {
+            highScores.reset(new HighScoreStore(options.scoresPath)); // Chargé en arrière-plan
+        }
+        if (!options.eventsPath.empty() && !isGridMode() && !isVersusMode() && !spectatorClient) {
+#if defined(__APPLE__)
+            signal(SIGPIPE, SIG_IGN); // Consommateur parti : erreur EPIPE plutôt que SIGPIPE
+#endif
+            eventStream.reset(new GameEventStream(options.eventsPath, options.eventFormat));
+        }
     }
 
     ~Game() {
+        if (eventStream) {
+            eventStream->finish();
+            eventStream->printSummary(std::cout);
+        }
+        if (options.vulkan) {
+#ifdef BREAKOUT_VULKAN
+            // Le périphérique et la surface doivent disparaître avant la fenêtre
+            vulkanRenderer->waitIdle();
+            ImGui_ImplVulkan_Shutdown();
+            vulkanRenderer.reset();
+#endif
+        } else {
+            levelEditor.releaseGL();
+            postProcessor.release();
+            hudFont.release();
+            if (offscreenTarget.framebuffer) {
+                offscreenTarget.destroy(framebufferFunctions);
+            }
+            ImGui_ImplOpenGL2_Shutdown();
+        }
+
         // --- ImGui ---
-        ImGui_ImplOpenGL2_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
@@ -238,16 +9091,41 @@ public:
     // Boucle principale
     void run() {
         lastTime = glfwGetTime();
+        int frameCount = 0;
         while (!glfwWindowShouldClose(window)) {
+            if (options.frameLimit > 0 && frameCount++ >= options.frameLimit) {
+                break;
+            }
+
             // --- Timing ---
             double currentTime = glfwGetTime();
             auto deltaTime = static_cast<float>(currentTime - lastTime);
             lastTime = currentTime;
+            frameHistogram.record(deltaTime);
+            if (options.offscreen) {
+                deltaTime = OFFSCREEN_TIME_STEP; // Pas fixe : frames reproductibles pour les comparaisons d'images
+            } else {
+                deltaTime = snapToRefresh(deltaTime);
+            }
 
-            // --- ImGui Frame ---
-            ImGui_ImplOpenGL2_NewFrame();
-            ImGui_ImplGlfw_NewFrame();
-            ImGui::NewFrame();
+            // --- ImGui Frame (seulement si un menu ou une fenêtre ImGui est affiché) ---
+            const auto uiStart = std::chrono::steady_clock::now();
+            imguiFrameActive = needsImGui();
+            if (imguiFrameActive) {
+                if (imguiSkipped) {
+                    // Relâchements perdus pendant la partie : repartir de touches et boutons relâchés
+                    ImGui::GetIO().ClearInputKeys();
+                    ImGui::GetIO().ClearInputMouse();
+                    imguiSkipped = false;
+                }
+                newRendererFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+            } else {
+                ImGui::GetIO().ClearEventsQueue(); // Personne ne les lira
+                imguiSkipped = true;
+            }
+            uiTime.record(std::chrono::steady_clock::now() - uiStart);
 
             // --- Input & Update ---
             processInput(deltaTime); // Handle keyboard input for game
@@ -259,6 +9137,23 @@ public:
             // --- Event Handling ---
             glfwPollEvents(); // Process window events
         }
+        frameHistogram.printReport(std::cout, options.lowJitter ? "low-jitter on" : "low-jitter off");
+        std::cout << "UI cost per frame: " << uiTime.meanMicros(false) << " us without ImGui (" << uiTime.frames[0]
+                << " frames), " << uiTime.meanMicros(true) << " us with ImGui (" << uiTime.frames[1] << " frames)"
+                << std::endl;
+        saveRecording();
+        if (versusSession) {
+            std::cout << "Versus: " << versusSession->frame << " frames, " << versusSession->rollbacks
+                    << " rollbacks (" << versusSession->resimulatedFrames << " frames resimulated, max "
+                    << versusSession->maxRollbackFrames << " frames in " << versusSession->maxRollbackMicros
+                    << " us), " << versusSession->stalls << " stalls" << std::endl;
+        }
+
+        if (options.offscreen && !options.dumpPath.empty()) {
+            if (!offscreenTarget.writePPM(framebufferFunctions, options.dumpPath)) {
+                std::cerr << "Failed to write " << options.dumpPath << std::endl;
+            }
+        }
     }
 
 private:
@@ -272,40 +9167,251 @@ private:
     // --- State ---
     GameState currentState = GameState::MENU;
 
-    // --- Game Objects ---
-    Paddle playerPaddle;
-    Ball gameBall;
-    std::vector<Block> blocks;
-    int score = 0;
-    int lives = 3;
-    int currentLevel = 1;
+    // --- Game World ---
+    GameWorld world;
+    std::shared_ptr<const LevelData> selectedLevel; // Niveau joué (nullptr = niveau d'origine)
+    LevelEditor levelEditor;
+
+    // --- Grid View (--grid=N) ---
+    std::vector<GameWorld> gridWorlds;
+    std::vector<Autopilot> gridPilots;
+
+    // --- Vulkan (--renderer=vulkan) ---
+#ifdef BREAKOUT_VULKAN
+    std::unique_ptr<VulkanRenderer> vulkanRenderer;
+#endif
+
+    // --- Draw Commands ---
+    DrawCommandBuffer frameCommands; // Enregistré à chaque frame, exécuté par renderBackend (ou Vulkan)
+    std::unique_ptr<RenderBackend> renderBackend; // nullptr avec le rendu Vulkan
+    RenderStats renderStats; // Compteurs de la dernière frame
+
+    // --- Versus (--versus=...) ---
+    std::unique_ptr<VersusSession> versusSession;
+    std::unique_ptr<VersusSession> loopbackOpponent; // Adversaire autopiloté (--versus=loopback)
+    Autopilot loopbackPilot;
+    PlayerInput versusInput;
+    float versusAccumulator = 0.0f;
+
+    // --- Spectators (--broadcast / --spectate) ---
+    std::unique_ptr<SpectatorBroadcaster> broadcaster;
+    std::unique_ptr<SpectatorClient> spectatorClient;
+
+    // --- Gameplay events (--events) ---
+    std::unique_ptr<GameEventStream> eventStream;
 
-    //--- Bonus Objects ---
-    std::vector<FallingBonus> fallingBonuses;
-    float bonusFallSpeed = 1.0f; // Vitesse pour tomber en 2 secondes
     // --- Timing ---
     double lastTime = 0.0;
 
+    // --- Display ---
+    DisplayMode displayMode = DisplayMode::WINDOWED;
+    int displayMonitor = 0;
+    int refreshRate = 60; // Hz du moniteur affichant la fenêtre
+    int windowedX = 100, windowedY = 100, windowedWidth = 960, windowedHeight = 540;
+
+    // --- Offscreen Rendering ---
+    FramebufferFunctions framebufferFunctions;
+    OffscreenTarget offscreenTarget;
+    PostProcessor postProcessor;
+    SdfFont hudFont;
+    std::vector<DrawQuad> hudQuads; // Quads du HUD, conservés tant que hudKey ne change pas
+
+    // Tout ce qui change le texte du HUD
+    struct HudKey {
+        int score;
+        int level;
+        int lives;
+        bool gameOver;
+        bool rankKnown;
+        int width;
+        int height;
+
+        bool operator==(const HudKey& o) const {
+            return score == o.score && level == o.level && lives == o.lives && gameOver == o.gameOver &&
+                   rankKnown == o.rankKnown && width == o.width && height == o.height;
+        }
+    };
+
+    HudKey hudKey = {};
+    bool imguiFrameActive = false; // NewFrame appelé pour la frame en cours
+    bool imguiSkipped = false;
+
+    // Coût CPU de l'interface (HUD + ImGui) par frame, selon le chemin emprunté
+    struct UiTiming {
+        double seconds[2] = {}; // [0] HUD rapide sans ImGui, [1] frame ImGui
+        long long frames[2] = {};
+        double current = 0.0;
+
+        void record(std::chrono::steady_clock::duration elapsed) {
+            current += std::chrono::duration<double>(elapsed).count();
+        }
+
+        void endFrame(bool imgui) {
+            seconds[imgui] += current;
+            frames[imgui] += 1;
+            current = 0.0;
+        }
+
+        double meanMicros(bool imgui) const { return frames[imgui] ? seconds[imgui] / frames[imgui] * 1e6 : 0.0; }
+    };
+
+    UiTiming uiTime;
+
+    // --- Runtime Options & Diagnostics ---
+    RuntimeOptions options;
+    FrameHistogram frameHistogram;
+    std::vector<std::string> lowJitterReport;
+    bool showDebugWindow = false;
+    bool keyWasDown[GLFW_KEY_LAST + 1] = {};
+    Replay replayRecording;
+    PlayerInput recordedInput;
+    bool recordingReplay = false;
+    RewindBuffer rewind; // Dernières secondes de la partie (fenêtre de debug, F2)
+    bool rewinding = false; // Partie figée sur le tick rewindCursor de l'historique
+    int rewindCursor = 0;
+    uint64_t replayStartTick = 0; // Tick de l'historique au début du replay enregistré
+    std::unique_ptr<HighScoreStore> highScores;
+    HighScoreRank gameOverRank;
+    bool gameOverRankKnown = false;
+
     // --- Initialization Functions ---
     bool initGLFW(const int &width, const int &height, const char *title) {
+#ifdef GLFW_PLATFORM_NULL
+        // GLFW >= 3.4 : plateforme "null", aucun serveur X/Wayland nécessaire
+        if (options.offscreen) {
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        }
+#endif
         if (!glfwInit()) {
             std::cerr << "Failed to initialize GLFW" << std::endl;
             return false;
         }
-        // Request OpenGL 2.1 context (compatible with ImGui OpenGL2 backend)
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        if (options.vulkan) {
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // Surface Vulkan, pas de contexte OpenGL
+        } else {
+            // Request OpenGL 2.1 context (compatible with ImGui OpenGL2 backend)
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        }
+
+        if (options.offscreen) {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+            // Contexte logiciel OSMesa (Mesa llvmpipe/softpipe)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+        }
+
+        window = glfwCreateWindow(width, height, title, NULL, NULL);
+#ifdef GLFW_PLATFORM_NULL
+        if (!window && options.offscreen) {
+            // OSMesa absent : tenter un contexte EGL surfaceless
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+            window = glfwCreateWindow(width, height, title, NULL, NULL);
+        }
+#endif
+        updateProjectionMatrix(width, height);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return false;
+        }
+        if (!options.vulkan) {
+            glfwMakeContextCurrent(window);
+            glfwSwapInterval(options.offscreen ? 0 : 1); // Enable V-Sync (inutile hors écran)
+        }
+        return true;
+    }
+
+    // --- Display Modes ---
+    // Le contexte OpenGL survit à glfwSetWindowMonitor : changer de mode ne touche ni aux
+    // textures ni à la partie, seuls le viewport et les limites du monde sont recalculés
+    // (callback de taille du framebuffer).
+    static GLFWmonitor *monitorAt(int index) {
+        int count = 0;
+        GLFWmonitor **monitors = glfwGetMonitors(&count);
+        if (!monitors || count == 0) return nullptr;
+        return monitors[index >= 0 && index < count ? index : 0];
+    }
+
+    // Moniteur qui contient le centre de la fenêtre
+    GLFWmonitor *monitorUnderWindow() const {
+        int x, y, w, h, count = 0;
+        glfwGetWindowPos(window, &x, &y);
+        glfwGetWindowSize(window, &w, &h);
+        GLFWmonitor **monitors = glfwGetMonitors(&count);
+        for (int i = 0; i < count; ++i) {
+            const GLFWvidmode *mode = glfwGetVideoMode(monitors[i]);
+            int mx, my;
+            glfwGetMonitorPos(monitors[i], &mx, &my);
+            if (mode && x + w / 2 >= mx && x + w / 2 < mx + mode->width && y + h / 2 >= my &&
+                y + h / 2 < my + mode->height) {
+                return monitors[i];
+            }
+        }
+        return glfwGetPrimaryMonitor();
+    }
+
+    void updateRefreshRate(GLFWmonitor *monitor) {
+        const GLFWvidmode *mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+        refreshRate = mode && mode->refreshRate > 0 ? mode->refreshRate : 60;
+    }
+
+    void setDisplayMode(DisplayMode mode, int index) {
+        GLFWmonitor *monitor = monitorAt(index);
+        if (mode != DisplayMode::WINDOWED && !monitor) {
+            std::cerr << "No monitor available, staying windowed" << std::endl;
+            mode = DisplayMode::WINDOWED;
+        }
+        if (displayMode == DisplayMode::WINDOWED && mode != DisplayMode::WINDOWED) {
+            glfwGetWindowPos(window, &windowedX, &windowedY); // Restauré au retour en fenêtre
+            glfwGetWindowSize(window, &windowedWidth, &windowedHeight);
+        }
+
+        if (mode == DisplayMode::WINDOWED) {
+            if (displayMode != DisplayMode::WINDOWED) {
+                glfwSetWindowMonitor(window, nullptr, windowedX, windowedY, windowedWidth, windowedHeight,
+                                     GLFW_DONT_CARE);
+            }
+            monitor = monitorUnderWindow();
+        } else {
+            const GLFWvidmode *desktop = glfwGetVideoMode(monitor);
+            GLFWvidmode target = *desktop;
+            if (mode == DisplayMode::FULLSCREEN) {
+                // Exclusif : résolution native au taux de rafraîchissement le plus élevé
+                int count = 0;
+                const GLFWvidmode *modes = glfwGetVideoModes(monitor, &count);
+                for (int i = 0; i < count; ++i) {
+                    if (modes[i].width == desktop->width && modes[i].height == desktop->height &&
+                        modes[i].refreshRate > target.refreshRate) {
+                        target = modes[i];
+                    }
+                }
+            }
+            // Sans bordure : même mode que le bureau, GLFW ne change pas de mode vidéo
+            glfwSetWindowMonitor(window, monitor, 0, 0, target.width, target.height, target.refreshRate);
+        }
+        displayMode = mode;
+        displayMonitor = index;
+        if (!options.vulkan) {
+            glfwSwapInterval(1); // Certains pilotes oublient l'intervalle au changement de mode
+        }
+        updateRefreshRate(monitor);
+        const char *name = monitor ? glfwGetMonitorName(monitor) : nullptr;
+        std::cout << "Display: " << displayModeName(mode) << " on " << (name ? name : "unknown monitor") << " at "
+                << refreshRate << " Hz" << std::endl;
+    }
 
-        window = glfwCreateWindow(width, height, title, NULL, NULL);
-        updateProjectionMatrix(width, height);
-        if (!window) {
-            std::cerr << "Failed to create GLFW window" << std::endl;
-            glfwTerminate();
-            return false;
+    // V-Sync : la durée mesurée d'une frame est un multiple de la période de rafraîchissement
+    // plus le bruit de l'ordonnanceur. On simule exactement ce multiple (mouvement régulier),
+    // sauf si l'écart est trop grand pour venir de la synchronisation (frame vraiment lente).
+    float snapToRefresh(float dt) const {
+        const float period = 1.0f / static_cast<float>(refreshRate);
+        const float frames = std::round(dt / period);
+        if (frames >= 1.0f && std::fabs(dt - frames * period) < REFRESH_SNAP_TOLERANCE * period) {
+            return frames * period;
         }
-        glfwMakeContextCurrent(window);
-        glfwSwapInterval(1); // Enable V-Sync
-        return true;
+        return dt;
     }
 
     // Setup GLFW callbacks NOT handled by ImGui
@@ -315,244 +9421,71 @@ private:
 
         glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
         glfwSetWindowSizeCallback(window, windowSizeCallback);
+        glfwSetWindowPosCallback(window, windowPosCallback);
         // glfwSetKeyCallback(window, keyCallback); // Can be removed if only polling keys
     }
 
-    void initGame() {
-        score = 0;
-        lives = 3;
-        currentLevel = 1;
-        // currentState is set to PLAYING *before* calling this
-        initBlocks();
-        resetPlayerAndBall();
-    }
-
-    void spawnBonus(const Block &block) {
-        FallingBonus bonus;
-        bonus.position = block.position;
-        bonus.size = Vec2{gameBall.size.x, gameBall.size.y}; // Plus petit que la brique
-        bonus.type = block.bonusType;
-        bonus.fallSpeed = bonusFallSpeed;
-        bonus.active = true;
-
-        switch (bonus.type) {
-            case LIFE_ADD: bonus.color = Color{1.0f, 0.5f, 0.0f, 1.0f};
-                break; // Orange
-            case LIFE_REMOVE: bonus.color = Color{1.0f, 0.0f, 0.0f, 1.0f};
-                break; // Rouge
-            case PADDLE_WIDEN: bonus.color = Color{1.0f, 1.0f, 0.0f, 1.0f};
-                break; // Jaune
-            case PADDLE_SHRINK: bonus.color = Color{0.0f, 1.0f, 0.0f, 1.0f};
-                break; // Vert
-            case BALL_SLOW: bonus.color = Color{0.0f, 1.0f, 1.0f, 1.0f};
-                break; // Cyan
-            case BALL_FAST: bonus.color = Color{0.0f, 0.0f, 1.0f, 1.0f};
-                break; // Bleu
-            case BALL_STRAIGHTEN: bonus.color = Color{1.0f, 1.0f, 1.0f, 1.0f};
-                break; // Blanc
-            case BALL_ANGLE: bonus.color = Color{0.5f, 0.5f, 0.5f, 1.0f};
-                break; // Gris
-            default: bonus.color = Color{1.0f, 1.0f, 1.0f, 1.0f}; // Blanc par défaut
+    // Alloue à l'avance tout ce que la boucle de jeu peut demander (briques, bonus,
+    // texture de police ImGui) pour qu'aucune allocation ni défaut de page n'arrive en jeu.
+    void prewarmPools() {
+        world.blocks.reserve(BRICK_ROWS * BRICKS_PER_ROW);
+        world.fallingBonuses.reserve(BRICK_ROWS * BRICKS_PER_ROW);
+        if (!options.vulkan) {
+            ImGui_ImplOpenGL2_CreateDeviceObjects();
         }
-
-        fallingBonuses.push_back(bonus);
     }
 
-    void applyBonus(const FallingBonus &bonus) {
-        switch (bonus.type) {
-            case LIFE_ADD:
-                lives = std::min(lives + 1, 5); // Maximum 5 vies
-                break;
-            case LIFE_REMOVE:
-                lives = std::max(lives - 1, 1); // Minimum 1 vie
-                break;
-            case PADDLE_WIDEN:
-                playerPaddle.size.x *= 1.25f; // 25% plus large
-                playerPaddle.size.x = std::min(playerPaddle.size.x, gameBoundX * 0.75f); // Limiter la taille
-                break;
-            case PADDLE_SHRINK:
-                playerPaddle.size.x *= 0.75f; // 25% plus petit
-                playerPaddle.size.x = std::max(playerPaddle.size.x, PADDLE_WIDTH * 0.5f); // Taille minimale
-                break;
-            case BALL_SLOW:
-                gameBall.speedMagnitude *= 0.8f; // 20% plus lente
-                normalizeVelocity();
-                break;
-            case BALL_FAST:
-                gameBall.speedMagnitude *= 1.2f; // 20% plus rapide
-                normalizeVelocity();
-                break;
-            case BALL_STRAIGHTEN:
-                // Redresser la trajectoire
-                if (std::abs(gameBall.velocity.x) > 0.1f) {
-                    float sign = gameBall.velocity.x > 0 ? 1.0f : -1.0f;
-                    gameBall.velocity.x = sign * gameBall.speedMagnitude * 0.2f; // Réduit la composante horizontale
-                    gameBall.velocity.y = gameBall.velocity.y > 0
-                                              ? std::sqrt(
-                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
-                                                  x *
-                                                  gameBall.velocity.x)
-                                              : -std::sqrt(
-                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
-                                                  x *
-                                                  gameBall.velocity.x);
-                }
-                break;
-            case BALL_ANGLE:
-                // Incliner davantage la trajectoire
-                if (std::abs(gameBall.velocity.y) > 0.1f) {
-                    float sign = gameBall.velocity.x > 0 ? 1.0f : -1.0f;
-                    gameBall.velocity.x = sign * gameBall.speedMagnitude * 0.8f;
-                    // Augmente la composante horizontale (80% de la vitesse normalisée est horizontale
-                    gameBall.velocity.y = gameBall.velocity.y > 0
-                                              ? std::sqrt(
-                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
-                                                  x *
-                                                  gameBall.velocity.x)
-                                              : -std::sqrt(
-                                                  gameBall.speedMagnitude * gameBall.speedMagnitude - gameBall.velocity.
-                                                  x *
-                                                  gameBall.velocity.x);
-                }
-                break;
-            default: break;
+    void newRendererFrame() {
+#ifdef BREAKOUT_VULKAN
+        if (vulkanRenderer) {
+            ImGui_ImplVulkan_NewFrame();
+            return;
         }
+#endif
+        ImGui_ImplOpenGL2_NewFrame();
     }
 
-    void initBlocks() {
-        blocks.clear();
-        float totalGridWidth = 2 * gameBoundX;
-        float totalGapWidth = (BRICKS_PER_ROW - 1) * BRICK_GAP;
-        float brickWidth = (totalGridWidth - totalGapWidth) / BRICKS_PER_ROW;
-        float startX = -gameBoundX;
-
-        // Positions fixes pour les briques bonus et compteur dans chaque rangée
-        std::srand(42); // Seed fixe pour la reproductibilité
-        int bonusPositions[BRICK_ROWS];
-        int counterPositions[BRICK_ROWS];
-
-        for (int i = 0; i < BRICK_ROWS; i++) {
-            bonusPositions[i] = 1 + std::rand() % (BRICKS_PER_ROW - 2);
-            do {
-                counterPositions[i] = 1 + std::rand() % (BRICKS_PER_ROW - 2);
-            } while (counterPositions[i] == bonusPositions[i]);
-        }
-
-        for (int i = 0; i < BRICK_ROWS; ++i) {
-            // Définir la couleur et les points une seule fois par ligne
-            // Pour obtenir la couleur de base selon la ligne
-            BrickColor baseColorType;
-            int points;
-            if (i < 2) {
-                baseColorType = BrickColor::RED;
-                points = 7;
-            } else if (i < 4) {
-                baseColorType = BrickColor::ORANGE;
-                points = 5;
-            } else if (i < 6) {
-                baseColorType = BrickColor::GREEN;
-                points = 3;
-            } else {
-                baseColorType = BrickColor::YELLOW;
-                points = 1;
-            }
-
-            for (int j = 0; j < BRICKS_PER_ROW; ++j) {
-                Block block;
-                block.size = Vec2{brickWidth, BRICK_HEIGHT};
-                block.position = Vec2{
-                    startX + j * (brickWidth + BRICK_GAP),
-                    BRICK_START_Y - i * (BRICK_HEIGHT + BRICK_GAP)
-                };
-                block.active = true;
-                block.hitCounter = 1;
-                block.points = points;
-                // Par défaut, utiliser la couleur de base de la ligne
-                block.color = getColorFromEnum(baseColorType);
-                block.colorType = baseColorType;
-                // Cas spéciaux par type de brique
-                if (i == 0 && (j == 0 || j == BRICKS_PER_ROW - 1)) {
-                    // Murs indestructibles
-                    block.isWall = true;
-                    block.isReflective = false;
-                    block.color = getColorFromEnum(BrickColor::GRAY);
-                    block.colorType = BrickColor::GRAY;
-                    block.hitCounter = -1;
-                } else if (i == 0 && (j == 1 || j == BRICKS_PER_ROW - 2)) {
-                    // Murs réfléchissants
-                    block.isWall = true;
-                    block.isReflective = true;
-                    block.color = getColorFromEnum(BrickColor::WHITE);
-                    block.colorType = BrickColor::WHITE;
-                    block.hitCounter = -1;
-                } else if (j == counterPositions[i]) {
-                    // Briques à compteur - version plus sombre de la couleur de base
-                    block.hitCounter = 2;
-                    block.color = getColorFromEnum(baseColorType, true);
-                } else if (j == bonusPositions[i]) {
-                    // Briques bonus
-                    block.isBonus = true;
-                    block.bonusType = rand() % 7;
-                }
-                blocks.push_back(block);
-            }
-        }
-        // Réinitialisation du générateur aléatoire pour le reste du jeu
-        std::srand(static_cast<unsigned int>(std::time(nullptr)));
+    // Vrai uniquement à la frame où la touche passe de relâchée à enfoncée
+    bool keyPressedOnce(int key) {
+        const bool down = glfwGetKey(window, key) == GLFW_PRESS;
+        const bool pressed = down && !keyWasDown[key];
+        keyWasDown[key] = down;
+        return pressed;
     }
 
-    void updateBlockPositions() {
-        // Calculer la nouvelle taille des briques basée sur les limites du jeu actuelles
-        float totalGridWidth = 2 * gameBoundX;
-        float totalGapWidth = (BRICKS_PER_ROW - 1) * BRICK_GAP;
-        float brickWidth = (totalGridWidth - totalGapWidth) / BRICKS_PER_ROW;
-        float startX = -gameBoundX;
-
-        // Parcourir toutes les briques existantes et ajuster leurs positions et tailles
-        int i = 0;
-        for (int row = 0; row < BRICK_ROWS; ++row) {
-            for (int col = 0; col < BRICKS_PER_ROW; ++col) {
-                if (i < blocks.size()) {
-                    // Conserver l'état actif/inactif et autres propriétés
-                    Block &block = blocks[i];
-
-                    // Mettre à jour uniquement la position et la taille
-                    block.size.x = brickWidth;
-                    block.size.y = BRICK_HEIGHT;
-                    block.position.x = startX + col * (brickWidth + BRICK_GAP);
-                    block.position.y = BRICK_START_Y - row * (BRICK_HEIGHT + BRICK_GAP);
-
-                    i++;
-                }
-            }
-        }
+    // --- Save / Load ---
+    void saveState(std::vector<uint8_t> &out) const {
+        world.saveState(out);
     }
 
-    bool checkBonusPaddleCollision(const FallingBonus &bonus) const {
-        return bonus.position.x < playerPaddle.position.x + playerPaddle.size.x &&
-               bonus.position.x + bonus.size.x > playerPaddle.position.x &&
-               bonus.position.y < playerPaddle.position.y + playerPaddle.size.y &&
-               bonus.position.y + bonus.size.y > playerPaddle.position.y;
+    void loadState(const uint8_t *data, size_t size) {
+        world.loadState(data, size);
+        currentState = GameState::PLAYING;
+        saveRecording(); // La suite ne découle plus de l'état initial enregistré
     }
 
-    // Reset paddle and ball to starting positions
-    void resetPlayerAndBall() {
-        playerPaddle.isShrunk
-            ? playerPaddle.size = Vec2{PADDLE_WIDTH * 0.5, PADDLE_HEIGHT}
-            : playerPaddle.size = Vec2{PADDLE_WIDTH, PADDLE_HEIGHT};
-        playerPaddle.position = Vec2{0.0f - PADDLE_WIDTH / 2.0f, PADDLE_Y_POSITION};
-        playerPaddle.color = Color{0.8f, 0.8f, 0.8f, 1.0f};
+    void saveStateToFile(const char *path) const {
+        std::vector<uint8_t> buffer;
+        saveState(buffer);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if (!file) {
+            std::cerr << "Failed to write save file " << path << std::endl;
+        }
+    }
 
-        gameBall.size = Vec2{BALL_RADIUS * 2.0f, BALL_RADIUS * 2.0f};
-        gameBall.position = Vec2{
-            playerPaddle.position.x + playerPaddle.size.x / 2.0f - BALL_RADIUS,
-            playerPaddle.position.y + playerPaddle.size.y
-        };
-        gameBall.color = Color{1.0f, 1.0f, 1.0f, 1.0f};
-        gameBall.velocity = Vec2{0.0f, 0.0f};
-        gameBall.speedMagnitude = INITIAL_BALL_SPEED;
-        gameBall.stuckToPaddle = true;
-        gameBall.hitCount = 0; // Reset hits
+    void loadStateFromFile(const char *path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "No save file " << path << std::endl;
+            return;
+        }
+        const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        try {
+            loadState(buffer.data(), buffer.size());
+        } catch (const std::exception &e) {
+            std::cerr << "Failed to load " << path << ": " << e.what() << std::endl;
+        }
     }
 
     // --- Game Loop Functions ---
@@ -561,38 +9494,56 @@ private:
             double mouseX, mouseY;
             glfwGetCursorPos(window, &mouseX, &mouseY);
             // Convertir les coordonnées de souris en coordonnées de monde OpenGL
-            double worldMouseX = (2.0f * mouseX / windowWidth - 1.0f) * gameBoundX;
-            float moveSpeed = PADDLE_SPEED*gameBall.speedMagnitude; // Vitesse de déplacement de la raquette
-            float targetX = worldMouseX - playerPaddle.size.x / 2.0f;
-            float currentX = playerPaddle.position.x;
-            float direction = (targetX > currentX) ? 1.0f : -1.0f;
-            float distance = std::abs(targetX - currentX);
-
-            // Déplacement progressif
-            if (distance > 0.001f) {
-                float movement = moveSpeed * dt;
-                movement = std::min(movement, distance);
-                playerPaddle.position.x = std::max(-gameBoundX,std::min(gameBoundX-playerPaddle.size.x,playerPaddle.position.x+direction * movement));
-            }
-            // Launch Ball
-            if (gameBall.stuckToPaddle && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-                gameBall.stuckToPaddle = false;
-                const float ballDirection = rand() % 2 * 2 - 1;
-                const float velocityX = ballDirection * gameBall.speedMagnitude;
-                const float velocityY = gameBall.speedMagnitude;
-
-                gameBall.velocity = Vec2{velocityX, velocityY};
-                normalizeVelocity();
+            PlayerInput input;
+            input.pointerX = static_cast<float>((2.0f * mouseX / windowWidth - 1.0f) * gameBoundX);
+            input.launch = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            if (isVersusMode()) {
+                // Coordonnées du plateau local (moitié gauche ou droite de la fenêtre)
+                const WorldTransform transform = boardTransform(versusSession->localPlayerIndex(), 2);
+                input.pointerX = (input.pointerX - transform.offsetX) / transform.scale;
+                versusInput = input;
+            } else if (!isGridMode() && !spectatorClient && !rewinding) {
+                world.applyInput(input, dt);
+                recordedInput = input;
             }
         }
         // --- Game Over Input ---
-        else if (currentState == GameState::GAME_OVER) {
+        else if (currentState == GameState::GAME_OVER && !rewinding) {
             if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
                 currentState = GameState::MENU; // Return to menu
             }
         }
 
         // --- Global Input ---
+        // F1 : fenêtre de debug (histogramme des frames)
+        if (keyPressedOnce(GLFW_KEY_F1)) {
+            showDebugWindow = !showDebugWindow;
+        }
+        // F11 : fenêtre -> sans bordure -> plein écran exclusif
+        if (keyPressedOnce(GLFW_KEY_F11) && !options.offscreen) {
+            setDisplayMode(static_cast<DisplayMode>((static_cast<int>(displayMode) + 1) % 3), displayMonitor);
+        }
+        // F5 / F9 : sauvegarde et chargement rapides
+        if (keyPressedOnce(GLFW_KEY_F5) && currentState == GameState::PLAYING) {
+            saveStateToFile(QUICKSAVE_PATH);
+        }
+        if (keyPressedOnce(GLFW_KEY_F9) && !rewinding) {
+            loadStateFromFile(QUICKSAVE_PATH);
+        }
+        // F2 : figer la partie pour la rembobiner, puis reprendre ; flèches : tick par tick
+        if (keyPressedOnce(GLFW_KEY_F2)) {
+            if (rewinding) {
+                resumeFromRewind();
+            } else if (canRewind()) {
+                startRewind();
+                showDebugWindow = true;
+            }
+        }
+        if (rewinding) {
+            if (keyPressedOnce(GLFW_KEY_LEFT)) seekRewind(rewindCursor - 1);
+            if (keyPressedOnce(GLFW_KEY_RIGHT)) seekRewind(rewindCursor + 1);
+        }
+
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
             glfwSetWindowShouldClose(window, true);
         }
@@ -600,122 +9551,278 @@ private:
 
     void update(const float dt) {
         // Only update game logic if playing
-        if (currentState == GameState::PLAYING) {
-            // --- Update Ball Position ---
-            if (gameBall.stuckToPaddle) {
-                gameBall.position = Vec2{
-                    playerPaddle.position.x + playerPaddle.size.x / 2.0f - BALL_RADIUS,
-                    playerPaddle.position.y + playerPaddle.size.y
-                };
-            } else {
-                gameBall.position.x += gameBall.velocity.x * dt;
-                gameBall.position.y += gameBall.velocity.y * dt;
-
-                // --- Handle Collisions ---
-                handleCollisions();
-
-                // --- Check Lose Condition ---
-                if (gameBall.position.y + gameBall.size.y < -gameBoundY) {
-                    // Ball below bottom edge
-                    lives--;
-                    if (lives <= 0) {
-                        currentState = GameState::GAME_OVER;
-                    } else {
-                        resetPlayerAndBall(); // Reset ball/paddle for next life
-                    }
+        if (currentState == GameState::PLAYING && !rewinding) {
+            if (isGridMode()) {
+                updateGrid(dt);
+                return;
+            }
+            if (isVersusMode()) {
+                updateVersus(dt);
+                return;
+            }
+            if (spectatorClient) {
+                if (!spectatorClient->poll(world)) {
+                    std::cout << "Broadcast ended" << std::endl;
+                    glfwSetWindowShouldClose(window, true);
+                }
+                return;
+            }
+            world.update(dt);
+            if (recordingReplay) {
+                replayRecording.record(recordedInput, dt, world);
+            }
+            rewind.record(world, dt);
+            if (eventStream) {
+                eventStream->publish(world.events);
+                world.events.clear();
+            }
+            if (world.gameOver) {
+                currentState = GameState::GAME_OVER;
+                saveRecording();
+                if (highScores) {
+                    highScores->submit(static_cast<uint32_t>(std::max(0, world.score)),
+                                       static_cast<uint32_t>(world.currentLevel));
+                    gameOverRankKnown = false;
                 }
             }
+            if (broadcaster) {
+                broadcaster->publish(world);
+            }
+        }
+        if (broadcaster) {
+            broadcaster->acceptClients();
+            broadcaster->flush();
+        }
+    }
 
-            // Mettre à jour les bonus qui tombent
-            for (auto &bonus: fallingBonuses) {
-                if (bonus.active) {
-                    // Faire descendre le bonus
-                    bonus.position.y -= bonus.fallSpeed * dt;
+    void initGame() {
+        world.level = selectedLevel;
+        world.initGame();
+        world.trackBrickChanges = rewind.enabled();
+        world.recordEvents = eventStream != nullptr;
+        world.events.clear();
+        const uint64_t startTick = rewind.nextTick();
+        rewind.record(world, 0.0f);
+        if (!options.recordPath.empty()) {
+            replayRecording.begin(world);
+            replayStartTick = startTick;
+            recordingReplay = true;
+        }
+    }
 
-                    // Vérifier si le bonus a atteint le bas de l'écran
-                    if (bonus.position.y < -gameBoundY) {
-                        bonus.active = false;
-                        continue;
-                    }
+    // --- Rewind ---
+    bool canRewind() const {
+        return rewind.size() > 0 && !isGridMode() && !isVersusMode() && !spectatorClient &&
+               (currentState == GameState::PLAYING || currentState == GameState::GAME_OVER);
+    }
 
-                    // Vérifier la collision avec la raquette
-                    if (checkBonusPaddleCollision(bonus)) {
-                        applyBonus(bonus);
-                        bonus.active = false;
-                    }
-                }
-            }
+    void startRewind() {
+        rewinding = true;
+        rewindCursor = rewind.size() - 1; // Le monde est déjà dans l'état du dernier tick
+    }
 
-            // Nettoyage des bonus inactifs
-            fallingBonuses.erase(
-                std::remove_if(fallingBonuses.begin(), fallingBonuses.end(),
-                               [](const FallingBonus &b) { return !b.active; }),
-                fallingBonuses.end()
-            );
+    void seekRewind(int index) {
+        const int clamped = std::max(0, std::min(index, rewind.size() - 1));
+        if (clamped == rewindCursor) return;
+        rewindCursor = clamped;
+        rewind.restore(rewindCursor, world);
+        currentState = world.gameOver ? GameState::GAME_OVER : GameState::PLAYING;
+    }
 
-            // --- Check Win Condition ---
-            bool allBlocksInactive = true;
-            for (const auto &block: blocks) {
-                if (block.active && !block.isWall) {
-                    allBlocksInactive = false;
-                    break;
-                }
-            }
-            if (allBlocksInactive) {
-                if (lives > 0) // S'il reste des vies, passer au niveau suivant
-                {
-                    currentLevel++;
-                    playerPaddle.firstContactOrange = true;
-                    playerPaddle.firstContactRed = true;
-                    gameBall.hitCount = 0;
-                    initBlocks(); // Générer un nouveau niveau de briques
-                    resetPlayerAndBall(); // Réinitialiser la position de la balle et de la raquette
-                    // La score est préservé car nous ne le réinitialisons pas
-                } else {
-                    currentState = GameState::GAME_OVER;
-                }
+    // Les ticks suivants sont oubliés ; le replay en cours reste valide s'il couvre ce tick
+    void resumeFromRewind() {
+        const uint64_t tick = rewind.tickAt(rewindCursor);
+        rewind.truncate(rewindCursor);
+        if (recordingReplay) {
+            if (tick >= replayStartTick && tick - replayStartTick <= replayRecording.ticks.size()) {
+                replayRecording.ticks.resize(static_cast<size_t>(tick - replayStartTick));
+            } else {
+                saveRecording();
             }
         }
+        rewinding = false;
+        currentState = world.gameOver ? GameState::GAME_OVER : GameState::PLAYING;
     }
 
-    // --- Rendering Functions ---
+    // --- Replay Recording ---
+    void saveRecording() {
+        if (!recordingReplay || replayRecording.ticks.empty()) {
+            return;
+        }
+        recordingReplay = false;
+        try {
+            saveReplayFile(options.recordPath, replayRecording);
+            std::cout << "Replay saved to " << options.recordPath << " (" << replayRecording.ticks.size() << " ticks)"
+                    << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
 
-    void render() {
-        // --- Clear Screen ---
-        glClearColor(0.1f, 0.1f, 0.12f, 1.0f); // Dark background
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // --- Render Game World Elements (if applicable) ---
-        if (currentState == GameState::PLAYING || currentState == GameState::GAME_OVER) {
-            // Bricks
-            for (const auto &block: blocks) {
-                if (block.active) {
-                    renderGameObject(block);
-                }
+    // --- Grid View ---
+    bool isGridMode() const { return options.gridGames > 0; }
+
+    // Crée N parties pilotées automatiquement, toutes au format de référence 16:9
+    void initGrid() {
+        const int count = options.gridGames;
+        gridWorlds.assign(count, GameWorld());
+        gridPilots.clear();
+        const auto seed = static_cast<uint32_t>(time(nullptr));
+        for (int i = 0; i < count; ++i) {
+            GameWorld &gridWorld = gridWorlds[i];
+            gridWorld.rngState = seed + 0x9E3779B9u * static_cast<uint32_t>(i + 1);
+            gridWorld.setBounds(REFERENCE_WIDTH / REFERENCE_HEIGHT, 1.0f);
+            gridWorld.initGame();
+            gridPilots.emplace_back(seed ^ (0x85EBCA6Bu * static_cast<uint32_t>(i + 1)));
+        }
+        frameCommands.reserve(static_cast<size_t>(count) * (BRICK_ROWS * BRICKS_PER_ROW + 8));
+        currentState = GameState::PLAYING;
+    }
+
+    void updateGrid(const float dt) {
+        for (size_t i = 0; i < gridWorlds.size(); ++i) {
+            GameWorld &gridWorld = gridWorlds[i];
+            gridWorld.applyInput(gridPilots[i].decide(gridWorld), dt);
+            gridWorld.update(dt);
+            if (gridWorld.gameOver) {
+                gridWorld.initGame(); // Relancer pour garder la grille vivante
             }
+        }
+    }
 
+    // Toutes les parties sont transformées sur le CPU et dessinées en un seul appel
+    // Case i d'une grille de count plateaux (colonnes = ceil(sqrt(count)))
+    WorldTransform boardTransform(const int index, const int count) const {
+        const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const int rows = (count + columns - 1) / columns;
+        const float cellWidth = 2.0f * gameBoundX / columns;
+        const float cellHeight = 2.0f * gameBoundY / rows;
+        const float worldWidth = 2.0f * REFERENCE_WIDTH / REFERENCE_HEIGHT;
+        const float margin = 0.95f; // Petit espace entre les cases
+
+        WorldTransform transform;
+        transform.scale = std::min(cellWidth / worldWidth, cellHeight / 2.0f) * margin;
+        transform.offsetX = -gameBoundX + (index % columns + 0.5f) * cellWidth;
+        transform.offsetY = gameBoundY - (index / columns + 0.5f) * cellHeight;
+        return transform;
+    }
 
-            // Bonus en train de tomber
-            for (const auto &bonus: fallingBonuses) {
-                if (bonus.active) {
-                    renderFallingBonus(bonus);
-                }
+    void batchBoards(DrawCommandBuffer &commands, const GameWorld *boards, const int count) const {
+        const Color cellBackground{0.16f, 0.16f, 0.19f, 1.0f};
+        for (int i = 0; i < count; ++i) {
+            const WorldTransform transform = boardTransform(i, count);
+            const GameWorld &board = boards[i];
+            transform.addObject(commands, Vec2{-board.gameBoundX, -board.gameBoundY},
+                                Vec2{2.0f * board.gameBoundX, 2.0f * board.gameBoundY}, cellBackground);
+            batchWorld(commands, board, transform);
+        }
+    }
+
+    // --- Versus ---
+    bool isVersusMode() const { return !options.versus.empty(); }
+
+    void initVersus() {
+        const auto seed = static_cast<uint32_t>(options.seed); // Identique chez les deux joueurs
+        if (options.versus == "loopback") {
+            auto link = std::make_shared<LoopbackLink>();
+            link->latencyMs = options.latencyMs;
+            link->lossRate = options.lossRate;
+            versusSession.reset(new VersusSession(std::make_unique<LoopbackTransport>(link, 0), 0,
+                                                  options.inputDelay, selectedLevel, seed));
+            loopbackOpponent.reset(new VersusSession(std::make_unique<LoopbackTransport>(link, 1), 1,
+                                                     options.inputDelay, selectedLevel, seed));
+        } else {
+#ifndef _WIN32
+            int localPort = 0, peerPort = 0;
+            char peerHost[256] = {};
+            if (std::sscanf(options.versus.c_str(), "%d,%255[^:]:%d", &localPort, peerHost, &peerPort) != 3) {
+                throw std::runtime_error("Invalid --versus value (expected loopback or PORT,HOST:PORT): " +
+                                         options.versus);
             }
+            versusSession.reset(new VersusSession(std::make_unique<UdpTransport>(localPort, peerHost, peerPort),
+                                                  options.player, options.inputDelay, selectedLevel, seed));
+#else
+            throw std::runtime_error("UDP versus mode is not available on Windows (use --versus=loopback)");
+#endif
+        }
+        currentState = GameState::PLAYING;
+    }
 
-            // Paddle
-            renderGameObject(playerPaddle);
-            // Ball (render if playing, or if game over but ball wasn't stuck/lost yet)
-            if (currentState == GameState::PLAYING || (lives > 0 && !gameBall.stuckToPaddle)) {
-                renderGameObject(gameBall);
+    // Simulation à 60 Hz fixe (lockstep), découplée de la fréquence d'affichage
+    void updateVersus(const float dt) {
+        versusAccumulator = std::min(versusAccumulator + dt, 4.0f * VERSUS_TIME_STEP); // Rattrapage limité
+        while (versusAccumulator >= VERSUS_TIME_STEP) {
+            versusAccumulator -= VERSUS_TIME_STEP;
+            versusSession->tick(versusInput);
+            if (loopbackOpponent) {
+                loopbackOpponent->tick(loopbackPilot.decide(loopbackOpponent->board(1)));
             }
         }
+    }
+
+    // --- Rendering Functions ---
+
+    void render() {
+        // --- Enregistrement de la frame : aucun appel de dessin, seulement des commandes ---
+        frameCommands.reset();
+        frameCommands.clear(Color{0.1f, 0.1f, 0.12f, 1.0f}); // Dark background
+        if (isGridMode()) {
+            batchBoards(frameCommands, gridWorlds.data(), static_cast<int>(gridWorlds.size()));
+        } else if (isVersusMode()) {
+            batchBoards(frameCommands, &versusSession->board(0), 2);
+        } else if (spectatorClient) {
+            batchBoards(frameCommands, &world, 1); // Limites du monde de l'hôte, mises à l'échelle de la fenêtre
+        } else if (currentState == GameState::PLAYING || currentState == GameState::GAME_OVER) {
+            batchWorld(frameCommands, world, WorldTransform());
+        }
+
+        // Seule la préparation CPU (quads du HUD, frame ImGui) est chronométrée, pas la soumission
+        const auto uiStart = std::chrono::steady_clock::now();
+        if (fastHud() && !isGridMode() && !isVersusMode() &&
+            (currentState == GameState::PLAYING || currentState == GameState::GAME_OVER)) {
+            updateHud();
+            frameCommands.addQuads(DrawLayer::SCREEN, DrawMaterial::TEXT, hudQuads.data(), hudQuads.size());
+        }
+        if (imguiFrameActive) {
+            // --- Render UI using Dear ImGui ---
+            renderUI(); // Separate function for ImGui elements
 
-        // --- Render UI using Dear ImGui ---
-        renderUI(); // Separate function for ImGui elements
+            // --- Finalize ImGui Frame ---
+            ImGui::Render();
+        }
+        uiTime.record(std::chrono::steady_clock::now() - uiStart);
+        uiTime.endFrame(imguiFrameActive);
+        frameCommands.finish();
+
+        if (options.vulkan) {
+#ifdef BREAKOUT_VULKAN
+            // Tous les objets passent par un seul lot d'instances ; le HUD est celui d'ImGui
+            vulkanRenderer->drawFrame(frameCommands, gameBoundX, gameBoundY,
+                                      imguiFrameActive ? ImGui::GetDrawData() : nullptr);
+#endif
+            return;
+        }
 
-        // --- Finalize ImGui Frame and Render it ---
-        ImGui::Render();
-        ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
+        DrawView view;
+        view.boundX = gameBoundX;
+        view.boundY = gameBoundY;
+        glfwGetWindowSize(window, &view.screenWidth, &view.screenHeight);
+        glfwGetFramebufferSize(window, &view.targetWidth, &view.targetHeight);
+
+        // --- Post-processing: la scène est dessinée dans un FBO de la taille de la fenêtre, le HUD après ---
+        if (postProcessor.active()) {
+            postProcessor.beginScene(view.targetWidth, view.targetHeight);
+            const size_t hudBegin = frameCommands.layerBegin(DrawLayer::SCREEN);
+            renderBackend->execute(frameCommands, view, 0, hudBegin);
+            postProcessor.apply(offscreenTarget.framebuffer); // 0 (écran) hors mode offscreen
+            renderBackend->execute(frameCommands, view, hudBegin, frameCommands.commands().size());
+        } else {
+            renderBackend->execute(frameCommands, view);
+        }
+        renderStats = renderBackend->takeStats();
+        if (imguiFrameActive) {
+            ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // --- Swap Buffers ---
         glfwSwapBuffers(window);
@@ -725,14 +9832,196 @@ private:
     void renderUI() {
         int currentWindowWidth, currentWindowHeight;
         glfwGetWindowSize(window, &currentWindowWidth, &currentWindowHeight);
-        if (currentState == GameState::MENU) {
+        if (isGridMode()) {
+            renderGridUI();
+        } else if (isVersusMode()) {
+            renderVersusUI(currentWindowWidth, currentWindowHeight);
+        } else if (currentState == GameState::MENU) {
             renderMenuUI(currentWindowWidth, currentWindowHeight);
-        } else if (currentState == GameState::PLAYING || currentState == GameState::GAME_OVER) {
+        } else if (currentState == GameState::EDITOR) {
+            renderEditorUI(currentWindowWidth, currentWindowHeight);
+        } else if ((currentState == GameState::PLAYING || currentState == GameState::GAME_OVER) && !fastHud()) {
             renderGameUI(currentWindowWidth, currentWindowHeight); // Score, Lives
             if (currentState == GameState::GAME_OVER) {
-                renderGameOverUI(currentWindowWidth, currentWindowHeight); // Game Over message
+                pollGameOverRank();
+                renderGameOverUI(currentWindowWidth, currentWindowHeight,
+                                 gameOverRankKnown ? &gameOverRank : nullptr); // Game Over message
+            }
+        }
+        if (showDebugWindow) {
+            renderDebugUI();
+        }
+    }
+
+    void renderEditorUI(const int &wW, const int &wH) {
+        switch (levelEditor.draw(wW, wH)) {
+            case LevelEditor::Action::PLAY:
+                selectedLevel = std::make_shared<const LevelData>(levelEditor.currentLevel());
+                currentState = GameState::PLAYING;
+                initGame();
+                break;
+            case LevelEditor::Action::EXIT:
+                currentState = GameState::MENU;
+                break;
+            default: break;
+        }
+    }
+
+    void renderGridUI() const {
+        const std::string gridText = "GRID: " + std::to_string(gridWorlds.size()) + " games  " +
+                                     std::to_string(renderStats.quads) + " quads / " +
+                                     std::to_string(renderStats.drawCalls) +
+                                     (renderStats.drawCalls == 1 ? " draw call" : " draw calls");
+        ImGui::GetForegroundDrawList()->AddText(ImVec2(15.0f, 10.0f), IM_COL32(255, 255, 255, 255),
+                                                gridText.c_str());
+    }
+
+    void renderVersusUI(int wW, int wH) const {
+        const VersusSession &session = *versusSession;
+        ImDrawList *drawList = ImGui::GetForegroundDrawList();
+        for (int p = 0; p < 2; ++p) {
+            const GameWorld &board = session.board(p);
+            const std::string text = "P" + std::to_string(p + 1) + (p == session.localPlayerIndex() ? " (you)" : "") +
+                                     "  Score: " + std::to_string(board.score) + "  Lives: " +
+                                     std::to_string(board.lives);
+            drawList->AddText(ImVec2(15.0f + p * wW * 0.5f, 10.0f), IM_COL32(255, 255, 255, 255), text.c_str());
+        }
+        char netText[160];
+        std::snprintf(netText, sizeof(netText),
+                      "frame %d  lag %d  rollbacks %lld (max %d frames, %.0f us)  stalls %lld",
+                      session.frame, session.frame - 1 - session.remoteFrame, session.rollbacks,
+                      session.maxRollbackFrames, session.maxRollbackMicros, session.stalls);
+        drawList->AddText(ImVec2(15.0f, wH - 25.0f), IM_COL32(180, 180, 180, 255), netText);
+
+        if (session.finished()) {
+            const int winner = session.winner();
+            const char *result = winner < 0 ? "DRAW" : winner == session.localPlayerIndex() ? "YOU WIN" : "YOU LOSE";
+            const ImVec2 size = ImGui::CalcTextSize(result);
+            drawList->AddText(ImVec2((wW - size.x) * 0.5f, (wH - size.y) * 0.5f), IM_COL32(255, 220, 80, 255),
+                              result);
+        }
+    }
+
+    // Fenêtre de debug : histogramme des durées de frame et état du mode low-jitter
+    void renderDebugUI() {
+        ImGui::SetNextWindowSize(ImVec2(420.0f, 0.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Debug");
+        ImGui::Text("Frames: %lld  mean %.3f ms  stddev %.3f ms", frameHistogram.count, frameHistogram.mean,
+                    frameHistogram.stddev());
+        ImGui::Text("p50 %.2f ms  p99 %.2f ms  p99.9 %.2f ms  max %.2f ms", frameHistogram.percentile(0.50),
+                    frameHistogram.percentile(0.99), frameHistogram.percentile(0.999), frameHistogram.maxMs);
+        // Limiter l'affichage aux 80 premières cases (0-20 ms), le reste est visible via p99/max
+        ImGui::PlotHistogram("##frames", frameHistogram.buckets, 80, 0, "frame time (0-20 ms)", 0.0f, FLT_MAX,
+                             ImVec2(0.0f, 80.0f));
+        if (ImGui::Button("Reset")) {
+            frameHistogram.reset();
+        }
+
+        if (!postProcessor.passes.empty()) {
+            ImGui::Separator();
+            ImGui::Text("Post-processing (budget %.2f ms)", postProcessor.budgetMs);
+            for (size_t i = 0; i < postProcessor.passes.size(); ++i) {
+                PostProcessor::Pass &pass = postProcessor.passes[i];
+                bool enabled = pass.enabled;
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::Checkbox(pass.name(), &enabled)) {
+                    postProcessor.setEnabled(pass, enabled);
+                }
+                ImGui::SameLine();
+                if (pass.type == PostProcessor::PassType::BLOOM) {
+                    ImGui::Text("1/%d res", pass.scale);
+                    ImGui::SameLine();
+                }
+                if (pass.measured) {
+                    ImGui::Text("%.3f ms%s", pass.costMs, pass.overBudget ? "  (over budget)" : "");
+                } else {
+                    ImGui::TextDisabled(pass.overBudget ? "over budget" : "not measured");
+                }
+                ImGui::PopID();
+            }
+        }
+
+        ImGui::Separator();
+        ImGui::Text("UI per frame: %.1f us without ImGui, %.1f us with ImGui", uiTime.meanMicros(false),
+                    uiTime.meanMicros(true));
+        if (renderBackend) {
+            ImGui::Text("Backend %s: %u commands, %u draws, %u state changes, %zu quads",
+                        renderBackendName(options.backend), renderStats.commands, renderStats.drawCalls,
+                        renderStats.stateChanges, renderStats.quads);
+        }
+
+#ifdef BREAKOUT_VULKAN
+        if (vulkanRenderer) {
+            ImGui::Separator();
+            ImGui::Text("Vulkan: %s, %u images, %d frame(s) in flight", vulkanRenderer->deviceName(),
+                        vulkanRenderer->imageCount(), vulkanRenderer->framesInFlight());
+            for (PresentMode mode: {PresentMode::FIFO, PresentMode::FIFO_RELAXED, PresentMode::MAILBOX,
+                                    PresentMode::IMMEDIATE}) {
+                if (!vulkanRenderer->supports(mode)) continue;
+                ImGui::SameLine();
+                if (ImGui::RadioButton(presentModeName(mode), vulkanRenderer->presentMode() == mode)) {
+                    vulkanRenderer->setPresentMode(mode);
+                }
+            }
+        }
+#endif
+
+        ImGui::Separator();
+        ImGui::Text("Display: %s, %d Hz", displayModeName(displayMode), refreshRate);
+        if (!options.offscreen) {
+            int count = 0;
+            GLFWmonitor **monitors = glfwGetMonitors(&count);
+            for (int i = 0; i < count; ++i) {
+                const char *name = glfwGetMonitorName(monitors[i]);
+                ImGui::PushID(i);
+                ImGui::Text("%d: %s", i, name ? name : "?");
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Windowed")) setDisplayMode(DisplayMode::WINDOWED, i);
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Borderless")) setDisplayMode(DisplayMode::BORDERLESS, i);
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Fullscreen")) setDisplayMode(DisplayMode::FULLSCREEN, i);
+                ImGui::PopID();
+            }
+        }
+
+        if (rewind.enabled()) {
+            ImGui::Separator();
+            ImGui::Text("Rewind: %d ticks, %.1f s, %zu KB, record %.3f us/tick", rewind.size(), rewind.span(),
+                        rewind.memoryBytes() / 1024, rewind.meanRecordMicros());
+            if (!rewinding) {
+                if (canRewind() && ImGui::Button("Pause (F2)")) startRewind();
+            } else {
+                if (ImGui::ArrowButton("##back", ImGuiDir_Left)) seekRewind(rewindCursor - 1);
+                ImGui::SameLine();
+                if (ImGui::ArrowButton("##forward", ImGuiDir_Right)) seekRewind(rewindCursor + 1);
+                ImGui::SameLine();
+                int cursor = rewindCursor;
+                if (ImGui::SliderInt("##timeline", &cursor, 0, rewind.size() - 1)) seekRewind(cursor);
+                ImGui::Text("Tick %d / %d, %.3f s before the pause", rewindCursor, rewind.size() - 1,
+                            rewind.secondsAt(rewind.size() - 1) - rewind.secondsAt(rewindCursor));
+                if (ImGui::Button("Resume (F2)")) resumeFromRewind();
             }
         }
+
+        if (eventStream) {
+            ImGui::Separator();
+            ImGui::Text("Events (%s): %llu written in %llu frames, %llu KB", eventFormatName(options.eventFormat),
+                        static_cast<unsigned long long>(eventStream->eventsWritten.load()),
+                        static_cast<unsigned long long>(eventStream->batchesWritten.load()),
+                        static_cast<unsigned long long>(eventStream->bytesWritten.load() / 1024));
+            ImGui::Text("Dropped: %llu events in %llu frames%s",
+                        static_cast<unsigned long long>(eventStream->droppedEvents.load()),
+                        static_cast<unsigned long long>(eventStream->droppedBatches.load()),
+                        eventStream->failed ? " (consumer gone)" : "");
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Low-jitter: %s", options.lowJitter ? "ON" : "OFF");
+        for (const auto &line: lowJitterReport) {
+            ImGui::BulletText("%s", line.c_str());
+        }
+        ImGui::End();
     }
 
     // Renders the main menu using ImGui widgets
@@ -758,7 +10047,8 @@ private:
         constexpr float buttonHeight = 50;
         const float buttonPosX = (wW - buttonWidth) / 2.0f;
         const float buttonPosY_Play = wH / 2.0f - buttonHeight;
-        const float buttonPosY_Exit = wH / 2.0f + 10;
+        const float buttonPosY_Editor = wH / 2.0f + 10;
+        const float buttonPosY_Exit = buttonPosY_Editor + buttonHeight + 10;
 
         // Play Button
         ImGui::SetCursorPos(ImVec2(buttonPosX, buttonPosY_Play));
@@ -767,6 +10057,12 @@ private:
             initGame();
         }
 
+        // Editor Button
+        ImGui::SetCursorPos(ImVec2(buttonPosX, buttonPosY_Editor));
+        if (ImGui::Button("EDITOR", ImVec2(buttonWidth, buttonHeight))) {
+            currentState = GameState::EDITOR;
+        }
+
         // Exit Button
         ImGui::SetCursorPos(ImVec2(buttonPosX, buttonPosY_Exit));
         if (ImGui::Button("EXIT", ImVec2(buttonWidth, buttonHeight))) {
@@ -776,27 +10072,91 @@ private:
         ImGui::End();
     }
 
+    // --- HUD rapide ---
+    bool fastHud() const { return hudFont.ready() && !options.imguiHud; }
+
+    // En partie, le HUD est dessiné sans ImGui : sa frame n'est commencée que pour les menus,
+    // l'éditeur, les vues grille / versus et la fenêtre de debug
+    bool needsImGui() const {
+        if (!fastHud() || showDebugWindow || isGridMode() || isVersusMode()) {
+            return true;
+        }
+        return currentState != GameState::PLAYING && currentState != GameState::GAME_OVER;
+    }
+
+    void pollGameOverRank() {
+        if (highScores && !gameOverRankKnown) {
+            gameOverRankKnown = highScores->tryQuery(static_cast<uint32_t>(std::max(0, world.score)),
+                                                     gameOverRank); // Réessayé à la frame suivante
+        }
+    }
+
+    // HUD en texte SDF : score, niveau, vies et écran de fin dans un seul lot de commandes,
+    // aux mêmes positions que la version ImGui (renderGameUI / renderGameOverUI). Les quads
+    // des glyphes ne sont recalculés que si l'un des textes ou la taille de la fenêtre change.
+    void updateHud() {
+        int wW, wH;
+        glfwGetWindowSize(window, &wW, &wH);
+        if (currentState == GameState::GAME_OVER) {
+            pollGameOverRank();
+        }
+        const HudKey key = {world.score, world.currentLevel, world.lives, currentState == GameState::GAME_OVER,
+                            gameOverRankKnown, wW, wH};
+        if (!hudQuads.empty() && key == hudKey) {
+            return;
+        }
+        hudKey = key;
+        const ImU32 white = IM_COL32(255, 255, 255, 255);
+        hudQuads.clear();
+
+        const std::string scoreText = "SCORE: " + std::to_string(world.score);
+        hudFont.addText(hudQuads, 15.0f, 10.0f, HUD_TEXT_SIZE, white, scoreText);
+        const std::string levelText = "LEVEL: " + std::to_string(world.currentLevel);
+        hudFont.addText(hudQuads, (wW - hudFont.measure(levelText, HUD_TEXT_SIZE)) / 2.0f, 10.0f, HUD_TEXT_SIZE,
+                        white, levelText);
+        const std::string livesText = "LIVES: " + std::to_string(world.lives);
+        hudFont.addText(hudQuads, wW - hudFont.measure(livesText, HUD_TEXT_SIZE) - 15.0f / 2, 10.0f, HUD_TEXT_SIZE,
+                        white, livesText);
+
+        if (currentState == GameState::GAME_OVER) {
+            const float titleSize = HUD_TEXT_SIZE * HUD_TITLE_SCALE;
+            const std::string title = "GAME OVER";
+            hudFont.addText(hudQuads, (wW - hudFont.measure(title, titleSize)) / 2.0f, wH * 0.4f, titleSize,
+                            IM_COL32(255, 50, 50, 255), title);
+            if (gameOverRankKnown) {
+                const std::string rankText = "RANK " + std::to_string(gameOverRank.rank) + " / " +
+                                             std::to_string(gameOverRank.total) + "   BEST " +
+                                             std::to_string(gameOverRank.best);
+                hudFont.addText(hudQuads, (wW - hudFont.measure(rankText, HUD_TEXT_SIZE)) / 2.0f, wH * 0.5f,
+                                HUD_TEXT_SIZE, IM_COL32(255, 215, 0, 255), rankText);
+            }
+            const std::string restartText = "Press ENTER to Return to Menu";
+            hudFont.addText(hudQuads, (wW - hudFont.measure(restartText, HUD_TEXT_SIZE)) / 2.0f, wH * 0.6f,
+                            HUD_TEXT_SIZE, white, restartText);
+        }
+    }
+
     void renderGameUI(const float &wW, const float &wH) const {
         ImDrawList *drawList = ImGui::GetForegroundDrawList(); // Draw on top of game
 
         // Score Display (Top-Left)
-        std::string scoreText = "SCORE: " + std::to_string(score);
+        std::string scoreText = "SCORE: " + std::to_string(world.score);
         drawList->AddText(ImVec2(15.0f, 10.0f), IM_COL32(255, 255, 255, 255), scoreText.c_str());
 
         // Level Display (Top-Middle)
-        std::string levelText = "LEVEL: " + std::to_string(currentLevel);
+        std::string levelText = "LEVEL: " + std::to_string(world.currentLevel);
         ImVec2 levelTextSize = ImGui::CalcTextSize(levelText.c_str());
         drawList->AddText(ImVec2((wW - levelTextSize.x) / 2.0f, 10.0f), IM_COL32(255, 255, 255, 255),
                           levelText.c_str());
 
         // Lives Display (Top-Right)
-        std::string livesText = "LIVES: " + std::to_string(lives);
+        std::string livesText = "LIVES: " + std::to_string(world.lives);
         ImVec2 livesTextSize = ImGui::CalcTextSize(livesText.c_str());
         drawList->AddText(ImVec2(wW - livesTextSize.x - 15.0f / 2, 10.0f), IM_COL32(255, 255, 255, 255),
                           livesText.c_str());
     }
 
-    static void renderGameOverUI(const float &wW, const float &wH) {
+    static void renderGameOverUI(const float &wW, const float &wH, const HighScoreRank *rank) {
         ImDrawList *drawList = ImGui::GetForegroundDrawList();
 
         // --- "GAME OVER" Text ---
@@ -807,6 +10167,15 @@ private:
         ImVec2 goTextPos = ImVec2((wW - goTextSize.x * 2.0f) / 2.0f, wH * 0.4f);
         drawList->AddText(nullptr, goFontSize, goTextPos, IM_COL32(255, 50, 50, 255), gameOverMsg);
 
+        // --- Rank ---
+        if (rank) {
+            const std::string rankMsg = "RANK " + std::to_string(rank->rank) + " / " + std::to_string(rank->total) +
+                                        "   BEST " + std::to_string(rank->best);
+            ImVec2 rankTextSize = ImGui::CalcTextSize(rankMsg.c_str());
+            drawList->AddText(ImVec2((wW - rankTextSize.x) / 2.0f, wH * 0.5f), IM_COL32(255, 215, 0, 255),
+                              rankMsg.c_str());
+        }
+
         // --- "Press Enter" Text ---
         const char *restartMsg = "Press ENTER to Return to Menu";
         ImVec2 restartTextSize = ImGui::CalcTextSize(restartMsg);
@@ -814,214 +10183,6 @@ private:
         drawList->AddText(restartTextPos, IM_COL32(255, 255, 255, 255), restartMsg);
     }
 
-    static void renderFallingBonus(const FallingBonus &bonus) {
-        glColor4f(bonus.color.r, bonus.color.g, bonus.color.b, bonus.color.a);
-        glBegin(GL_QUADS);
-        glVertex2f(bonus.position.x, bonus.position.y);
-        glVertex2f(bonus.position.x + bonus.size.x, bonus.position.y);
-        glVertex2f(bonus.position.x + bonus.size.x, bonus.position.y + bonus.size.y);
-        glVertex2f(bonus.position.x, bonus.position.y + bonus.size.y);
-        glEnd();
-    }
-
-    static void renderGameObject(const GameObject &obj) {
-        glColor4f(obj.color.r, obj.color.g, obj.color.b, obj.color.a);
-        glBegin(GL_QUADS);
-        glVertex2f(obj.position.x, obj.position.y);
-        glVertex2f(obj.position.x + obj.size.x, obj.position.y);
-        glVertex2f(obj.position.x + obj.size.x, obj.position.y + obj.size.y);
-        glVertex2f(obj.position.x, obj.position.y + obj.size.y);
-        glEnd();
-    }
-
-    static bool checkCollision(const GameObject &one, const GameObject &two) {
-        return one.position.x < two.position.x + two.size.x && one.position.x + one.size.x > two.position.x && one.
-               position.y < two.position.y + two.size.y && one.position.y + one.size.y > two.position.y;
-    }
-
-    void handleCollisions() {
-        handleBallWallCollision();
-        if (checkCollision(gameBall, playerPaddle)) {
-            resolveBallPaddleCollision();
-        }
-        for (auto &block: blocks) {
-            if (block.active && checkCollision(gameBall, block)) {
-                resolveBallBlockCollision(block);
-                break;
-            }
-        }
-    }
-
-    void handleBallWallCollision() {
-        if (gameBall.position.x <= -gameBoundX) {
-            gameBall.velocity.x = std::abs(gameBall.velocity.x);
-            gameBall.position.x = -gameBoundX;
-        } else if (gameBall.position.x + gameBall.size.x >= gameBoundX) {
-            gameBall.velocity.x = -std::abs(gameBall.velocity.x);
-            gameBall.position.x = gameBoundX - gameBall.size.x;
-        }
-        if (gameBall.position.y + gameBall.size.y >= gameBoundY) {
-            //Collision avec le plafond
-            if (!playerPaddle.isShrunk) {
-                playerPaddle.isShrunk = true;
-                playerPaddle.size.x *= 0.5f;
-            }
-            gameBall.velocity.y = -std::abs(gameBall.velocity.y);
-            gameBall.position.y = gameBoundY - gameBall.size.y;
-        }
-    }
-
-    void resolveBallPaddleCollision() {
-        if (gameBall.velocity.y >= 0.0f)
-            return;
-
-        // Repositionnement au-dessus de la raquette
-        gameBall.position.y = playerPaddle.position.y + playerPaddle.size.y;
-
-        // Calcul de l'impact normalisé (-1 = bord gauche, +1 = bord droit)
-        float ballCenterX = gameBall.position.x + gameBall.size.x * 0.5f;
-        float paddleCenterX = playerPaddle.position.x + playerPaddle.size.x * 0.5f;
-        float offset = (ballCenterX - paddleCenterX) / (playerPaddle.size.x * 0.5f);
-        float normalizedOffset = std::max(-1.0f, std::min(offset, 1.0f));
-
-        // Inversion de la composante verticale
-        gameBall.velocity.y = std::abs(gameBall.velocity.y);
-
-        // Définir les seuils pour les quarts de la raquette
-        const float quarterThreshold = 0.5f;
-
-        if (normalizedOffset <= -quarterThreshold) {
-            // Quart gauche : peu de déviation horizontale
-            gameBall.velocity.x = normalizedOffset * gameBall.speedMagnitude * 0.2f;
-
-            // Recalculer la composante verticale pour maintenir la magnitude
-            float vy = std::sqrt(
-                gameBall.speedMagnitude * gameBall.speedMagnitude
-                - gameBall.velocity.x * gameBall.velocity.x
-            );
-            gameBall.velocity.y = vy;
-        } else if (normalizedOffset >= quarterThreshold) {
-            // Quart droit : forte déviation horizontale
-            gameBall.velocity.x = normalizedOffset * gameBall.speedMagnitude * 0.8f;
-
-            // Recalculer la composante verticale pour maintenir la magnitude
-            float vy = std::sqrt(
-                gameBall.speedMagnitude * gameBall.speedMagnitude
-                - gameBall.velocity.x * gameBall.velocity.x
-            );
-            gameBall.velocity.y = vy;
-        }
-    }
-
-    void resolveBallBlockCollision(Block &block) {
-        if (block.isWall) {
-            if (block.isReflective) {
-                // Mur à rétroréflexion
-                gameBall.velocity.x = -gameBall.velocity.x;
-                gameBall.velocity.y = -gameBall.velocity.y;
-            } else {
-                // Mur normal - rebond standard
-                // Déterminer où la balle a frappé la brique
-                float ballCenterX = gameBall.position.x + gameBall.size.x / 2.0f;
-                float ballCenterY = gameBall.position.y + gameBall.size.y / 2.0f;
-                float blockCenterX = block.position.x + block.size.x / 2.0f;
-                float blockCenterY = block.position.y + block.size.y / 2.0f;
-
-                // Calculer les distances relatives
-                float diffX = ballCenterX - blockCenterX;
-                float diffY = ballCenterY - blockCenterY;
-
-                // Déterminer si la collision est horizontale ou verticale
-                if (std::abs(diffX / block.size.x) > std::abs(diffY / block.size.y)) {
-                    // Collision horizontale
-                    gameBall.velocity.x = -gameBall.velocity.x;
-                } else {
-                    // Collision verticale
-                    gameBall.velocity.y = -gameBall.velocity.y;
-                }
-            }
-            return;
-        }
-
-        // Appliquer le rebond d'abord
-        // Déterminer où la balle a frappé la brique
-        float ballCenterX = gameBall.position.x + gameBall.size.x / 2.0f;
-        float ballCenterY = gameBall.position.y + gameBall.size.y / 2.0f;
-        float blockCenterX = block.position.x + block.size.x / 2.0f;
-        float blockCenterY = block.position.y + block.size.y / 2.0f;
-
-        // Calculer les distances relatives
-        float diffX = ballCenterX - blockCenterX;
-        float diffY = ballCenterY - blockCenterY;
-
-        // Déterminer si la collision est horizontale ou verticale
-        if (std::abs(diffX / block.size.x) > std::abs(diffY / block.size.y)) {
-            // Collision horizontale
-            gameBall.velocity.x = -gameBall.velocity.x;
-        } else {
-            // Collision verticale
-            gameBall.velocity.y = -gameBall.velocity.y;
-        }
-
-        // Ajuster légèrement la position pour éviter une nouvelle collision immédiate
-        float signY = (gameBall.velocity.y > 0) ? 1.0f : -1.0f;
-        gameBall.position.y += signY * 0.001f;
-
-        // Ensuite, diminuer le compteur de coups
-        block.hitCounter--;
-
-        // Si le compteur atteint 0, désactiver la brique
-        if (block.hitCounter <= 0) {
-            block.active = false;
-            score += block.points;
-
-            // Logique pour les briques bonus
-            if (block.isBonus) {
-                spawnBonus(block);
-            }
-        } else {
-            block.color = getColorFromEnum(block.colorType);
-        }
-
-        // Incrémenter le compteur de coups et appliquer l'augmentation de vitesse
-        gameBall.hitCount++;
-        applySpeedIncrease(block);
-    }
-
-    void applySpeedIncrease(const Block &b) {
-        bool speedIncreased = false;
-        if (gameBall.hitCount == 4 || gameBall.hitCount == 12) {
-            gameBall.speedMagnitude *= BALL_SPEED_INCREMENT;
-            speedIncreased = true;
-        }
-
-        if (playerPaddle.firstContactRed && b.colorType == BrickColor::RED) {
-            gameBall.speedMagnitude *= BALL_SPEED_INCREMENT;
-            playerPaddle.firstContactRed = false;
-            speedIncreased = true;
-        }
-
-        if (playerPaddle.firstContactOrange && BrickColor::ORANGE == b.colorType) {
-            gameBall.speedMagnitude *= BALL_SPEED_INCREMENT;
-            playerPaddle.firstContactOrange = false;
-            speedIncreased = true;
-        }
-        if (speedIncreased) {
-            normalizeVelocity();
-        }
-    }
-
-    void normalizeVelocity() {
-        float currentSpeed = std::sqrt(
-            gameBall.velocity.x * gameBall.velocity.x + gameBall.velocity.y * gameBall.velocity.y);
-        if (currentSpeed > 0.0001f) {
-            gameBall.velocity.x = (gameBall.velocity.x / currentSpeed) * gameBall.speedMagnitude;
-            gameBall.velocity.y = (gameBall.velocity.y / currentSpeed) * gameBall.speedMagnitude;
-        } else if (!gameBall.stuckToPaddle) {
-            gameBall.velocity = Vec2{0.0f, gameBall.speedMagnitude};
-        }
-    }
-
     // --- GLFW Callbacks ---
 
     // Handles window resize events - updates viewport and projection matrix
@@ -1029,6 +10190,17 @@ private:
         auto gameInstance = static_cast<Game *>(glfwGetWindowUserPointer(window));
         if (gameInstance) {
             gameInstance->updateProjectionMatrix(width, height);
+#ifdef BREAKOUT_VULKAN
+            if (gameInstance->vulkanRenderer) gameInstance->vulkanRenderer->resized();
+#endif
+        }
+    }
+
+    // Fenêtre déplacée : elle peut avoir changé de moniteur, donc de fréquence
+    static void windowPosCallback(GLFWwindow *window, int, int) {
+        auto gameInstance = static_cast<Game *>(glfwGetWindowUserPointer(window));
+        if (gameInstance && gameInstance->displayMode == DisplayMode::WINDOWED) {
+            gameInstance->updateRefreshRate(gameInstance->monitorUnderWindow());
         }
     }
 
@@ -1046,61 +10218,98 @@ private:
         windowWidth = width;
         windowHeight = height;
 
-        float oldBoundX = gameBoundX;
-        float oldBoundY = gameBoundY;
-
-        // Mise a jour de la matrice de projection
-        glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
         const float aspect = static_cast<float>(width) / static_cast<float>(height);
-
         if (width >= height) {
             // Wider than tall
             gameBoundX = aspect;
             gameBoundY = 1.0f;
-            glOrtho(-aspect, aspect, -1.0f, 1.0f, -1.0f, 1.0f);
         } else {
             // Taller than wide
             gameBoundX = 1.0f;
             gameBoundY = 1.0f / aspect;
-            glOrtho(-1.0f, 1.0f, -1.0f / aspect, 1.0f / aspect, -1.0f, 1.0f);
         }
 
-        // Ajuster la vitesse en fonction du changement des dimensions du monde
-        if (currentState == GameState::PLAYING && !gameBall.stuckToPaddle) {
-            // Calculer le facteur d'échelle pour la vitesse
-            float speedScaleFactor = (gameBoundX / oldBoundX + gameBoundY / oldBoundY) / 2.0f;
-
-            // Appliquer ce facteur à la vitesse actuelle de la balle
-            float currentSpeed = std::sqrt(gameBall.velocity.x * gameBall.velocity.x +
-                                           gameBall.velocity.y * gameBall.velocity.y);
-
-            if (currentSpeed > 0.0001f) {
-                // Maintenir la direction, mais ajuster la magnitude
-                gameBall.velocity.x *= speedScaleFactor;
-                gameBall.velocity.y *= speedScaleFactor;
+        // Mise a jour de la matrice de projection (le rendu Vulkan la passe en push constants)
+        if (!options.vulkan) {
+            glMatrixMode(GL_PROJECTION);
+            glLoadIdentity();
+            glOrtho(-gameBoundX, gameBoundX, -gameBoundY, gameBoundY, -1.0f, 1.0f);
 
-                // Mettre à jour speedMagnitude pour les futurs calculs
-                gameBall.speedMagnitude *= speedScaleFactor;
-            }
+            // Reset model-view matrix
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
         }
 
-        // Reset model-view matrix
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
-
-        // Réinitialiser les blocs et autres éléments si nécessaire
-        if (currentState == GameState::PLAYING && !blocks.empty())
-            updateBlockPositions();
+        // Le monde ajuste la vitesse de la balle et la position des briques
+        world.setBounds(gameBoundX, gameBoundY);
     }
 };
 
 //-----------------------------------------------------------------------------
 // Main Function
 //-----------------------------------------------------------------------------
-int main() {
+int main(int argc, char **argv) {
     try {
-        Game breakoutGame(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE);
+        const RuntimeOptions options = parseRuntimeOptions(argc, argv);
+        if (options.benchSerialize) {
+            runSerializationBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.generateCount > 0) {
+            runLevelGenerator(options);
+            return EXIT_SUCCESS;
+        }
+        if (options.balance) {
+            runBalanceSweep(options);
+            return EXIT_SUCCESS;
+        }
+        if (options.benchBroadcast) {
+            runBroadcastBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.benchSync) {
+            runSyncBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.benchScores) {
+            runScoreBenchmark(options);
+            return EXIT_SUCCESS;
+        }
+        if (options.benchRender) {
+            runRenderBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.benchBricks) {
+            runBrickLayoutBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.benchRewind) {
+            runRewindBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.benchEvents) {
+            runEventStreamBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (!options.makeReplayPath.empty()) {
+            runMakeReplay(options);
+            return EXIT_SUCCESS;
+        }
+        if (!options.verifyReplayPath.empty()) {
+            return runVerifyReplay(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (options.checkDeterminism) {
+            return runDeterminismCheck(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (options.serverPort > 0) {
+            runMatchServer(options);
+            return EXIT_SUCCESS;
+        }
+        if (options.loadClients > 0) {
+            runLoadGenerator(options);
+            return EXIT_SUCCESS;
+        }
+        Game breakoutGame(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, options);
         breakoutGame.run();
     } catch (const std::exception &e) {
         std::cerr << "Error: " << e.what() << std::endl;
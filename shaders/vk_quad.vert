@@ -0,0 +1,19 @@
+#version 450
+// Quad instancié du rendu Vulkan : 4 sommets en bande, coins tirés de gl_VertexIndex
+
+layout(location = 0) in vec4 rect;  // x0, y0, x1, y1 (coordonnées monde)
+layout(location = 1) in vec4 color; // RGBA8 normalisé
+
+layout(push_constant) uniform Projection {
+    vec2 scale;  // Monde -> NDC (Y inversé)
+    vec2 offset;
+} projection;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 world = mix(rect.xy, rect.zw, corner);
+    gl_Position = vec4(world * projection.scale + projection.offset, 0.0, 1.0);
+    fragColor = color;
+}